@@ -496,6 +496,7 @@ void ConnRef::freeRoutes(void)
 {
     m_route.clear();
     m_display_route.clear();
+    m_router->spatialIndex.removeRoute(this);
 }
     
 
@@ -772,7 +773,48 @@ bool validateBendPoint(VertInf *aInf, VertInf *bInf, VertInf *cInf)
 }
 
 
+// Returns whether the path for this connector can be searched for without
+// modifying the visibility graph, and hence concurrently with the searches
+// for other connectors, by searchPathIsolated().
+bool ConnRef::canSearchPathIsolated(void) const
+{
+    if (!m_false_path && !m_needs_reroute_flag)
+    {
+        // Won't be rerouted.
+        return false;
+    }
+    if (!m_dst_vert || !m_src_vert)
+    {
+        return false;
+    }
+    // Pin connections modify the graph to give the endpoints visibility 
+    // to the pins, checkpoint paths are searched in several parts, and 
+    // rubber-band routing continues from the existing route.
+    bool dummySrc = m_src_connend && m_src_connend->isPinConnection();
+    bool dummyDst = m_dst_connend && m_dst_connend->isPinConnection();
+    return !dummySrc && !dummyDst && m_checkpoints.empty() &&
+            !m_router->RubberBandRouting;
+}
+
+
+void ConnRef::searchPathIsolated(std::vector<VertInf *>& searchedPath,
+        AStarSearchContext& context)
+{
+    COLA_ASSERT(canSearchPathIsolated());
+    aStarPathIsolated(this, m_src_vert, m_dst_vert, searchedPath, context);
+}
+
+
 bool ConnRef::generatePath(void)
+{
+    return generatePath(NULL);
+}
+
+
+// Generates the path for the connector.  If searchedPath is given, it
+// is the result of an earlier call to searchPathIsolated() and is used 
+// rather than searching again.
+bool ConnRef::generatePath(const std::vector<VertInf *> *searchedPath)
 {
     if (!m_false_path && !m_needs_reroute_flag)
     {
@@ -813,7 +855,7 @@ bool ConnRef::generatePath(void)
     std::vector<VertInf *> vertices;
     if (m_checkpoints.empty())
     {
-        generateStandardPath(path, vertices);
+        generateStandardPath(path, vertices, searchedPath);
     }
     else
     {
@@ -874,6 +916,7 @@ bool ConnRef::generatePath(void)
     freeRoutes();
     PolyLine& output_route = m_route;
     output_route.ps = clippedPath;
+    m_router->spatialIndex.addRoute(this);
  
 #ifdef PATHDEBUG
     db_printf("Output route:\n");
@@ -961,7 +1004,8 @@ void ConnRef::generateCheckpointsPath(std::vector<Point>& path,
 
 
 void ConnRef::generateStandardPath(std::vector<Point>& path,
-        std::vector<VertInf *>& vertices)
+        std::vector<VertInf *>& vertices,
+        const std::vector<VertInf *> *searchedPath)
 {
     VertInf *tar = m_dst_vert;
     size_t existingPathStart = 0;
@@ -1000,7 +1044,21 @@ void ConnRef::generateStandardPath(std::vector<Point>& path,
     bool found = false;
     while (!found)
     {
-        aStarPath(this, src(), dst(), start());
+        if (searchedPath)
+        {
+            COLA_ASSERT(existingPathStart == 0);
+            // Use the path already found, setting up the pathNext 
+            // pointers as aStarPath() would have.
+            tar->pathNext = NULL;
+            for (size_t i = 1; i < searchedPath->size(); ++i)
+            {
+                (*searchedPath)[i]->pathNext = (*searchedPath)[i - 1];
+            }
+        }
+        else
+        {
+            aStarPath(this, src(), dst(), start());
+        }
         found = tar->pathLeadsBackTo(m_src_vert);
         if (!found)
         {
@@ -1504,6 +1562,104 @@ static bool posInlineWithConnEndSegs(const double pos, const size_t dim,
     return false;
 }
 
+
+// The bounding box of a single route segment, tagged with its route.
+struct RouteSegmentBox
+{
+    RouteSegmentBox(size_t route, const Point& a, const Point& b)
+        : route(route),
+          minX(std::min(a.x, b.x)),
+          minY(std::min(a.y, b.y)),
+          maxX(std::max(a.x, b.x)),
+          maxY(std::max(a.y, b.y))
+    {
+    }
+    bool touches(const RouteSegmentBox& rhs) const
+    {
+        return (minX <= rhs.maxX) && (rhs.minX <= maxX) &&
+                (minY <= rhs.maxY) && (rhs.minY <= maxY);
+    }
+
+    size_t route;
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+typedef std::vector<RouteSegmentBox> RouteSegmentBoxList;
+typedef std::map<std::pair<int, int>, std::vector<size_t> > SegmentGrid;
+
+
+void findPossiblyCrossingRoutes(const RouteList& routes,
+        RouteIndexPairList& pairs)
+{
+    pairs.clear();
+
+    RouteSegmentBoxList segments;
+    double totalExtent = 0;
+    for (size_t r = 0; r < routes.size(); ++r)
+    {
+        const Polygon& route = *(routes[r]);
+        for (size_t i = 1; i < route.size(); ++i)
+        {
+            segments.push_back(RouteSegmentBox(r, route.ps[i - 1], 
+                        route.ps[i]));
+            const RouteSegmentBox& box = segments.back();
+            totalExtent += std::max(box.maxX - box.minX, box.maxY - box.minY);
+        }
+    }
+    if (segments.empty())
+    {
+        return;
+    }
+
+    // Bucket the segments into a uniform grid sized to the average 
+    // segment, so only segments sharing a grid cell need be compared.
+    // Boxes are grown slightly so touching segments always share a cell.
+    double cellSize = std::max(totalExtent / segments.size(), 1.0);
+    const double eps = cellSize * 1e-9;
+    SegmentGrid grid;
+    for (size_t s = 0; s < segments.size(); ++s)
+    {
+        const RouteSegmentBox& box = segments[s];
+        int minCol = (int) floor((box.minX - eps) / cellSize);
+        int maxCol = (int) floor((box.maxX + eps) / cellSize);
+        int minRow = (int) floor((box.minY - eps) / cellSize);
+        int maxRow = (int) floor((box.maxY + eps) / cellSize);
+        for (int col = minCol; col <= maxCol; ++col)
+        {
+            for (int row = minRow; row <= maxRow; ++row)
+            {
+                grid[std::make_pair(col, row)].push_back(s);
+            }
+        }
+    }
+
+    std::set<RouteIndexPair> found;
+    for (SegmentGrid::iterator cell = grid.begin(); cell != grid.end(); 
+            ++cell)
+    {
+        const std::vector<size_t>& cellSegments = cell->second;
+        for (size_t i = 0; i < cellSegments.size(); ++i)
+        {
+            const RouteSegmentBox& iBox = segments[cellSegments[i]];
+            for (size_t j = i + 1; j < cellSegments.size(); ++j)
+            {
+                const RouteSegmentBox& jBox = segments[cellSegments[j]];
+                if ((iBox.route != jBox.route) && iBox.touches(jBox))
+                {
+                    found.insert(std::make_pair(
+                                std::min(iBox.route, jBox.route),
+                                std::max(iBox.route, jBox.route)));
+                }
+            }
+        }
+    }
+    pairs.assign(found.begin(), found.end());
+}
+
+
 ConnectorCrossings::ConnectorCrossings(Avoid::Polygon& poly, bool polyIsConn,
         Avoid::Polygon& conn, ConnRef *polyConnRef, ConnRef *connConnRef)
     : poly(poly),
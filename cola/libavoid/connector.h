@@ -43,6 +43,7 @@ class Router;
 class ConnRef;
 class JunctionRef;
 class ShapeRef;
+class AStarSearchContext;
 typedef std::list<ConnRef *> ConnRefList;
 
 
@@ -311,10 +312,15 @@ class ConnRef
         void freeRoutes(void);
         void performCallback(void);
         bool generatePath(void);
+        bool generatePath(const std::vector<VertInf *> *searchedPath);
+        bool canSearchPathIsolated(void) const;
+        void searchPathIsolated(std::vector<VertInf *>& searchedPath,
+                AStarSearchContext& context);
         void generateCheckpointsPath(std::vector<Point>& path,
                 std::vector<VertInf *>& vertices);
         void generateStandardPath(std::vector<Point>& path,
-                std::vector<VertInf *>& vertices);
+                std::vector<VertInf *>& vertices,
+                const std::vector<VertInf *> *searchedPath);
         void unInitialise(void);
         void updateEndPoint(const unsigned int type, const ConnEnd& connEnd);
         void common_updateEndPoint(const unsigned int type, ConnEnd connEnd);
@@ -418,6 +424,18 @@ class ConnectorCrossings
 
 extern void splitBranchingSegments(Avoid::Polygon& poly, bool polyIsConn,
         Avoid::Polygon& conn, const double tolerance = 0);
+
+typedef std::vector<Avoid::Polygon *> RouteList;
+typedef std::pair<size_t, size_t> RouteIndexPair;
+typedef std::vector<RouteIndexPair> RouteIndexPairList;
+
+// Finds the pairs of routes that come close enough to one another that 
+// they may cross or share part of their path, i.e., those where a segment
+// of one route has a bounding box touching that of a segment of the other.
+// All other pairs can be skipped when counting crossings.  Pairs are given
+// as indexes into routes, lower index first, in increasing order.
+extern void findPossiblyCrossingRoutes(const RouteList& routes,
+        RouteIndexPairList& pairs);
 extern bool validateBendPoint(VertInf *aInf, VertInf *bInf, VertInf *cInf);
 
 }
@@ -32,7 +32,9 @@
 #include "libavoid/timer.h"
 #include "libavoid/vertices.h"
 #include "libavoid/router.h"
+#include "libavoid/obstacle.h"
 #include "libavoid/assertions.h"
+#include "libavoid/pool.h"
 
 
 using std::pair;
@@ -72,6 +74,30 @@ EdgeInf::~EdgeInf()
 }
 
 
+void *EdgeInf::operator new(size_t size, MemoryPool& pool)
+{
+    return allocatePooledObject(size, &pool);
+}
+
+
+void *EdgeInf::operator new(size_t size)
+{
+    return allocatePooledObject(size, NULL);
+}
+
+
+void EdgeInf::operator delete(void *ptr, MemoryPool&)
+{
+    freePooledObject(ptr);
+}
+
+
+void EdgeInf::operator delete(void *ptr)
+{
+    freePooledObject(ptr);
+}
+
+
 // Gives an order value between 0 and 3 for the point c, given the last
 // segment was from a to b.  Returns the following value:
 //    0 : Point c is directly backwards from point b.
@@ -189,12 +215,15 @@ void EdgeInf::makeActive(void)
         m_vert1->orthogVisListSize++;
         m_pos2 = m_vert2->orthogVisList.insert(m_vert2->orthogVisList.begin(), this);
         m_vert2->orthogVisListSize++;
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert1);
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert2);
     }
     else
     {
         if (m_visible)
         {
             m_router->visGraph.addEdge(this);
+            m_router->spatialIndex.addEdge(this);
             m_pos1 = m_vert1->visList.insert(m_vert1->visList.begin(), this);
             m_vert1->visListSize++;
             m_pos2 = m_vert2->visList.insert(m_vert2->visList.begin(), this);
@@ -225,12 +254,15 @@ void EdgeInf::makeInactive(void)
         m_vert1->orthogVisListSize--;
         m_vert2->orthogVisList.erase(m_pos2);
         m_vert2->orthogVisListSize--;
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert1);
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert2);
     }
     else
     {
         if (m_visible)
         {
             m_router->visGraph.removeEdge(this);
+            m_router->spatialIndex.removeEdge(this);
             m_vert1->visList.erase(m_pos1);
             m_vert1->visListSize--;
             m_vert2->visList.erase(m_pos2);
@@ -265,6 +297,11 @@ void EdgeInf::setDist(double dist)
         m_visible = true;
         makeActive();
     }
+    if (m_orthogonal && (m_dist != dist))
+    {
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert1);
+        m_router->visOrthogGraphSnapshot.invalidate(m_vert2);
+    }
     m_dist = dist;
     m_blocker = 0;
 }
@@ -494,45 +531,38 @@ int EdgeInf::firstBlocker(void)
         ss.insert(contains[jID].begin(), contains[jID].end());
     }
 
-    VertInf *last = m_router->vertices.end();
-    unsigned int lastId = 0;
-    bool seenIntersectionAtEndpoint = false;
-    for (VertInf *k = m_router->vertices.shapesBegin(); k != last; )
+    // Only obstacles near this edge can possibly block it.
+    ObstacleVector nearbyObstacles;
+    m_router->spatialIndex.obstaclesNearSegment(pti, ptj, nearbyObstacles);
+
+    for (ObstacleVector::iterator curr = nearbyObstacles.begin();
+            curr != nearbyObstacles.end(); ++curr)
     {
-        VertID kID = k->id;
-        if (k->id == dummyOrthogID)
+        Obstacle *obstacle = *curr;
+        unsigned int shapeID = obstacle->id();
+        if ((ss.find(shapeID) != ss.end()))
         {
-            // Don't include orthogonal dummy vertices.
-            k = k->lstNext;
+            db_printf("Endpoint is inside shape %u so ignore shape "
+                    "edges.\n", shapeID);
+            // One of the endpoints is inside this shape so ignore it.
             continue;
         }
-        if (kID.objID != lastId)
+
+        bool seenIntersectionAtEndpoint = false;
+        VertInf *k = obstacle->firstVert();
+        do
         {
-            if ((ss.find(kID.objID) != ss.end()))
+            Point& kPoint = k->point;
+            Point& kPrevPoint = k->shPrev->point;
+            if (segmentShapeIntersect(pti, ptj, kPrevPoint, kPoint, 
+                        seenIntersectionAtEndpoint))
             {
-                unsigned int shapeID = kID.objID;
-                db_printf("Endpoint is inside shape %u so ignore shape "
-                        "edges.\n", kID.objID);
-                // One of the endpoints is inside this shape so ignore it.
-                while ((k != last) && (k->id.objID == shapeID))
-                {
-                    // And skip the other vertices from this shape.
-                    k = k->lstNext;
-                }
-                continue;
+                ss.clear();
+                return shapeID;
             }
-            seenIntersectionAtEndpoint = false;
-            lastId = kID.objID;
-        }
-        Point& kPoint = k->point;
-        Point& kPrevPoint = k->shPrev->point;
-        if (segmentShapeIntersect(pti, ptj, kPrevPoint, kPoint, 
-                    seenIntersectionAtEndpoint))
-        {
-            ss.clear();
-            return kID.objID;
+            k = k->shNext;
         }
-        k = k->lstNext;
+        while (k != obstacle->firstVert());
     }
     ss.clear();
     return 0;
@@ -661,6 +691,221 @@ EdgeInf *EdgeInf::existingEdge(VertInf *i, VertInf *j)
 //===========================================================================
 
 
+// Returns the direction of b from a, or ConnDirNone if they are not
+// axis-aligned or are the same point.
+static inline ConnDirFlags orthogDirection(const Point& a, const Point& b)
+{
+    if (a.x == b.x)
+    {
+        if (b.y < a.y)
+        {
+            return ConnDirUp;
+        }
+        else if (b.y > a.y)
+        {
+            return ConnDirDown;
+        }
+    }
+    else if (a.y == b.y)
+    {
+        return (b.x < a.x) ? ConnDirLeft : ConnDirRight;
+    }
+    return ConnDirNone;
+}
+
+
+static inline ConnDirFlags reverseDirection(const ConnDirFlags direction)
+{
+    switch (direction)
+    {
+        case ConnDirUp:
+            return ConnDirDown;
+        case ConnDirDown:
+            return ConnDirUp;
+        case ConnDirLeft:
+            return ConnDirRight;
+        case ConnDirRight:
+            return ConnDirLeft;
+    }
+    return ConnDirNone;
+}
+
+
+static inline void directionVector(const ConnDirFlags direction, int& x, 
+        int& y)
+{
+    x = (direction == ConnDirLeft) ? -1 : (direction == ConnDirRight) ? 1 : 0;
+    y = (direction == ConnDirUp) ? -1 : (direction == ConnDirDown) ? 1 : 0;
+}
+
+
+// Gives the same value as orthogTurnOrder() for a turn from travelling in
+// direction a to travelling in direction b.
+static inline int orthogTurnOrder(const ConnDirFlags a, const ConnDirFlags b)
+{
+    int ax, ay, bx, by;
+    directionVector(a, ax, ay);
+    directionVector(b, bx, by);
+
+    int direction = (ax * by) - (bx * ay);
+    if (direction > 0)
+    {
+        return 1;
+    }
+    else if (direction < 0)
+    {
+        return 2;
+    }
+    return ((ax == -bx) && (ay == -by)) ? 0 : 3;
+}
+
+
+VisNeighbour::VisNeighbour()
+    : edge(NULL),
+      vert(NULL),
+      dist(0),
+      direction(ConnDirNone),
+      orthogonal(false),
+      dummyConnection(false),
+      exploreOrder(0)
+{
+}
+
+
+VisNeighbour::VisNeighbour(EdgeInf *edge, const VertInf *from)
+    : edge(edge),
+      vert(edge->otherVert(from)),
+      dist(edge->getDist()),
+      direction(orthogDirection(from->point, vert->point)),
+      orthogonal(edge->isOrthogonal()),
+      dummyConnection(edge->isDummyConnection()),
+      exploreOrder(0)
+{
+}
+
+
+OrthogExploreOrder::OrthogExploreOrder(const VertInf *last, 
+        const VertInf *common)
+    : m_last_pt((last) ? last->point : 
+            Point(common->point.x - 10, common->point.y)),
+      m_common_pt(common->point),
+      m_direction(orthogDirection(m_last_pt, m_common_pt))
+{
+}
+
+
+int OrthogExploreOrder::operator()(const VisNeighbour& next) const
+{
+    if ((m_direction != ConnDirNone) && (next.direction != ConnDirNone))
+    {
+        return orthogTurnOrder(m_direction, next.direction);
+    }
+    return orthogTurnOrder(m_last_pt, m_common_pt, next.vert->point);
+}
+
+
+//===========================================================================
+
+
+OrthogVisGraphSnapshot::OrthogVisGraphSnapshot()
+    : m_stamp(0)
+{
+}
+
+
+void OrthogVisGraphSnapshot::build(VertInfList& vertices, EdgeList& edges)
+{
+    clear();
+
+    const unsigned int indexLimit = vertices.searchIndexLimit();
+    m_vertices.resize(indexLimit, NULL);
+    m_stamps.resize(indexLimit, 0);
+    m_first.resize(indexLimit, 0);
+    m_last.resize(indexLimit, 0);
+    size_t total = 0;
+    for (VertInf *curr = vertices.connsBegin(); curr != vertices.end();
+            curr = curr->lstNext)
+    {
+        const unsigned int index = curr->searchIndex;
+        m_vertices[index] = curr;
+        m_stamps[index] = curr->orthogVisListStamp;
+        m_first[index] = total;
+        total += curr->orthogVisListSize;
+        m_last[index] = total;
+    }
+    m_neighbours.resize(total);
+
+    // Edges are added to the back of the graph's EdgeList and the front of
+    // each vertex's orthogVisList, so the neighbours of each vertex are
+    // filled from the back while walking the EdgeList.  This visits each 
+    // edge once, in the order they were allocated, rather than following 
+    // the list at every vertex.
+    std::vector<size_t> next(m_last);
+    for (EdgeInf *edge = edges.begin(); edge != edges.end(); 
+            edge = edge->lstNext)
+    {
+        VisNeighbour neighbour(edge, edge->m_vert1);
+        addNeighbour(edge->m_vert1, neighbour, next);
+
+        neighbour.vert = edge->m_vert1;
+        neighbour.direction = reverseDirection(neighbour.direction);
+        addNeighbour(edge->m_vert2, neighbour, next);
+    }
+#ifndef NDEBUG
+    for (unsigned int i = 0; i < indexLimit; ++i)
+    {
+        COLA_ASSERT(next[i] == m_first[i]);
+    }
+#endif
+}
+
+
+void OrthogVisGraphSnapshot::addNeighbour(const VertInf *vert, 
+        const VisNeighbour& neighbour, std::vector<size_t>& next)
+{
+    const unsigned int index = vert->searchIndex;
+    if (m_vertices[index] == vert)
+    {
+        COLA_ASSERT(next[index] > m_first[index]);
+        m_neighbours[--next[index]] = neighbour;
+    }
+}
+
+
+void OrthogVisGraphSnapshot::clear(void)
+{
+    m_neighbours.clear();
+    m_first.clear();
+    m_last.clear();
+    m_vertices.clear();
+    m_stamps.clear();
+}
+
+
+bool OrthogVisGraphSnapshot::copyNeighbours(const VertInf *vert,
+        VisNeighbourList& neighbours) const
+{
+    const unsigned int index = vert->searchIndex;
+    if ((index >= m_vertices.size()) || (m_vertices[index] != vert) ||
+            (m_stamps[index] != vert->orthogVisListStamp))
+    {
+        return false;
+    }
+    neighbours.assign(m_neighbours.begin() + m_first[index],
+            m_neighbours.begin() + m_last[index]);
+    return true;
+}
+
+
+void OrthogVisGraphSnapshot::invalidate(VertInf *vert)
+{
+    vert->orthogVisListStamp = ++m_stamp;
+}
+
+
+//===========================================================================
+
+
 EdgeList::EdgeList(bool orthogonal)
     : m_orthogonal(orthogonal),
       m_first_edge(NULL),
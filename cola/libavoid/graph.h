@@ -30,6 +30,7 @@
 #include <cassert>
 #include <list>
 #include <utility>
+#include <vector>
 #include "libavoid/vertices.h"
 
 namespace Avoid {
@@ -37,6 +38,8 @@ namespace Avoid {
 
 class ConnRef;
 class Router;
+class MemoryPool;
+class EdgeList;
 
 
 typedef std::list<int> ShapeList;
@@ -48,6 +51,12 @@ class EdgeInf
     public:
         EdgeInf(VertInf *v1, VertInf *v2, const bool orthogonal = false);
         ~EdgeInf();
+        // EdgeInfs may be allocated from one of the router's pools, with
+        // new (pool) EdgeInf(...).  They are deleted as usual.
+        static void *operator new(size_t size, MemoryPool& pool);
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, MemoryPool& pool);
+        static void operator delete(void *ptr);
         inline double getDist(void)
         {
             return m_dist;
@@ -77,6 +86,8 @@ class EdgeInf
         EdgeInf *lstNext;
     private:
         friend class MinimumTerminalSpanningTree;
+        friend class SpatialIndex;
+        friend class OrthogVisGraphSnapshot;
 
         void makeActive(void);
         void makeInactive(void);
@@ -95,6 +106,88 @@ class EdgeInf
         FlagList  m_conns;
         double  m_dist;
         double  m_mtst_dist;
+        std::pair<Point, Point> m_index_points;
+};
+
+
+// A neighbour of a vertex in a visibility graph, along with the details
+// of the connecting edge needed by path searches.
+//
+class VisNeighbour
+{
+    public:
+        VisNeighbour();
+        VisNeighbour(EdgeInf *edge, const VertInf *from);
+
+        EdgeInf *edge;
+        VertInf *vert;
+        double dist;
+        // The direction of vert from the vertex, or ConnDirNone if the 
+        // edge is not axis-aligned or has zero length.
+        ConnDirFlags direction;
+        bool orthogonal;
+        bool dummyConnection;
+        // Working value used to sort neighbours during path searches.
+        short exploreOrder;
+};
+
+typedef std::vector<VisNeighbour> VisNeighbourList;
+
+
+// Gives the order in which to explore the orthogonal neighbours of a
+// vertex, given the vertex the search arrived from: straight ahead, 
+// then left, then right, then back (see orthogTurnOrder() in graph.cpp).
+// If there is no previous vertex, the search is taken to have arrived
+// travelling to the right.
+//
+class OrthogExploreOrder
+{
+    public:
+        OrthogExploreOrder(const VertInf *last, const VertInf *common);
+        int operator()(const VisNeighbour& next) const;
+    private:
+        Point m_last_pt;
+        const Point& m_common_pt;
+        ConnDirFlags m_direction;
+};
+
+
+// A compacted, read-only copy of the orthogonal visibility graph, made 
+// once the graph has been generated.  The neighbours of each vertex are 
+// stored contiguously and indexed by VertInf::searchIndex, so the path
+// search can read them without walking the orthogVisList.  Vertices whose
+// edges change after the copy is made, e.g., when connection pin edges 
+// are added, are given a new stamp and are then treated as not being in 
+// the copy.
+//
+class OrthogVisGraphSnapshot
+{
+    public:
+        OrthogVisGraphSnapshot();
+        
+        // Makes the copy from the given graph, whose vertices are those 
+        // in the router's vertex list.
+        void build(VertInfList& vertices, EdgeList& edges);
+        void clear(void);
+        // Copies the neighbours of vert into neighbours, returning false
+        // if vert's current edges are not in the snapshot.
+        bool copyNeighbours(const VertInf *vert, 
+                VisNeighbourList& neighbours) const;
+        // Called when the orthogonal edges of vert change.
+        void invalidate(VertInf *vert);
+
+    private:
+        void addNeighbour(const VertInf *vert, const VisNeighbour& neighbour,
+                std::vector<size_t>& next);
+
+        VisNeighbourList m_neighbours;
+        // The neighbours of the vertex with search index i are stored in
+        // m_neighbours from m_first[i] up to m_last[i].
+        std::vector<size_t> m_first;
+        std::vector<size_t> m_last;
+        std::vector<const VertInf *> m_vertices;
+        std::vector<unsigned long> m_stamps;
+        unsigned long m_stamp;
 };
 
 
@@ -39,6 +39,7 @@
 #include "libavoid/graph.h"
 #include "libavoid/debug.h"
 #include "libavoid/timer.h"
+#include "libavoid/statistics.h"
 #include "libavoid/vertices.h"
 #include "libavoid/visibility.h"
 #include "libavoid/router.h"
@@ -25,7 +25,10 @@
 
 #include <algorithm>
 #include <vector>
+#include <list>
+#include <map>
 #include <climits>
+#include <cfloat>
 
 // For M_PI:
 #define _USE_MATH_DEFINES
@@ -45,39 +48,6 @@
 
 namespace Avoid {
 
-class ANode
-{
-    public:
-        VertInf* inf;
-        double g;        // Gone
-        double h;        // Heuristic
-        double f;        // Formula f = g + h
-        
-        int prevIndex;   // Index into DONE for the previous ANode.
-        int timeStamp;   // Timestamp used to determine explaration order of
-                         // seemingly equal paths during orthogonal routing.
-
-        ANode(VertInf *vinf, int time)
-            : inf(vinf),
-              g(0),
-              h(0),
-              f(0),
-              prevIndex(-1),
-              timeStamp(time)
-        {
-        }
-        ANode()
-            : inf(NULL),
-              g(0),
-              h(0),
-              f(0),
-              prevIndex(-1),
-              timeStamp(-1)
-        {
-        }
-};
-
-
 // This returns the opposite result (>) so that when used with stl::make_heap, 
 // the head node of the heap will be the smallest value, rather than the 
 // largest.  This saves us from having to sort the heap (and then reorder
@@ -303,12 +273,17 @@ static double cost(ConnRef *lineRef, const double dist, VertInf *inf2,
             router->routingPenalty(fixedSharedPathPenalty);
     if ((shared_path_penalty > 0) || (crossing_penalty > 0))
     {
-        if (connRoute.empty())
+        // Only connectors with part of their route near the new segment
+        // inf2--inf3 can cross it or share a path with it.
+        ConnRefVector nearbyConns;
+        router->spatialIndex.connectorsNearSegment(inf2->point, 
+                inf3->point, nearbyConns);
+        if (!nearbyConns.empty() && connRoute.empty())
         {
             constructPolygonPath(connRoute, inf2, inf3, done, inf1Index);
         }
-        ConnRefList::const_iterator curr, finish = router->connRefs.end();
-        for (curr = router->connRefs.begin(); curr != finish; ++curr)
+        for (ConnRefVector::const_iterator curr = nearbyConns.begin(); 
+                curr != nearbyConns.end(); ++curr)
         {
             ConnRef *connRef = *curr;
 
@@ -351,9 +326,13 @@ static double estimatedCost(ConnRef *lineRef, const Point *last,
     }
     else // Orthogonal
     {
-        // XXX: This currently just takes into account the compulsory
-        //      bend but will have to be updated when port direction 
-        //      information is available.
+        // Counts the fewest bends a path in free space needs, given the
+        // direction of the previous segment.  cost() charges at least the
+        // segment penalty for each bend, and two for doubling back, so
+        // the estimate stays consistent.  The target's visibility
+        // directions are not used: the orthogonal visibility graph can
+        // still reach a connection point from its other sides, so a
+        // bound that assumed otherwise would overestimate.
         int num_penalties = 0;
         double xmove = b.x - a.x;
         double ymove = b.y - a.y;
@@ -397,25 +376,19 @@ double estimatedCost(ConnRef *lineRef)
 }
 
 
-class CmpVisEdgeRotation 
+class CmpVisNeighbourRotation 
 {
     public:
-        CmpVisEdgeRotation(const VertInf* lastPt)
-            : _lastPt(lastPt)
-        {
-        }
-        bool operator() (const EdgeInf* u, const EdgeInf* v) const 
+        bool operator() (const VisNeighbour& u, const VisNeighbour& v) const 
         {
             // Dummy ShapeConnectionPin edges are not orthogonal and 
             // therefore can't be compared in the same way.
-            if (u->isOrthogonal() && v->isOrthogonal())
+            if (u.orthogonal && v.orthogonal)
             {
-                return u->rotationLessThan(_lastPt, v);
+                return u.exploreOrder < v.exploreOrder;
             }
-            return u < v;
+            return u.edge < v.edge;
         }
-    private:
-        const VertInf *_lastPt;
 };
 
 
@@ -433,6 +406,540 @@ static inline bool pointAlignedWithOneOf(const Point& point,
 }
 
 
+// Fills context.exploreNeighbours with the neighbours of inf, in the 
+// order they should be explored.  For orthogonal routing these are read
+// from the router's compact copy of the graph, unless this vertex's edges
+// have since changed.
+//
+static void findExploreNeighbours(Router *router, const bool isOrthogonal,
+        VertInf *inf, VertInf *prevInf, AStarSearchContext& context)
+{
+    VisNeighbourList& exploreNeighbours = context.exploreNeighbours;
+    if (!isOrthogonal || !router->visOrthogGraphSnapshot.copyNeighbours(
+                inf, exploreNeighbours))
+    {
+        const EdgeInfList& visList = (!isOrthogonal) ?
+                inf->visList : inf->orthogVisList;
+        exploreNeighbours.clear();
+        EdgeInfList::const_iterator finish = visList.end();
+        for (EdgeInfList::const_iterator edge = visList.begin(); 
+                edge != finish; ++edge)
+        {
+            exploreNeighbours.push_back(VisNeighbour(*edge, inf));
+        }
+    }
+    context.edgesRelaxed += exploreNeighbours.size();
+    if (isOrthogonal && (exploreNeighbours.size() > 1))
+    {
+        // We would like to explore in a structured way, so sort the 
+        // (copy of the) neighbours.
+        OrthogExploreOrder exploreOrder(prevInf, inf);
+        size_t orthogonalCount = 0;
+        for (size_t i = 0; i < exploreNeighbours.size(); ++i)
+        {
+            orthogonalCount += (exploreNeighbours[i].orthogonal) ? 1 : 0;
+        }
+        if (orthogonalCount > 1)
+        {
+            for (size_t i = 0; i < exploreNeighbours.size(); ++i)
+            {
+                VisNeighbour& neighbour = exploreNeighbours[i];
+                if (neighbour.orthogonal)
+                {
+                    neighbour.exploreOrder = exploreOrder(neighbour);
+                }
+            }
+        }
+        std::stable_sort(exploreNeighbours.begin(), 
+                exploreNeighbours.end(), CmpVisNeighbourRotation());
+    }
+}
+
+
+// Orthogonal routing optimisation.  Returns whether the edge from bestInf 
+// to nextInf can be skipped because it turns without leading to a shape
+// edge or being in line with one of the possible endpoints.  Turns are 
+// allowed if we haven't yet turned from the source point, since it may 
+// be a free-floating endpoint with directional visibility.  aligned(p, dim)
+// returns whether p[dim] is in line with one of the endpoints.
+//
+template <typename AlignedWithEndPoint>
+static bool orthogonalTurnIsUnneeded(const VertInf *prevInf, 
+        const VertInf *bestInf, const VertInf *nextInf, 
+        const Point& srcPoint, const AlignedWithEndPoint& aligned)
+{
+    const Point& bestPt = bestInf->point;
+    const Point& nextPt = nextInf->point;
+    const unsigned int flags = bestInf->orthogVisPropFlags;
+
+    bool notInlineX = prevInf && (prevInf->point.x != bestPt.x);
+    bool notInlineY = prevInf && (prevInf->point.y != bestPt.y);
+    if ((bestPt.x == nextPt.x) && notInlineX &&
+            (bestPt[YDIM] != srcPoint[YDIM]))
+    {
+        if (nextPt.y < bestPt.y)
+        {
+            if (!(flags & YL_EDGE) && !aligned(bestPt, XDIM))
+            {
+                return true;
+            }
+        }
+        else if (nextPt.y > bestPt.y)
+        {
+            if (!(flags & YH_EDGE) && !aligned(bestPt, XDIM))
+            {
+                return true;
+            }
+        }
+    }
+    if ((bestPt.y == nextPt.y) && notInlineY && 
+            (bestPt[XDIM] != srcPoint[XDIM]))
+    {
+        if (nextPt.x < bestPt.x)
+        {
+            if (!(flags & XL_EDGE) && !aligned(bestPt, YDIM))
+            {
+                return true;
+            }
+        }
+        else if (nextPt.x > bestPt.x)
+        {
+            if (!(flags & XH_EDGE) && !aligned(bestPt, YDIM))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+// Checks alignment against a list of endpoints.
+class AlignedWithOneOf
+{
+    public:
+        AlignedWithOneOf(const std::vector<Point>& points)
+            : m_points(points)
+        {
+        }
+        bool operator()(const Point& point, const size_t dim) const
+        {
+            return pointAlignedWithOneOf(point, m_points, dim);
+        }
+    private:
+        const std::vector<Point>& m_points;
+};
+
+
+// Checks alignment against sorted lists of the endpoint coordinates, for
+// searches with many endpoints.
+class AlignedWithSortedCoords
+{
+    public:
+        AlignedWithSortedCoords(const std::vector<double>& xs,
+                const std::vector<double>& ys)
+        {
+            m_coords[XDIM] = &xs;
+            m_coords[YDIM] = &ys;
+        }
+        bool operator()(const Point& point, const size_t dim) const
+        {
+            return std::binary_search(m_coords[dim]->begin(), 
+                    m_coords[dim]->end(), point[dim]);
+        }
+    private:
+        const std::vector<double> *m_coords[2];
+};
+
+
+// Returns whether a search for a path to tar may step from the vertex 
+// from to the vertex to, which it may not if to is a connection pin or
+// connector endpoint that isn't part of the path.
+//
+static bool stepIsSearchable(ConnRef *lineRef, const VertInf *from,
+        VertInf *to, const VertInf *tar, const bool isOrthogonal)
+{
+    if (to->id.isConnectionPin())
+    {
+        if ( !( (from == lineRef->src()) &&
+                lineRef->src()->id.isDummyPinHelper()
+              ) &&
+             !( to->hasNeighbour(lineRef->dst(), isOrthogonal) &&
+                lineRef->dst()->id.isDummyPinHelper())
+              )
+        {
+            // Don't check connection pins if they don't have the 
+            // target vertex as a direct neightbour, or are directly
+            // leaving the source vertex.
+            return false;
+        }
+    }
+    else if (to->id.isConnPt())
+    {
+        if ((to != tar))
+        {
+            // Don't check connector endpoints vertices unless they
+            // are the target endpoint.
+            return false;
+        }
+    }
+    return true;
+}
+
+
+AStarSearchContext::AStarSearchContext()
+    : nodesExpanded(0),
+      edgesRelaxed(0),
+      m_epoch(0),
+      m_reverse_context(NULL)
+{
+}
+
+
+AStarSearchContext::~AStarSearchContext()
+{
+    delete m_reverse_context;
+}
+
+
+AStarSearchContext& AStarSearchContext::reverseContext(void)
+{
+    if (m_reverse_context == NULL)
+    {
+        m_reverse_context = new AStarSearchContext();
+    }
+    return *m_reverse_context;
+}
+
+
+void AStarSearchContext::reset(const unsigned int vertexCount)
+{
+    pending.clear();
+    done.clear();
+    exploreNeighbours.clear();
+    endPoints.clear();
+    states.clear();
+
+    if (m_vertex_epoch.size() < vertexCount)
+    {
+        m_vertex_epoch.resize(vertexCount, 0);
+        m_vertex_state_head.resize(vertexCount, -1);
+    }
+    ++m_epoch;
+    if (m_epoch == 0)
+    {
+        // The epoch has wrapped around, so old stamps could match it.
+        std::fill(m_vertex_epoch.begin(), m_vertex_epoch.end(), 0);
+        m_epoch = 1;
+    }
+}
+
+
+int AStarSearchContext::findStateIndex(const VertInf *vert, 
+        const VertInf *prev) const
+{
+    const unsigned int vertIndex = vert->searchIndex;
+    COLA_ASSERT(vertIndex < m_vertex_epoch.size());
+    if (m_vertex_epoch[vertIndex] != m_epoch)
+    {
+        return -1;
+    }
+    for (int index = m_vertex_state_head[vertIndex]; index >= 0; 
+            index = states[index].next)
+    {
+        if (states[index].prev == prev)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+
+int AStarSearchContext::stateIndex(VertInf *vert, const VertInf *prev)
+{
+    const unsigned int vertIndex = vert->searchIndex;
+    COLA_ASSERT(vertIndex < m_vertex_epoch.size());
+    if (m_vertex_epoch[vertIndex] != m_epoch)
+    {
+        m_vertex_epoch[vertIndex] = m_epoch;
+        m_vertex_state_head[vertIndex] = -1;
+    }
+    const int existing = findStateIndex(vert, prev);
+    if (existing >= 0)
+    {
+        return existing;
+    }
+    SearchState state;
+    state.prev = prev;
+    state.g = DBL_MAX;
+    state.closed = false;
+    state.parent = -1;
+    state.next = m_vertex_state_head[vertIndex];
+    states.push_back(state);
+    m_vertex_state_head[vertIndex] = (int) states.size() - 1;
+    return m_vertex_state_head[vertIndex];
+}
+
+
+// Returns whether node has been superseded by another ANode for the same
+// state that has already been moved to DONE.
+//
+static bool isSuperseded(const ANode& node, AStarSearchContext& context)
+{
+    VertInf *prevInf = (node.prevIndex >= 0) ?
+            context.done[node.prevIndex].inf : NULL;
+    return context.states[context.stateIndex(node.inf, prevInf)].closed;
+}
+
+
+// Returns the best path from src to tar, as aStarSearch() does, but by 
+// searching from both ends at once.  This is only done for orthogonal 
+// connectors, and only where the cost of a path is the sum of the cost of
+// each segment and of the bend at each vertex, which is the same whichever
+// way the path is followed (see connectorsCanShareSearch()).
+//
+// The forward search finds the paths from src, with states for reaching 
+// a vertex from the previous one, as aStarSearch() does.  The backward 
+// search finds the paths to tar, in the reverse context, with states for
+// reaching a vertex from the next one on the path.  It follows the steps 
+// the forward search could take in reverse, so the two explore the same 
+// paths.  Each time either search reaches a vertex b from a, it looks for
+// a state of the other search for reaching a from b.  The two paths that
+// share this segment give a complete path, whose cost is the two costs 
+// less the length of the shared segment.  The search stops once the 
+// lowest estimate on either side's PENDING is no lower than the best 
+// complete path, since the heuristic in each direction never 
+// overestimates.
+//
+static void bidirectionalSearch(ConnRef *lineRef, VertInf *src, 
+        VertInf *tar, std::vector<VertInf *> *isolatedPath,
+        AStarSearchContext& context)
+{
+    Router *router = lineRef->router();
+    const unsigned int vertexCount = router->vertices.searchIndexLimit();
+    AStarSearchContext& reverse = context.reverseContext();
+    context.reset(vertexCount);
+    reverse.reset(vertexCount);
+
+    std::vector<Point>& endPoints = context.endPoints;
+    endPoints = lineRef->possibleDstPinPoints();
+    endPoints.push_back(tar->point);
+    AlignedWithOneOf alignedWithEndPoint(endPoints);
+
+    if (isolatedPath)
+    {
+        isolatedPath->clear();
+    }
+    else
+    {
+        tar->pathNext = NULL;
+    }
+
+    // The forward search is side 0, heading for tar, and the backward
+    // search side 1, heading for src.
+    AStarSearchContext *sides[2] = { &context, &reverse };
+    VertInf *starts[2] = { src, tar };
+    VertInf *goals[2] = { tar, src };
+    int timestamp = 1;
+    for (int s = 0; s < 2; ++s)
+    {
+        ANode Node(starts[s], timestamp++);
+        Node.h = estimatedCost(lineRef, NULL, starts[s]->point, 
+                goals[s]->point);
+        Node.f = Node.h;
+        sides[s]->pending.push_back(Node);
+        sides[s]->states[sides[s]->stateIndex(starts[s], NULL)].g = 0;
+    }
+
+    // The cost of the best complete path found so far, and the indexes
+    // in each side's DONE of the ANodes its path is made up from.  An 
+    // index of -1 means the other side's path reaches that side's start.
+    double bestCost = DBL_MAX;
+    int bestIndexes[2] = { -1, -1 };
+
+    using std::push_heap; using std::pop_heap;
+    while (true)
+    {
+        // Drop superseded ANodes from the top of each side's PENDING, as
+        // aStarSearch() skips them.
+        for (int s = 0; s < 2; ++s)
+        {
+            std::vector<ANode>& PENDING = sides[s]->pending;
+            while (!PENDING.empty() && isSuperseded(PENDING.front(), 
+                        *sides[s]))
+            {
+                pop_heap(PENDING.begin(), PENDING.end());
+                PENDING.pop_back();
+            }
+        }
+        if (context.pending.empty() || reverse.pending.empty())
+        {
+            break;
+        }
+        // Expand whichever side has fewer nodes waiting.
+        const int s = (context.pending.size() <= reverse.pending.size()) ?
+                0 : 1;
+        AStarSearchContext& side = *sides[s];
+        AStarSearchContext& other = *sides[1 - s];
+        std::vector<ANode>& PENDING = side.pending;
+        std::vector<ANode>& DONE = side.done;
+
+        ANode BestNode = PENDING.front();
+        if (BestNode.f >= bestCost)
+        {
+            // No path through this side's PENDING nodes can be better.
+            break;
+        }
+        pop_heap(PENDING.begin(), PENDING.end());
+        PENDING.pop_back();
+
+        VertInf *prevInf = (BestNode.prevIndex >= 0) ?
+                DONE[BestNode.prevIndex].inf : NULL;
+        const int bestState = side.stateIndex(BestNode.inf, prevInf);
+        side.states[bestState].closed = true;
+        context.nodesExpanded++;
+        DONE.push_back(BestNode);
+        const int bestIndex = (int) DONE.size() - 1;
+
+        if (BestNode.inf == goals[s])
+        {
+            // Paths don't continue through the other end.
+            continue;
+        }
+
+        findExploreNeighbours(router, true, BestNode.inf, prevInf, side);
+        const VisNeighbourList& exploreNeighbours = side.exploreNeighbours;
+        // The backward search arrived along the next segment of the path,
+        // so it checks the turn onto that segment.
+        bool nextIsDummyConnection = false;
+        for (size_t i = 0; (s == 1) && (i < exploreNeighbours.size()); ++i)
+        {
+            if (exploreNeighbours[i].vert == prevInf)
+            {
+                nextIsDummyConnection = exploreNeighbours[i].dummyConnection;
+            }
+        }
+        VisNeighbourList::const_iterator finish = exploreNeighbours.end();
+        for (VisNeighbourList::const_iterator neighbour = 
+                exploreNeighbours.begin(); neighbour != finish; ++neighbour)
+        {
+            VertInf *nextInf = neighbour->vert;
+            if ((prevInf == nextInf) || (neighbour->dist == 0))
+            {
+                continue;
+            }
+            // Apply the rules aStarSearch() does for a step of the 
+            // forward path, following it backwards on the backward side.
+            if (s == 0)
+            {
+                if (!stepIsSearchable(lineRef, BestNode.inf, nextInf, tar,
+                            true) ||
+                        (!neighbour->dummyConnection && 
+                         orthogonalTurnIsUnneeded(prevInf, BestNode.inf, 
+                             nextInf, src->point, alignedWithEndPoint)))
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                if (!stepIsSearchable(lineRef, nextInf, BestNode.inf, tar,
+                            true) ||
+                        (prevInf && !nextIsDummyConnection &&
+                         orthogonalTurnIsUnneeded(nextInf, BestNode.inf, 
+                             prevInf, src->point, alignedWithEndPoint)))
+                {
+                    continue;
+                }
+            }
+
+            ANode Node(nextInf, timestamp++);
+            Node.prevIndex = bestIndex;
+            Node.g = BestNode.g + cost(lineRef, neighbour->dist, 
+                    BestNode.inf, nextInf, DONE, BestNode.prevIndex);
+            Node.h = estimatedCost(lineRef, &(BestNode.inf->point),
+                    nextInf->point, goals[s]->point);
+            Node.f = Node.g + Node.h;
+
+            AStarSearchContext::SearchState& state = side.states[
+                    side.stateIndex(nextInf, BestNode.inf)];
+            if (state.closed || (Node.g >= state.g))
+            {
+                continue;
+            }
+            state.g = Node.g;
+            state.parent = bestIndex;
+            PENDING.push_back(Node);
+            push_heap(PENDING.begin(), PENDING.end());
+
+            if (nextInf == goals[s])
+            {
+                if (Node.g < bestCost)
+                {
+                    bestCost = Node.g;
+                    bestIndexes[s] = bestIndex;
+                    bestIndexes[1 - s] = -1;
+                }
+                continue;
+            }
+            const int otherState = other.findStateIndex(BestNode.inf, 
+                    nextInf);
+            if ((otherState >= 0) && (other.states[otherState].g < DBL_MAX))
+            {
+                const AStarSearchContext::SearchState& meeting = 
+                        other.states[otherState];
+                const double pathCost = 
+                        Node.g + meeting.g - neighbour->dist;
+                if (pathCost < bestCost)
+                {
+                    bestCost = pathCost;
+                    bestIndexes[s] = bestIndex;
+                    bestIndexes[1 - s] = meeting.parent;
+                }
+            }
+        }
+    }
+    context.edgesRelaxed += reverse.edgesRelaxed;
+    reverse.edgesRelaxed = 0;
+
+    if (bestCost == DBL_MAX)
+    {
+        return;
+    }
+    std::vector<VertInf *> path;
+    for (int curr = bestIndexes[0]; curr >= 0; 
+            curr = context.done[curr].prevIndex)
+    {
+        path.push_back(context.done[curr].inf);
+    }
+    if (bestIndexes[0] < 0)
+    {
+        path.push_back(src);
+    }
+    std::reverse(path.begin(), path.end());
+    for (int curr = bestIndexes[1]; curr >= 0; 
+            curr = reverse.done[curr].prevIndex)
+    {
+        path.push_back(reverse.done[curr].inf);
+    }
+    if (bestIndexes[1] < 0)
+    {
+        path.push_back(tar);
+    }
+
+    if (isolatedPath)
+    {
+        isolatedPath->swap(path);
+        return;
+    }
+    for (size_t i = 1; i < path.size(); ++i)
+    {
+        path[i]->pathNext = path[i - 1];
+    }
+}
+
+
 // Returns the best path from src to tar using the cost function.
 //
 // The path is worked out using the aStar algorithm, and is encoded via
@@ -440,12 +947,30 @@ static inline bool pointAlignedWithOneOf(const Point& point,
 // position in the DONE vector.  At completion, this order is written into
 // the pathNext links in each of the VerInfs along the path.
 //
+// If isolatedPath is given, then the search doesn't modify any vertex or
+// edge state (not even the pathNext links), so several searches may be 
+// run at the same time, each with its own context.  The path is instead
+// returned in isolatedPath, from src to tar, or left empty if no path 
+// was found.  All working storage is held in the context.
+//
 // The aStar STL code is based on public domain code available on the
 // internet.
 //
-void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
+static void aStarSearch(ConnRef *lineRef, VertInf *src, VertInf *tar, 
+        VertInf *start, std::vector<VertInf *> *isolatedPath,
+        AStarSearchContext& context)
 {
     bool isOrthogonal = (lineRef->routingType() == ConnType_Orthogonal);
+    Router *router = lineRef->router();
+    if (isOrthogonal && 
+            router->routingOption(searchConnectorPathsBidirectionally) &&
+            !(router->RubberBandRouting && (start != NULL) && (start != src)) &&
+            connectorsCanShareSearch(router))
+    {
+        bidirectionalSearch(lineRef, src, tar, isolatedPath, context);
+        return;
+    }
+    context.reset(router->vertices.searchIndexLimit());
 
     double (*dist)(const Point& a, const Point& b) = 
         (isOrthogonal) ? manhattanDist : euclideanDist;
@@ -453,29 +978,36 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
     // We need to know the possible endpoints for doing an orthogonal 
     // routing optimisation where we only turn when we are heading beside
     // a shape or are in line with a possible endpoint.
-    std::vector<Point> endPoints;
+    std::vector<Point>& endPoints = context.endPoints;
     if (isOrthogonal)
     {
         endPoints = lineRef->possibleDstPinPoints();
     }
     endPoints.push_back(tar->point);
+    AlignedWithOneOf alignedWithEndPoint(endPoints);
     
-    std::vector<ANode> PENDING;     // STL Vectors chosen because of rapid
-    std::vector<ANode> DONE;        // insertions/deletions at back,
-    size_t DONE_size = 0;
+    std::vector<ANode>& PENDING = context.pending;  // STL Vectors chosen 
+    std::vector<ANode>& DONE = context.done;        // because of rapid
+    size_t DONE_size = 0;                           // insertions/deletions
+                                                    // at back.
     ANode Node, BestNode;           // Temporary Node and BestNode
     bool bNodeFound = false;        // Flag if node is found in container
     int timestamp = 1;
 
+    if (isolatedPath)
+    {
+        isolatedPath->clear();
+    }
+
     if (start == NULL)
     {
         start = src;
     }
 
-    Router *router = lineRef->router();
     if (router->RubberBandRouting && (start != src))
     {
         COLA_ASSERT(router->IgnoreRegions == true);
+        COLA_ASSERT(isolatedPath == NULL);
         
         const PolyLine& currRoute = lineRef->route();
         VertInf *last = NULL;
@@ -518,12 +1050,14 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
                 Node.prevIndex = DONE_size - 1;
             }
 
+            const int currState = context.stateIndex(curr, last);
+            context.states[currState].g = Node.g;
             if (curr != start)
             {
                 BestNode = Node;
 
                 DONE.push_back(BestNode);
-                BestNode.inf->aStarDoneIndexes.push_back(DONE_size);
+                context.states[currState].closed = true;
                 DONE_size++;
             }
             else
@@ -546,9 +1080,13 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
 
         // Populate the PENDING container with the first location
         PENDING.push_back(Node);
+        context.states[context.stateIndex(src, NULL)].g = Node.g;
     }
 
-    tar->pathNext = NULL;
+    if (!isolatedPath)
+    {
+        tar->pathNext = NULL;
+    }
 
     // Create a heap from PENDING for sorting
     using std::make_heap; using std::push_heap; using std::pop_heap;
@@ -570,13 +1108,21 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
         // Remove node from right (the value we pop_heap'd)
         PENDING.pop_back();
 
+        VertInf *prevInf = (BestNode.prevIndex >= 0) ?
+                DONE[BestNode.prevIndex].inf : NULL;
+        const int bestState = context.stateIndex(BestNode.inf, prevInf);
+        if (context.states[bestState].closed)
+        {
+            // This ANode was superseded by one of lower cost, which has
+            // already been moved to DONE.
+            continue;
+        }
+        context.states[bestState].closed = true;
+        context.nodesExpanded++;
+
         // Push the BestNode onto DONE
         DONE.push_back(BestNode);
-        BestNode.inf->aStarDoneIndexes.push_back(DONE_size);
         DONE_size++;
-
-        VertInf *prevInf = (BestNode.prevIndex >= 0) ?
-                DONE[BestNode.prevIndex].inf : NULL;
 #if 0
         db_printf("Considering... ");
         db_printf(" %g %g  ", BestNode.inf->point.x, BestNode.inf->point.y);
@@ -641,6 +1187,21 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
             db_printf("LINE %10d  Steps: %4d  Cost: %g\n", lineRef->id(), 
                     (int) DONE_size, BestNode.f);
 #endif
+
+            if (isolatedPath)
+            {
+                // Return the path, leaving the pathNext pointers alone.
+                for (ANode curr = BestNode; ; curr = DONE[curr.prevIndex])
+                {
+                    isolatedPath->push_back(curr.inf);
+                    if (curr.prevIndex < 0)
+                    {
+                        break;
+                    }
+                }
+                std::reverse(isolatedPath->begin(), isolatedPath->end());
+                break;
+            }
             
             // Correct all the pathNext pointers.
             ANode curr;
@@ -661,20 +1222,14 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
         }
 
         // Check adjacent points in graph and add them to the queue.
-        EdgeInfList& visList = (!isOrthogonal) ?
-                BestNode.inf->visList : BestNode.inf->orthogVisList;
-        if (isOrthogonal)
+        findExploreNeighbours(router, isOrthogonal, BestNode.inf, prevInf,
+                context);
+        const VisNeighbourList& exploreNeighbours = context.exploreNeighbours;
+        VisNeighbourList::const_iterator finish = exploreNeighbours.end();
+        for (VisNeighbourList::const_iterator neighbour = 
+                exploreNeighbours.begin(); neighbour != finish; ++neighbour)
         {
-            // We would like to explore in a structured way, 
-            // so sort the points in the visList...
-            CmpVisEdgeRotation compare(prevInf);
-            visList.sort(compare);
-        }
-        EdgeInfList::const_iterator finish = visList.end();
-        for (EdgeInfList::const_iterator edge = visList.begin(); 
-                edge != finish; ++edge)
-        {
-            Node = ANode((*edge)->otherVert(BestNode.inf), timestamp++);
+            Node = ANode(neighbour->vert, timestamp++);
 
             // Set the index to the previous ANode that we reached
             // this ANode through (the last BestNode pushed onto DONE).
@@ -689,86 +1244,22 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
                 continue;
             }
 
-            if (Node.inf->id.isConnectionPin())
+            if (!stepIsSearchable(lineRef, BestNode.inf, Node.inf, tar,
+                        isOrthogonal))
             {
-                if ( !( (BestNode.inf == lineRef->src()) &&
-                        lineRef->src()->id.isDummyPinHelper()
-                      ) &&
-                     !( Node.inf->hasNeighbour(lineRef->dst(), isOrthogonal) &&
-                        lineRef->dst()->id.isDummyPinHelper())
-                      )
-                {
-                    // Don't check connection pins if they don't have the 
-                    // target vertex as a direct neightbour, or are directly
-                    // leaving the source vertex.
-                    continue;
-                }
-            }
-            else if (Node.inf->id.isConnPt())
-            {
-                if ((Node.inf != tar))
-                {
-                    // Don't check connector endpoints vertices unless they
-                    // are the target endpoint.
-                    continue;
-                }
+                continue;
             }
 
-            if (isOrthogonal && !(*edge)->isDummyConnection())
+            if (isOrthogonal && !neighbour->dummyConnection &&
+                    orthogonalTurnIsUnneeded(prevInf, BestNode.inf, Node.inf,
+                        src->point, alignedWithEndPoint))
             {
-                // Orthogonal routing optimisation.
                 // Skip the edges that don't lead to shape edges, or the 
-                // connection point we are looking for.  Though allow them
-                // if we haven't yet turned from the source point, since it
-                // may be a free-floating endpoint with directional visibility.
-                Point& bestPt = BestNode.inf->point;
-                Point& nextPt = Node.inf->point;
-
-                bool notInlineX = prevInf && (prevInf->point.x != bestPt.x);
-                bool notInlineY = prevInf && (prevInf->point.y != bestPt.y);
-                if ((bestPt.x == nextPt.x) && notInlineX &&
-                        (bestPt[YDIM] != src->point[YDIM]))
-                {
-                    if (nextPt.y < bestPt.y)
-                    {
-                        if (!(BestNode.inf->orthogVisPropFlags & YL_EDGE) &&
-                                !pointAlignedWithOneOf(bestPt, endPoints, XDIM))
-                        {
-                            continue;
-                        }
-                    }
-                    else if (nextPt.y > bestPt.y)
-                    {
-                        if (!(BestNode.inf->orthogVisPropFlags & YH_EDGE) &&
-                                !pointAlignedWithOneOf(bestPt, endPoints, XDIM))
-                        {
-                            continue;
-                        }
-                    }
-                }
-                if ((bestPt.y == nextPt.y) && notInlineY && 
-                        (bestPt[XDIM] != src->point[XDIM]))
-                {
-                    if (nextPt.x < bestPt.x)
-                    {
-                        if (!(BestNode.inf->orthogVisPropFlags & XL_EDGE) &&
-                                !pointAlignedWithOneOf(bestPt, endPoints, YDIM))
-                        {
-                            continue;
-                        }
-                    }
-                    else if (nextPt.x > bestPt.x)
-                    {
-                        if (!(BestNode.inf->orthogVisPropFlags & XH_EDGE) &&
-                                !pointAlignedWithOneOf(bestPt, endPoints, YDIM))
-                        {
-                            continue;
-                        }
-                    }
-                }
+                // connection point we are looking for.
+                continue;
             }
 
-            double edgeDist = (*edge)->getDist();
+            double edgeDist = neighbour->dist;
 
             if (edgeDist == 0)
             {
@@ -803,52 +1294,18 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
             db_printf(" - g: %3.1f h: %3.1f \n", Node.g, Node.h);
 #endif
 
-            bNodeFound = false;
-
-            // Check to see if already on PENDING
-            size_t PENDING_size = PENDING.size();
-            for (unsigned int i = 0; i < PENDING_size; i++)
+            // Check whether there is already an ANode for this vertex and
+            // previous vertex, either on DONE or on PENDING with a lower 
+            // or equal cost, in which case this node need not be 
+            // considered.  Otherwise, any ANode for it on PENDING is 
+            // superseded by this one.
+            AStarSearchContext::SearchState& state = context.states[
+                    context.stateIndex(Node.inf, BestNode.inf)];
+            COLA_ASSERT(!state.closed || (Node.g >= (state.g - 10e-10)));
+            bNodeFound = state.closed || (Node.g >= state.g);
+            if (!bNodeFound)
             {
-                ANode& ati = PENDING[i];
-                if ((Node.inf == ati.inf) &&
-                        (DONE[Node.prevIndex].inf == DONE[ati.prevIndex].inf))
-                {
-                    // If already on PENDING
-                    if (Node.g < ati.g)
-                    {
-                        PENDING[i] = Node;
-
-                        make_heap( PENDING.begin(), PENDING.end() );
-                    }
-                    bNodeFound = true;
-                    break;
-                }
-            }
-            if ( !bNodeFound ) // If Node NOT found on PENDING
-            {
-                // Check to see if already on DONE.
-                // Rather than iterate through the complete DONE list, which
-                // may get very large in the worst case, we look at just the
-                // ANodes for this vertex.  This is cheaper for us even than
-                // using a hash map for DONE, especially since a good hash 
-                // function on the unique combination of vertex and previous 
-                // vertex is very difficult.
-                for (std::list<unsigned int>::const_iterator currInd = 
-                        Node.inf->aStarDoneIndexes.begin();
-                        currInd != Node.inf->aStarDoneIndexes.end(); ++currInd)
-                {
-                    ANode& ati = DONE[*currInd];
-                    if ((Node.inf == ati.inf) && 
-                            (DONE[Node.prevIndex].inf == DONE[ati.prevIndex].inf))
-                    {
-                        COLA_ASSERT(Node.g >= (ati.g - 10e-10));
-                        // This node is already in DONE, and the current 
-                        // node also has a higher g-value, so we don't
-                        // need to consider this node.
-                        bNodeFound = true;
-                        break;
-                    }
-                }
+                state.g = Node.g;
             }
 
             if (!bNodeFound ) // If Node NOT found on PENDING or DONE
@@ -879,14 +1336,463 @@ void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
             }
         }
     }
+}
+
+
+void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar, VertInf *start)
+{
+    aStarSearch(lineRef, src, tar, start, NULL, 
+            lineRef->router()->aStarContext);
+}
+
+
+void aStarPathIsolated(ConnRef *lineRef, VertInf *src, VertInf *tar,
+        std::vector<VertInf *>& path, AStarSearchContext& context)
+{
+    aStarSearch(lineRef, src, tar, src, &path, context);
+}
+
+
+// Returns the edges to other vertices from inf that a search would 
+// explore, as sorted (other vertex, distance) pairs.
+static void searchableEdges(VertInf *inf, const bool isOrthogonal,
+        std::vector<std::pair<VertInf *, double> >& edges)
+{
+    const EdgeInfList& visList = (isOrthogonal) ? 
+            inf->orthogVisList : inf->visList;
+    edges.clear();
+    for (EdgeInfList::const_iterator edge = visList.begin(); 
+            edge != visList.end(); ++edge)
+    {
+        const double dist = (*edge)->getDist();
+        if (dist != 0)
+        {
+            edges.push_back(std::make_pair((*edge)->otherVert(inf), dist));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+}
+
+
+bool equivalentSearchSources(ConnRef *lineRef1, ConnRef *lineRef2)
+{
+    VertInf *src1 = lineRef1->src();
+    VertInf *src2 = lineRef2->src();
+    if ((lineRef1->routingType() != lineRef2->routingType()) ||
+            (src1->point != src2->point) || 
+            (src1->visDirections != src2->visDirections) ||
+            (src1->orthogVisPropFlags != src2->orthogVisPropFlags))
+    {
+        return false;
+    }
+    // Edges of zero length, such as between the two source vertices, are
+    // never explored, so only the other edges need to match.
+    bool isOrthogonal = (lineRef1->routingType() == ConnType_Orthogonal);
+    std::vector<std::pair<VertInf *, double> > edges1, edges2;
+    searchableEdges(src1, isOrthogonal, edges1);
+    searchableEdges(src2, isOrthogonal, edges2);
+    return edges1 == edges2;
+}
+
+
+bool connectorsCanShareSearch(Router *router)
+{
+    // Only cluster crossings and, while rerouting to improve crossings, 
+    // connector crossings make the cost of a path depend on the connector.
+    return !router->_inCrossingPenaltyReroutingStage && 
+            !(router->ClusteredRouting && !router->clusterRefs.empty() &&
+              (router->routingPenalty(clusterCrossingPenalty) > 0));
+}
+
+
+// Orders vertices by one of their coordinates.
+class CmpVertInfCoord
+{
+    public:
+        CmpVertInfCoord(const size_t dim)
+            : m_dim(dim)
+        {
+        }
+        bool operator()(const VertInf *lhs, const VertInf *rhs) const
+        {
+            return lhs->point[m_dim] < rhs->point[m_dim];
+        }
+    private:
+        size_t m_dim;
+};
+
+
+// The targets of a search that haven't been reached yet, kept in a k-d 
+// tree so that the distance to the nearest of them can be found without 
+// looking at them all.  The tree is implicit in the order of m_targets: 
+// the target in the middle of each range splits the rest of the range in
+// one dimension, alternating dimensions at each level, and the bounds and
+// the number of unreached targets of each range are kept at the index of
+// its middle.  Reached targets stay in the tree, but are skipped.
+class UnreachedTargets
+{
+    public:
+        UnreachedTargets(const std::vector<VertInf *>& targets,
+                const bool isOrthogonal);
+        bool empty(void) const
+        {
+            return m_unreached[m_root] == 0;
+        }
+        void remove(VertInf *target);
+        // Returns the distance from a to the nearest unreached target.
+        // Unlike estimatedCost(), this doesn't count bends, which can 
+        // make an estimate drop by more than the cost of the segment that
+        // was added, and would then cause ANodes to be moved to DONE 
+        // before the lowest cost path to them is found.
+        double nearestDist(const Point& a) const;
+    private:
+        void build(const size_t begin, const size_t end, const size_t dim,
+                const size_t parent);
+        void findNearest(const Point& a, const size_t begin, 
+                const size_t end, const size_t dim, double& nearest) const;
+        double dist(const Point& a, const Point& b) const;
+
+        bool m_is_orthogonal;
+        std::vector<VertInf *> m_targets;
+        std::vector<std::pair<VertInf *, size_t> > m_positions;
+        std::vector<Point> m_min;
+        std::vector<Point> m_max;
+        std::vector<size_t> m_unreached;
+        std::vector<size_t> m_parent;
+        std::vector<bool> m_reached;
+        size_t m_root;
+};
+
+
+UnreachedTargets::UnreachedTargets(const std::vector<VertInf *>& targets,
+        const bool isOrthogonal)
+    : m_is_orthogonal(isOrthogonal),
+      m_targets(targets),
+      m_min(targets.size()),
+      m_max(targets.size()),
+      m_unreached(targets.size(), 0),
+      m_parent(targets.size(), targets.size()),
+      m_reached(targets.size(), false),
+      m_root(targets.size() / 2)
+{
+    COLA_ASSERT(!targets.empty());
+    build(0, m_targets.size(), XDIM, m_targets.size());
+    for (size_t i = 0; i < m_targets.size(); ++i)
+    {
+        m_positions.push_back(std::make_pair(m_targets[i], i));
+    }
+    std::sort(m_positions.begin(), m_positions.end());
+}
+
+
+void UnreachedTargets::build(const size_t begin, const size_t end, 
+        const size_t dim, const size_t parent)
+{
+    if (begin == end)
+    {
+        return;
+    }
+    const size_t middle = (begin + end) / 2;
+    std::nth_element(m_targets.begin() + begin, m_targets.begin() + middle,
+            m_targets.begin() + end, CmpVertInfCoord(dim));
+    m_parent[middle] = parent;
+    m_unreached[middle] = end - begin;
+    m_min[middle] = Point(DBL_MAX, DBL_MAX);
+    m_max[middle] = Point(-DBL_MAX, -DBL_MAX);
+    for (size_t i = begin; i < end; ++i)
+    {
+        const Point& p = m_targets[i]->point;
+        m_min[middle].x = std::min(m_min[middle].x, p.x);
+        m_min[middle].y = std::min(m_min[middle].y, p.y);
+        m_max[middle].x = std::max(m_max[middle].x, p.x);
+        m_max[middle].y = std::max(m_max[middle].y, p.y);
+    }
+    build(begin, middle, (dim + 1) % 2, middle);
+    build(middle + 1, end, (dim + 1) % 2, middle);
+}
+
+
+void UnreachedTargets::remove(VertInf *target)
+{
+    std::vector<std::pair<VertInf *, size_t> >::const_iterator position = 
+            std::lower_bound(m_positions.begin(), m_positions.end(), 
+                    std::make_pair(target, (size_t) 0));
+    COLA_ASSERT((position != m_positions.end()) && 
+            (position->first == target));
+    size_t index = position->second;
+    if (m_reached[index])
+    {
+        return;
+    }
+    m_reached[index] = true;
+    for (; index != m_targets.size(); index = m_parent[index])
+    {
+        m_unreached[index]--;
+    }
+}
+
+
+double UnreachedTargets::dist(const Point& a, const Point& b) const
+{
+    return (m_is_orthogonal) ? manhattanDist(a, b) : euclideanDist(a, b);
+}
+
+
+double UnreachedTargets::nearestDist(const Point& a) const
+{
+    double nearest = DBL_MAX;
+    findNearest(a, 0, m_targets.size(), XDIM, nearest);
+    return nearest;
+}
+
+
+void UnreachedTargets::findNearest(const Point& a, const size_t begin, 
+        const size_t end, const size_t dim, double& nearest) const
+{
+    if (begin == end)
+    {
+        return;
+    }
+    const size_t middle = (begin + end) / 2;
+    if (m_unreached[middle] == 0)
+    {
+        return;
+    }
+    // Skip the range if its bounding box is no nearer.
+    const Point& min = m_min[middle];
+    const Point& max = m_max[middle];
+    Point boxDiff(std::max(0.0, std::max(min.x - a.x, a.x - max.x)),
+            std::max(0.0, std::max(min.y - a.y, a.y - max.y)));
+    if (dist(Point(0, 0), boxDiff) >= nearest)
+    {
+        return;
+    }
+    const Point& split = m_targets[middle]->point;
+    if (!m_reached[middle])
+    {
+        nearest = std::min(nearest, dist(a, split));
+    }
+    // Search the side of the split containing a first, since the nearest
+    // target is most likely there.
+    const size_t next = (dim + 1) % 2;
+    if (a[dim] < split[dim])
+    {
+        findNearest(a, begin, middle, next, nearest);
+        findNearest(a, middle + 1, end, next, nearest);
+    }
+    else
+    {
+        findNearest(a, middle + 1, end, next, nearest);
+        findNearest(a, begin, middle, next, nearest);
+    }
+}
+
+
+// Returns the index of the connector with target vertex inf, or -1.
+static int targetIndex(
+        const std::vector<std::pair<VertInf *, size_t> >& targets,
+        VertInf *inf)
+{
+    std::vector<std::pair<VertInf *, size_t> >::const_iterator target = 
+            std::lower_bound(targets.begin(), targets.end(), 
+                    std::make_pair(inf, (size_t) 0));
+    if ((target != targets.end()) && (target->first == inf))
+    {
+        return (int) target->second;
+    }
+    return -1;
+}
+
+
+// An A* search from the source vertex of lineRefs[0] that continues until
+// the target vertices of all the connectors have been reached, with the
+// heuristic estimating the cost to the nearest target not yet reached.  
+// As for a single target, ANodes are tracked by the context's 
+// SearchStates, one for each vertex and previous vertex.
+//
+// Estimates grow as targets are reached, so those of ANodes already on 
+// PENDING may become too low.  Rather than updating all of them, the 
+// estimate of an ANode made before the last target was reached is 
+// checked as it comes off PENDING, and if it has grown the ANode is put
+// back with the new estimate.  Estimates only ever grow, so an ANode that
+// comes off PENDING with an up-to-date estimate is the lowest cost one.
+//
+void aStarPathsIsolated(const std::vector<ConnRef *>& lineRefs,
+        std::vector<std::vector<VertInf *> >& paths, 
+        AStarSearchContext& context)
+{
+    COLA_ASSERT(!lineRefs.empty());
+    ConnRef *lineRef = lineRefs[0];
+    VertInf *src = lineRef->src();
+    bool isOrthogonal = (lineRef->routingType() == ConnType_Orthogonal);
+    Router *router = lineRef->router();
+    COLA_ASSERT(connectorsCanShareSearch(router));
+    context.reset(router->vertices.searchIndexLimit());
+
+    paths.assign(lineRefs.size(), std::vector<VertInf *>());
+
+    // The targets, sorted so we can look up the connector for each, and
+    // the coordinates of all the possible endpoints for the orthogonal 
+    // routing optimisation.
+    std::vector<std::pair<VertInf *, size_t> > targets;
+    std::vector<double> endXs, endYs;
+    for (size_t i = 0; i < lineRefs.size(); ++i)
+    {
+        COLA_ASSERT((i == 0) || equivalentSearchSources(lineRef, lineRefs[i]));
+        VertInf *tar = lineRefs[i]->dst();
+        targets.push_back(std::make_pair(tar, i));
+        endXs.push_back(tar->point.x);
+        endYs.push_back(tar->point.y);
+        if (isOrthogonal)
+        {
+            std::vector<Point> pinPoints = lineRefs[i]->possibleDstPinPoints();
+            for (size_t j = 0; j < pinPoints.size(); ++j)
+            {
+                endXs.push_back(pinPoints[j].x);
+                endYs.push_back(pinPoints[j].y);
+            }
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    std::sort(endXs.begin(), endXs.end());
+    std::sort(endYs.begin(), endYs.end());
+    AlignedWithSortedCoords alignedWithEndPoint(endXs, endYs);
+    // The targets not yet reached, to which the heuristic estimates.
+    std::vector<VertInf *> targetVerts;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        targetVerts.push_back(targets[i].first);
+    }
+    UnreachedTargets unreached(targetVerts, isOrthogonal);
+
+    std::vector<ANode>& PENDING = context.pending;
+    std::vector<ANode>& DONE = context.done;
+    int timestamp = 1;
+    // ANodes with earlier timestamps may have estimates that are too low.
+    int lastReachedTimestamp = 0;
 
-    // Cleanup lists used to store positions in DONE list for ANodes at each
-    // vertex.
-    VertInf *endVert = router->vertices.end();
-    for (VertInf *k = router->vertices.connsBegin(); k != endVert;
-            k = k->lstNext)
+    ANode Node(src, timestamp++);
+    Node.h = unreached.nearestDist(src->point);
+    Node.f = Node.h;
+    PENDING.push_back(Node);
+    context.states[context.stateIndex(src, NULL)].g = 0;
+
+    while (!PENDING.empty() && !unreached.empty())
     {
-        k->aStarDoneIndexes.clear();
+        ANode BestNode = PENDING.front();
+        std::pop_heap(PENDING.begin(), PENDING.end());
+        PENDING.pop_back();
+
+        VertInf *prevInf = (BestNode.prevIndex >= 0) ?
+                DONE[BestNode.prevIndex].inf : NULL;
+        const int bestState = context.stateIndex(BestNode.inf, prevInf);
+        if (context.states[bestState].closed)
+        {
+            // Superseded by an ANode of lower cost.
+            continue;
+        }
+        if (BestNode.timeStamp < lastReachedTimestamp)
+        {
+            const double h = unreached.nearestDist(BestNode.inf->point);
+            if (h > BestNode.h)
+            {
+                // Targets have been reached since the estimate was made.
+                BestNode.h = h;
+                BestNode.f = BestNode.g + h;
+                PENDING.push_back(BestNode);
+                std::push_heap(PENDING.begin(), PENDING.end());
+                continue;
+            }
+        }
+        context.states[bestState].closed = true;
+        context.nodesExpanded++;
+
+        const int bestIndex = (int) DONE.size();
+        DONE.push_back(BestNode);
+
+        const int target = (BestNode.inf != src) ? 
+                targetIndex(targets, BestNode.inf) : -1;
+        if (target >= 0)
+        {
+            std::vector<VertInf *>& path = paths[target];
+            if (path.empty())
+            {
+                for (int curr = bestIndex; curr >= 0; 
+                        curr = DONE[curr].prevIndex)
+                {
+                    path.push_back(DONE[curr].inf);
+                }
+                std::reverse(path.begin(), path.end());
+                // Each path starts from its connector's own source.
+                path[0] = lineRefs[target]->src();
+                unreached.remove(BestNode.inf);
+                lastReachedTimestamp = timestamp;
+            }
+            // Paths don't continue through connector endpoints.
+            continue;
+        }
+
+        findExploreNeighbours(router, isOrthogonal, BestNode.inf, prevInf,
+                context);
+        const VisNeighbourList& exploreNeighbours = context.exploreNeighbours;
+        VisNeighbourList::const_iterator finish = exploreNeighbours.end();
+        for (VisNeighbourList::const_iterator neighbour = 
+                exploreNeighbours.begin(); neighbour != finish; ++neighbour)
+        {
+            Node = ANode(neighbour->vert, timestamp++);
+            Node.prevIndex = bestIndex;
+
+            if (prevInf && (prevInf == Node.inf))
+            {
+                continue;
+            }
+
+            if (Node.inf->id.isConnectionPin())
+            {
+                // None of these connectors are attached to pins.
+                continue;
+            }
+            else if (Node.inf->id.isConnPt() && 
+                    (targetIndex(targets, Node.inf) < 0))
+            {
+                // Not one of the target endpoints.
+                continue;
+            }
+
+            if (isOrthogonal && !neighbour->dummyConnection &&
+                    orthogonalTurnIsUnneeded(prevInf, BestNode.inf, Node.inf,
+                        src->point, alignedWithEndPoint))
+            {
+                continue;
+            }
+
+            double edgeDist = neighbour->dist;
+            if (edgeDist == 0)
+            {
+                continue;
+            }
+
+            if (!isOrthogonal && 
+                  (validateBendPoint(prevInf, BestNode.inf, Node.inf) == false))
+            {
+                continue;
+            }
+
+            Node.g = BestNode.g + cost(lineRef, edgeDist, BestNode.inf, 
+                    Node.inf, DONE, BestNode.prevIndex);
+            Node.h = unreached.nearestDist(Node.inf->point);
+            Node.f = Node.g + Node.h;
+
+            const int nodeState = context.stateIndex(Node.inf, BestNode.inf);
+            AStarSearchContext::SearchState& state = context.states[nodeState];
+            if (state.closed || (Node.g >= state.g))
+            {
+                continue;
+            }
+            state.g = Node.g;
+            PENDING.push_back(Node);
+            std::push_heap(PENDING.begin(), PENDING.end());
+        }
     }
 }
 
@@ -27,12 +27,161 @@
 #define AVOID_MAKEPATH_H
 
 
+#include <vector>
+
+#include "libavoid/geomtypes.h"
+#include "libavoid/graph.h"
+
 namespace Avoid {
 
 class ConnRef;
+class Router;
+class VertInf;
+class EdgeInf;
+
+
+// A step of a path explored by the A* search.
+class ANode
+{
+    public:
+        VertInf* inf;
+        double g;        // Gone
+        double h;        // Heuristic
+        double f;        // Formula f = g + h
+        
+        int prevIndex;   // Index into DONE for the previous ANode.
+        int timeStamp;   // Timestamp used to determine explaration order of
+                         // seemingly equal paths during orthogonal routing.
+
+        ANode(VertInf *vinf, int time)
+            : inf(vinf),
+              g(0),
+              h(0),
+              f(0),
+              prevIndex(-1),
+              timeStamp(time)
+        {
+        }
+        ANode()
+            : inf(NULL),
+              g(0),
+              h(0),
+              f(0),
+              prevIndex(-1),
+              timeStamp(-1)
+        {
+        }
+};
+
+
+// This class is not intended for public use.
+// It holds the working storage for A* searches, which is kept from one
+// search to the next so that searches don't need to allocate memory once
+// it has grown large enough.  A vertex may be reached from each of its 
+// neighbours, since the cost of the next segment depends on the bend 
+// between them, so the search keeps a SearchState for each combination 
+// of vertex and previous vertex it has reached.  These are kept in linked
+// lists for each vertex, with the head of each list stored in an array 
+// indexed by VertInf::searchIndex.  Entries in that array are only valid
+// if stamped with the current search's epoch, so nothing needs to be 
+// cleared between searches, and nothing is stored on the vertices 
+// themselves.
+//
+// The Router has a context for its own searches.  Searches run at the 
+// same time must each use a separate context.  A bidirectional search 
+// keeps the states of its backward half in a second context, owned by
+// the first, in which the previous vertex of each state is the next 
+// vertex of the path.
+//
+class AStarSearchContext
+{
+    public:
+        AStarSearchContext();
+        ~AStarSearchContext();
+
+        // Prepares for a new search over vertices with search indexes 
+        // less than vertexCount.
+        void reset(const unsigned int vertexCount);
+        // Returns the index in states of the state for reaching vert from
+        // prev, adding one with an infinite cost if there is none yet.
+        int stateIndex(VertInf *vert, const VertInf *prev);
+        // Returns the index of the state for reaching vert from prev, or 
+        // -1 if there is none.
+        int findStateIndex(const VertInf *vert, const VertInf *prev) const;
+        // Returns the context for the backward half of bidirectional 
+        // searches, creating it the first time.
+        AStarSearchContext& reverseContext(void);
+
+        // The lowest cost found so far for reaching a vertex from a 
+        // particular previous vertex, and whether the ANode for it has
+        // been moved to DONE.  Rather than searching PENDING for an ANode
+        // whose cost has been improved on, a new ANode is added and the
+        // superseded one is skipped when it reaches the top of the heap.
+        // Bidirectional searches also record the index in DONE of the 
+        // ANode that the lowest cost was found from.
+        class SearchState
+        {
+            public:
+                const VertInf *prev;
+                double g;
+                bool closed;
+                int parent;
+                int next;
+        };
+
+        std::vector<ANode> pending;
+        std::vector<ANode> done;
+        VisNeighbourList exploreNeighbours;
+        std::vector<Point> endPoints;
+        std::vector<SearchState> states;
+
+        // Running totals of the work done by searches using this context.
+        unsigned long nodesExpanded;
+        unsigned long edgesRelaxed;
+
+    private:
+        // Contexts own their reverse context, so aren't copied.
+        AStarSearchContext(const AStarSearchContext& other);
+        AStarSearchContext& operator=(const AStarSearchContext& other);
+
+        std::vector<int> m_vertex_state_head;
+        std::vector<unsigned int> m_vertex_epoch;
+        unsigned int m_epoch;
+        AStarSearchContext *m_reverse_context;
+};
+
 
+// Searches for the path of a connector from src to tar, setting the 
+// pathNext links of the vertices on it.  Orthogonal connectors are 
+// searched for from both ends at once if the router's 
+// searchConnectorPathsBidirectionally option is set and the cost of a 
+// path is just the sum of the costs of its segments and bends.
 extern void aStarPath(ConnRef *lineRef, VertInf *src, VertInf *tar,
         VertInf *start);
+// Performs the same search as aStarPath(), but without modifying any
+// vertex or edge state, so it may be called for several connectors at 
+// once, each with its own context.  The path, from src to tar, is 
+// returned in path, which is left empty if there is no path.
+extern void aStarPathIsolated(ConnRef *lineRef, VertInf *src, VertInf *tar,
+        std::vector<VertInf *>& path, AStarSearchContext& context);
+// Searches for the paths of several connectors with one search, rather 
+// than one each.  The connectors must start at equivalent source vertices
+// (see equivalentSearchSources()) and the cost function must not depend
+// on the connector (see connectorsCanShareSearch()).  As for 
+// aStarPathIsolated(), nothing is modified, and the path for 
+// lineRefs[i], from its own source vertex, is returned in paths[i].
+// The search is guided only towards the nearest of the targets not yet 
+// reached, so the paths may differ from those found for each connector 
+// alone where there are several of equal cost.
+extern void aStarPathsIsolated(const std::vector<ConnRef *>& lineRefs,
+        std::vector<std::vector<VertInf *> >& paths, 
+        AStarSearchContext& context);
+// Returns whether the searches for two connectors starting at these 
+// vertices would explore from them in the same way.
+extern bool equivalentSearchSources(ConnRef *lineRef1, ConnRef *lineRef2);
+// Returns whether the cost of a path is the same for all connectors of 
+// the same routing type, so they can share a search.
+extern bool connectorsCanShareSearch(Router *router);
 extern double estimatedCost(ConnRef *lineRef);
 
 }
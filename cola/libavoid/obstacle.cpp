@@ -107,6 +107,12 @@ void Obstacle::setNewPoly(const Polygon& poly)
 {
     COLA_ASSERT(m_first_vert != NULL);
     COLA_ASSERT(m_polygon.size() == poly.size());
+
+    if (m_active)
+    {
+        // The obstacle is indexed by its old bounding box.
+        m_router->spatialIndex.removeObstacle(this);
+    }
     
     VertInf *curr = m_first_vert;
     for (size_t pt_i = 0; pt_i < m_polygon.size(); ++pt_i)
@@ -123,6 +129,11 @@ void Obstacle::setNewPoly(const Polygon& poly)
     COLA_ASSERT(curr == m_first_vert);
         
     m_polygon = poly;
+
+    if (m_active)
+    {
+        m_router->spatialIndex.addObstacle(this);
+    }
 }
 
 
@@ -144,6 +155,8 @@ void Obstacle::makeActive(void)
         m_router->vertices.addVertex(tmp);
     }
     while (it != m_first_vert);
+
+    m_router->spatialIndex.addObstacle(this);
     
     m_active = true;
 }
@@ -166,6 +179,8 @@ void Obstacle::makeInactive(void)
         m_router->vertices.removeVertex(tmp);
     }
     while (it != m_first_vert);
+
+    m_router->spatialIndex.removeObstacle(this);
     
     m_active = false;
     
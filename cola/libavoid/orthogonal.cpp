@@ -28,7 +28,12 @@
 #include <cmath>
 #include <set>
 #include <list>
+#include <map>
+#include <vector>
+#include <queue>
+#include <functional>
 #include <algorithm>
+#include <new>
 
 #include "libavoid/router.h"
 #include "libavoid/geomtypes.h"
@@ -41,6 +46,7 @@
 #include "libavoid/assertions.h"
 #include "libavoid/hyperedgetree.h"
 #include "libavoid/mtst.h"
+#include "libavoid/pool.h"
 
 namespace Avoid {
 
@@ -816,7 +822,6 @@ struct Event
     double pos;
 };
 
-Event **events;
 
 
 // Used for quicksort.  Must return <0, 0, or >0.
@@ -1092,7 +1097,8 @@ public:
         }
         if (!found)
         {
-            found = new VertInf(router, dummyOrthogID, Point(posX, pos));
+            found = new (router->vertInfPool) VertInf(router,
+                    dummyOrthogID, Point(posX, pos));
             vertInfs.insert(found);
         }
         return found;
@@ -1110,7 +1116,7 @@ public:
         {
             if (begin != -DBL_MAX)
             {
-                vertInfs.insert(new
+                vertInfs.insert(new (router->vertInfPool)
                         VertInf(router, dummyOrthogID, Point(begin, pos)));
             }
         }
@@ -1129,7 +1135,7 @@ public:
         {
             if (finish != DBL_MAX)
             {
-                vertInfs.insert(new
+                vertInfs.insert(new (router->vertInfPool)
                         VertInf(router, dummyOrthogID, Point(finish, pos)));
             }
         }
@@ -1362,7 +1368,8 @@ public:
                 // Add begin point.
                 Point point(pos, pos);
                 point[dim] = begin;
-                VertInf *vert = new VertInf(router, dummyOrthogID, point);
+                VertInf *vert = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogID, point);
                 breakPoints.insert(PosVertInf(begin, vert));
             }
         }
@@ -1382,7 +1389,8 @@ public:
                 // Add begin point.
                 Point point(pos, pos);
                 point[dim] = finish;
-                VertInf *vert = new VertInf(router, dummyOrthogID, point);
+                VertInf *vert = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogID, point);
                 breakPoints.insert(PosVertInf(finish, vert));
             }
         }
@@ -1443,7 +1451,7 @@ public:
                     bool canSeeDown = (vert->dirs & VisDirDown);
                     if (canSeeDown && !(side->vert->id.isConnPt()))
                     {
-                        EdgeInf *edge = new 
+                        EdgeInf *edge = new (router->edgeInfPool)
                                 EdgeInf(side->vert, vert->vert, orthogonal);
                         edge->setDist(vert->vert->point[dim] - 
                                 side->vert->point[dim]);
@@ -1460,7 +1468,7 @@ public:
                     bool canSeeUp = (last->dirs & VisDirUp);
                     if (canSeeUp && (side != breakPoints.end()))
                     {
-                        EdgeInf *edge = new 
+                        EdgeInf *edge = new (router->edgeInfPool)
                                 EdgeInf(last->vert, side->vert, orthogonal);
                         edge->setDist(side->vert->point[dim] - 
                                 last->vert->point[dim]);
@@ -1489,8 +1497,8 @@ public:
                 }
                 if (generateEdge)
                 {
-                    EdgeInf *edge = 
-                            new EdgeInf(last->vert, vert->vert, orthogonal);
+                    EdgeInf *edge = new (router->edgeInfPool)
+                            EdgeInf(last->vert, vert->vert, orthogonal);
                     edge->setDist(vert->vert->point[dim] - 
                             last->vert->point[dim]);
                 }
@@ -1538,46 +1546,59 @@ class SegmentListWrapper
     public:
         LineSegment *insert(LineSegment segment)
         {
-            SegmentList::iterator found = _list.end();
-            for (SegmentList::iterator curr = _list.begin();
-                    curr != _list.end(); ++curr)
+            // Only colinear segments can overlap, so just consider those
+            // at the same position, in list order.
+            std::vector<SegmentList::iterator>& colinear = _index[segment.pos];
+            const size_t notFound = colinear.size();
+            size_t found = notFound;
+            for (size_t curr = 0; curr < colinear.size(); ++curr)
             {
-                if (curr->overlaps(segment))
+                if (colinear[curr]->overlaps(segment))
                 {
-                    if (found != _list.end())
+                    if (found != notFound)
                     {
                         // This is not the first segment that overlaps,
                         // so we need to merge and then delete an existing
                         // segment.
-                        curr->mergeVertInfs(*found);
-                        _list.erase(found);
-                        found = curr;
+                        colinear[curr]->mergeVertInfs(*colinear[found]);
+                        _list.erase(colinear[found]);
+                        colinear.erase(colinear.begin() + found);
+                        --curr;
                     }
                     else
                     {
                         // This is the first overlapping segment, so just 
                         // merge the new segment with this one.
-                        curr->mergeVertInfs(segment);
-                        found = curr;
+                        colinear[curr]->mergeVertInfs(segment);
                     }
+                    found = curr;
                 }
             }
 
-            if (found == _list.end())
+            if (found == notFound)
             {
                 // Add this line.
                 _list.push_back(segment);
+                colinear.push_back(--_list.end());
                 return &(_list.back());
             }
 
-            return &(*found);
+            return &(*colinear[found]);
         }
+        // The list may be freely modified once all segments are inserted.
         SegmentList& list(void)
         {
             return _list;
         }
+        void clear(void)
+        {
+            _list.clear();
+            _index.clear();
+        }
     private:
         SegmentList _list;
+        // Segments in the list, indexed by position.
+        std::map<double, std::vector<SegmentList::iterator> > _index;
 };
 
 
@@ -1592,7 +1613,8 @@ static void intersectSegments(Router *router, SegmentList& segments,
     //COLA_ASSERT(vertLine.beginVertInf() == NULL);
     //COLA_ASSERT(vertLine.finishVertInf() == NULL);
 
-    COLA_ASSERT(!segments.empty());
+    // The segments may be empty when the graph is being updated and there 
+    // are no horizontal segments affected.
     for (SegmentList::iterator it = segments.begin(); it != segments.end(); )
     {
         LineSegment& horiLine = *it;
@@ -1602,9 +1624,10 @@ static void intersectSegments(Router *router, SegmentList& segments,
 
         if (vertLine.pos < horiLine.begin)
         {
-            // We've yet to reach this segment in the sweep, so ignore.
-            ++it;
-            continue;
+            // We've yet to reach this segment in the sweep.  The list is
+            // sorted by begin position, so nor have we reached any of the
+            // segments that follow.
+            break;
         }
         else if (vertLine.pos == horiLine.begin)
         {
@@ -1726,10 +1749,10 @@ static void processEventVert(Router *router, NodeSet& scanline,
             if (minLimitMax >= maxLimitMin)
             {
                 // These vertices represent the shape corners.
-                VertInf *vI1 = new VertInf(router, dummyOrthogShapeID, 
-                            Point(minShape, lineY));
-                VertInf *vI2 = new VertInf(router, dummyOrthogShapeID, 
-                            Point(maxShape, lineY));
+                VertInf *vI1 = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogShapeID, Point(minShape, lineY));
+                VertInf *vI2 = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogShapeID, Point(maxShape, lineY));
                 
                 // There are no overlapping shapes, so give full visibility.
                 if (minLimit < minShape)
@@ -1754,8 +1777,8 @@ static void processEventVert(Router *router, NodeSet& scanline,
                     LineSegment *line = segments.insert(
                             LineSegment(minLimit, minLimitMax, lineY, true));
                     // Shape corner:
-                    VertInf *vI1 = new VertInf(router, dummyOrthogShapeID, 
-                                Point(minShape, lineY));
+                    VertInf *vI1 = new (router->vertInfPool) VertInf(router,
+                            dummyOrthogShapeID, Point(minShape, lineY));
                     line->vertInfs.insert(vI1);
                 }
                 if ((maxLimitMin < maxLimit) && (maxLimitMin <= maxShape))
@@ -1763,8 +1786,8 @@ static void processEventVert(Router *router, NodeSet& scanline,
                     LineSegment *line = segments.insert(
                             LineSegment(maxLimitMin, maxLimit, lineY, true));
                     // Shape corner:
-                    VertInf *vI2 = new VertInf(router, dummyOrthogShapeID, 
-                                Point(maxShape, lineY));
+                    VertInf *vI2 = new (router->vertInfPool) VertInf(router,
+                            dummyOrthogShapeID, Point(maxShape, lineY));
                     line->vertInfs.insert(vI2);
                 }
             }
@@ -1809,7 +1832,8 @@ static void processEventVert(Router *router, NodeSet& scanline,
                 // *through* connector endpoint vertices).
                 if (line1 || line2)
                 {
-                    VertInf *cent = new VertInf(router, dummyOrthogID, cp);
+                    VertInf *cent = new (router->vertInfPool) VertInf(router,
+                            dummyOrthogID, cp);
                     if (line1)
                     {
                         line1->vertInfs.insert(cent);
@@ -1840,14 +1864,12 @@ static void processEventVert(Router *router, NodeSet& scanline,
         if (e->type == ConnPoint)
         {
             scanline.erase(v->iter);
-            delete v;
         }
         else  // if (e->type == Close)
         {
             size_t result;
             result = scanline.erase(v);
             COLA_ASSERT(result == 1);
-            delete v;
         }
     }
 }
@@ -1910,10 +1932,10 @@ static void processEventHori(Router *router, NodeSet& scanline,
                         LineSegment(minLimit, maxLimit, lineX));
 
                 // Shape corners:
-                VertInf *vI1 = new VertInf(router, dummyOrthogShapeID, 
-                        Point(lineX, minShape));
-                VertInf *vI2 = new VertInf(router, dummyOrthogShapeID, 
-                        Point(lineX, maxShape));
+                VertInf *vI1 = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogShapeID, Point(lineX, minShape));
+                VertInf *vI2 = new (router->vertInfPool) VertInf(router,
+                        dummyOrthogShapeID, Point(lineX, maxShape));
                 line->vertInfs.insert(vI1);
                 line->vertInfs.insert(vI2);
             }
@@ -1925,8 +1947,8 @@ static void processEventHori(Router *router, NodeSet& scanline,
                             LineSegment(minLimit, minLimitMax, lineX));
 
                     // Shape corner:
-                    VertInf *vI1 = new VertInf(router, dummyOrthogShapeID, 
-                                Point(lineX, minShape));
+                    VertInf *vI1 = new (router->vertInfPool) VertInf(router,
+                            dummyOrthogShapeID, Point(lineX, minShape));
                     line->vertInfs.insert(vI1);
                 }
                 if ((maxLimitMin < maxLimit) && (maxLimitMin <= maxShape))
@@ -1935,8 +1957,8 @@ static void processEventHori(Router *router, NodeSet& scanline,
                             LineSegment(maxLimitMin, maxLimit, lineX));
 
                     // Shape corner:
-                    VertInf *vI2 = new VertInf(router, dummyOrthogShapeID, 
-                                Point(lineX, maxShape));
+                    VertInf *vI2 = new (router->vertInfPool) VertInf(router,
+                            dummyOrthogShapeID, Point(lineX, maxShape));
                     line->vertInfs.insert(vI2);
                 }
             }
@@ -1982,29 +2004,137 @@ static void processEventHori(Router *router, NodeSet& scanline,
         if (e->type == ConnPoint)
         {
             scanline.erase(v->iter);
-            delete v;
         }
         else  // if (e->type == Close)
         {
             size_t result;
             result = scanline.erase(v);
             COLA_ASSERT(result == 1);
-            delete v;
         }
     }
 }
 
 
-extern void generateStaticOrthogonalVisGraph(Router *router)
+// The positions, in one dimension, spanned by the obstacles and connector
+// endpoints that have changed since the orthogonal visibility graph was
+// built.  These are kept as sorted, disjoint, closed intervals.
+class SweepBands
+{
+    public:
+        void add(const double min, const double max)
+        {
+            m_bands.push_back(std::make_pair(min, max));
+        }
+        // Sorts and merges the bands once all have been added.
+        void merge(void)
+        {
+            std::sort(m_bands.begin(), m_bands.end());
+            BandList merged;
+            for (BandList::const_iterator band = m_bands.begin();
+                    band != m_bands.end(); ++band)
+            {
+                if (!merged.empty() && (band->first <= merged.back().second))
+                {
+                    merged.back().second = 
+                            std::max(merged.back().second, band->second);
+                }
+                else
+                {
+                    merged.push_back(*band);
+                }
+            }
+            m_bands.swap(merged);
+        }
+        bool contains(const double pos) const
+        {
+            return overlaps(pos, pos);
+        }
+        // Returns whether any band overlaps [min, max].
+        bool overlaps(const double min, const double max) const
+        {
+            BandList::const_iterator band = std::lower_bound(
+                    m_bands.begin(), m_bands.end(), min, FinishesBefore());
+            return (band != m_bands.end()) && (band->first <= max);
+        }
+        // Removes the segments recorded at positions within the bands.
+        void eraseFrom(OrthogonalVisGraphSegments::SegmentMap& segments) const
+        {
+            for (BandList::const_iterator band = m_bands.begin();
+                    band != m_bands.end(); ++band)
+            {
+                segments.erase(segments.lower_bound(band->first),
+                        segments.upper_bound(band->second));
+            }
+        }
+    private:
+        typedef std::vector<std::pair<double, double> > BandList;
+        struct FinishesBefore
+        {
+            bool operator()(const std::pair<double, double>& band, 
+                    const double pos) const
+            {
+                return band.second < pos;
+            }
+        };
+        BandList m_bands;
+};
+
+
+// Records the segments, which all lie in the same direction, before they 
+// are intersected.
+static void recordSegments(OrthogonalVisGraphSegments::SegmentMap& record,
+        const SegmentList& segments)
+{
+    for (SegmentList::const_iterator curr = segments.begin(); 
+            curr != segments.end(); ++curr)
+    {
+        OrthogonalVisGraphSegments::Segment& recorded = record.insert(
+                std::make_pair(curr->pos, 
+                    OrthogonalVisGraphSegments::Segment()))->second;
+        recorded.begin = curr->begin;
+        recorded.finish = curr->finish;
+        for (VertSet::const_iterator v = curr->vertInfs.begin();
+                v != curr->vertInfs.end(); ++v)
+        {
+            COLA_ASSERT((*v)->id.isConnPt() || ((*v)->id == dummyOrthogID));
+            OrthogonalVisGraphSegments::Vertex vertex;
+            vertex.point = (*v)->point;
+            vertex.connVertex = ((*v)->id.isConnPt()) ? *v : NULL;
+            vertex.shapeCorner = (*v)->id.isOrthShapeEdge();
+            recorded.vertices.push_back(vertex);
+        }
+    }
+}
+
+
+// Sweeps over the obstacles and connector endpoints in the dimension dim,
+// adding the possible visibility segments found at each position to 
+// segments: horizontal ones for the vertical sweep, in YDIM, and vertical 
+// ones for the horizontal sweep, in XDIM.  If bands is given, segments are
+// only found at positions within these, and only the objects spanning 
+// such positions are swept.  If horiSegments is given, the vertical 
+// segments found at each position are recorded in record, if given, and 
+// then intersected with horiSegments, rather than kept in segments.
+static void sweepVisibilitySegments(Router *router, const size_t dim,
+        const SweepBands *bands, SegmentListWrapper& segments,
+        SegmentList *horiSegments = NULL, 
+        OrthogonalVisGraphSegments::SegmentMap *record = NULL)
 {
+    void (*processEvent)(Router *, NodeSet&, SegmentListWrapper&, Event *,
+            unsigned int) = (dim == YDIM) ? processEventVert : 
+            processEventHori;
     const size_t n = router->m_obstacles.size();
     const unsigned cpn = router->vertices.connsSize();
-    // Set up the events for the vertical sweep.
-    size_t totalEvents = (2 * n) + cpn;
-    events = new Event*[totalEvents];
+    // Set up the events for the sweep.
+    Event **events = new Event*[(2 * n) + cpn];
+    // The Nodes and Events are taken from pools and freed together at the
+    // end.  Each pool is a single chunk, so the Nodes are laid out in the
+    // order they are created.
+    MemoryPool nodePool(sizeof(Node), n + cpn + 1);
+    MemoryPool eventPool(sizeof(Event), (2 * n) + cpn + 1);
     unsigned ctr = 0;
-    ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
-    for (unsigned i = 0; i < n; i++)
+    for (ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
+            obstacleIt != router->m_obstacles.end(); ++obstacleIt)
     {
         Obstacle *obstacle = *obstacleIt;
 #ifndef PAPER
@@ -2012,20 +2142,23 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         if (junction && ! junction->positionFixed())
         {
             // Junctions that are free to move are not treated as obstacles.
-            ++obstacleIt;
-            totalEvents -= 2;
             continue;
         }
 #endif
 
-        double minX, minY, maxX, maxY;
-        obstacle->polygon().getBoundingRect(&minX, &minY, &maxX, &maxY);
-        double midX = minX + ((maxX - minX) / 2);
-        Node *v = new Node(obstacle, midX);
-        events[ctr++] = new Event(Open, v, minY);
-        events[ctr++] = new Event(Close, v, maxY);
-
-        ++obstacleIt;
+        Point minPt, maxPt;
+        obstacle->polygon().getBoundingRect(&minPt.x, &minPt.y, 
+                &maxPt.x, &maxPt.y);
+        if (bands && !bands->overlaps(minPt[dim], maxPt[dim]))
+        {
+            // The obstacle is not on the scanline at any position we find
+            // segments at.
+            continue;
+        }
+        double mid = minPt[!dim] + ((maxPt[!dim] - minPt[!dim]) / 2);
+        Node *v = new (nodePool.allocate()) Node(obstacle, mid);
+        events[ctr++] = new (eventPool.allocate()) Event(Open, v, minPt[dim]);
+        events[ctr++] = new (eventPool.allocate()) Event(Close, v, maxPt[dim]);
     }
     for (VertInf *curr = router->vertices.connsBegin(); 
             curr && (curr != router->vertices.shapesBegin()); 
@@ -2035,21 +2168,25 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         {
             // This is a connector endpoint that is attached to a connection
             // pin on a shape, so it doesn't need to be given visibility.
-            // Thus, skip it and record that there is one less total event.
-            --totalEvents;
+            // Thus, skip it.
             continue;
         }
         Point& point = curr->point;
+        if (bands && !bands->contains(point[dim]))
+        {
+            continue;
+        }
 
-        Node *v = new Node(curr, point.x);
-        events[ctr++] = new Event(ConnPoint, v, point.y);
+        Node *v = new (nodePool.allocate()) Node(curr, point[!dim]);
+        events[ctr++] = new (eventPool.allocate()) 
+                Event(ConnPoint, v, point[dim]);
     }
+    const size_t totalEvents = ctr;
     qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
 
-    // Process the vertical sweep.
+    // Process the sweep.
     // We do multiple passes over sections of the list so we can add relevant
     // entries to the scanline that might follow, before process them.
-    SegmentListWrapper segments;
     NodeSet scanline;
     double thisPos = (totalEvents > 0) ? events[0]->pos : 0;
     unsigned int posStartIndex = 0;
@@ -2061,13 +2198,30 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         if ((i == totalEvents) || (events[i]->pos != thisPos))
         {
             posFinishIndex = i;
-            for (int pass = 2; pass <= 3; ++pass)
+            // Outside the bands, events just maintain the scanline.
+            int firstPass = (!bands || bands->contains(thisPos)) ? 2 : 3;
+            for (int pass = firstPass; pass <= 3; ++pass)
             {
                 for (unsigned j = posStartIndex; j < posFinishIndex; ++j)
                 {
-                    processEventVert(router, scanline, segments, 
-                            events[j], pass);
+                    processEvent(router, scanline, segments, events[j], pass);
+                }
+            }
+
+            if (horiSegments)
+            {
+                // Process the merged line segments.
+                segments.list().sort();
+                if (record)
+                {
+                    recordSegments(*record, segments.list());
+                }
+                for (SegmentList::iterator curr = segments.list().begin();
+                        curr != segments.list().end(); ++curr)
+                {
+                    intersectSegments(router, *horiSegments, *curr);
                 }
+                segments.clear();
             }
 
             if (i == totalEvents)
@@ -2083,123 +2237,372 @@ extern void generateStaticOrthogonalVisGraph(Router *router)
         // Do the first sweep event handling -- building the correct 
         // structure of the scanline.
         const int pass = 1;
-        processEventVert(router, scanline, segments, events[i], pass);
+        processEvent(router, scanline, segments, events[i], pass);
     }
     COLA_ASSERT(scanline.size() == 0);
-    for (unsigned i = 0; i < totalEvents; ++i)
+    delete [] events;
+}
+
+
+// Adds the edges along the portions of the horizontal lines that are after
+// the final vertical position considered.
+static void finishHorizontalSegments(Router *router, SegmentList& segments)
+{
+    for (SegmentList::iterator it = segments.begin(); it != segments.end(); )
     {
-        delete events[i];
+        LineSegment& horiLine = *it;
+
+        horiLine.addEdgeHorizontal(router);
+        
+        size_t dim = XDIM; // x-dimension
+        horiLine.generateVisibilityEdgesFromBreakpointSet(router, dim);
+
+        it = segments.erase(it);
     }
+}
 
+
+extern void generateStaticOrthogonalVisGraph(Router *router,
+        OrthogonalVisGraphSegments *record)
+{
+    // The vertical sweep finds the possible horizontal visibility segments.
+    SegmentListWrapper segments;
+    sweepVisibilitySegments(router, YDIM, NULL, segments);
+    if (record)
+    {
+        recordSegments(record->horizontal, segments.list());
+    }
     segments.list().sort();
 
-    // Set up the events for the horizontal sweep.
+    // The horizontal sweep finds the vertical ones at each position, and
+    // intersects them with the horizontal ones.
     SegmentListWrapper vertSegments;
-    ctr = 0;
-    obstacleIt = router->m_obstacles.begin();
-    for (unsigned i = 0; i < n; i++)
+    sweepVisibilitySegments(router, XDIM, NULL, vertSegments, 
+            &(segments.list()), (record) ? &(record->vertical) : NULL);
+
+    finishHorizontalSegments(router, segments.list());
+}
+
+
+static bool isPinConnectionVertex(const VertInf *vert)
+{
+    return vert->id.isConnPt() && (vert->visDirections == ConnDirNone);
+}
+
+
+// Returns whether the segment recorded at pos, along which there is an 
+// edge between begin and finish, crosses any of the bands.
+static bool recordedSegmentCrosses(
+        const OrthogonalVisGraphSegments::SegmentMap& record, 
+        const double pos, const double begin, const double finish, 
+        const SweepBands& bands)
+{
+    typedef OrthogonalVisGraphSegments::SegmentMap::const_iterator 
+            SegmentIterator;
+    std::pair<SegmentIterator, SegmentIterator> range = 
+            record.equal_range(pos);
+    for (SegmentIterator curr = range.first; curr != range.second; ++curr)
     {
-        Obstacle *obstacle = *obstacleIt;
-#ifndef PAPER
-        JunctionRef *junction = dynamic_cast<JunctionRef *> (obstacle);
-        if (junction && ! junction->positionFixed())
+        if ((curr->second.begin <= begin) && (finish <= curr->second.finish))
         {
-            // Junctions that are free to move are not treated as obstacles.
-            ++obstacleIt;
-            continue;
+            return bands.overlaps(curr->second.begin, curr->second.finish);
         }
-#endif
-        double minX, minY, maxX, maxY;
-        obstacle->polygon().getBoundingRect(&minX, &minY, &maxX, &maxY);
-        double midY = minY + ((maxY - minY) / 2);
-        Node *v = new Node(obstacle, midY);
-        events[ctr++] = new Event(Open, v, minX);
-        events[ctr++] = new Event(Close, v, maxX);
-
-        ++obstacleIt;
     }
+    // Every edge should lie along a recorded segment.
+    COLA_ASSERT(false);
+    return true;
+}
+
+
+// Deletes the edges along the lines affected by the changes within the 
+// bands: those at positions within the bands and those crossing them.
+// Edges given to connector endpoints attached to connection pins are also
+// deleted, as they would be when regenerating the graph.
+static void deleteAffectedEdges(Router *router, 
+        const OrthogonalVisGraphSegments& record, const SweepBands& xBands, 
+        const SweepBands& yBands)
+{
+    router->visOrthogGraphSnapshot.clear();
     for (VertInf *curr = router->vertices.connsBegin(); 
             curr && (curr != router->vertices.shapesBegin()); 
             curr = curr->lstNext)
     {
-        if (curr->visDirections == ConnDirNone)
+        if (isPinConnectionVertex(curr))
         {
-            // This is a connector endpoint that is attached to a connection
-            // pin on a shape, so it doesn't need to be given visibility.
-            // Thus, skip it.
-            continue;
+            while (!curr->orthogVisList.empty())
+            {
+                delete curr->orthogVisList.front();
+            }
         }
-        Point& point = curr->point;
+    }
 
-        Node *v = new Node(curr, point.y);
-        events[ctr++] = new Event(ConnPoint, v, point.x);
+    EdgeInf *edge = router->visOrthogGraph.begin();
+    while (edge != router->visOrthogGraph.end())
+    {
+        EdgeInf *following = edge->lstNext;
+        std::pair<Point, Point> ends = edge->points();
+        bool horizontal = (ends.first.y == ends.second.y);
+        bool vertical = (ends.first.x == ends.second.x);
+        bool affected = !horizontal && !vertical;
+        if (xBands.contains(ends.first.x) || xBands.contains(ends.second.x) ||
+                yBands.contains(ends.first.y) || yBands.contains(ends.second.y))
+        {
+            affected = true;
+        }
+        if (!affected && horizontal)
+        {
+            affected = recordedSegmentCrosses(record.horizontal, ends.first.y,
+                    std::min(ends.first.x, ends.second.x), 
+                    std::max(ends.first.x, ends.second.x), xBands);
+        }
+        if (!affected && vertical)
+        {
+            affected = recordedSegmentCrosses(record.vertical, ends.first.x,
+                    std::min(ends.first.y, ends.second.y), 
+                    std::max(ends.first.y, ends.second.y), yBands);
+        }
+        if (affected)
+        {
+            delete edge;
+        }
+        edge = following;
     }
-    qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
+}
 
-    // Process the horizontal sweep
-    thisPos = (totalEvents > 0) ? events[0]->pos : 0;
-    posStartIndex = 0;
-    posFinishIndex = 0;
-    for (unsigned i = 0; i <= totalEvents; ++i)
+
+// Makes a segment at pos from the one recorded, with new dummy vertices at
+// the recorded points.
+static LineSegment recordedSegment(Router *router, const double pos,
+        const OrthogonalVisGraphSegments::Segment& recorded)
+{
+    LineSegment segment = (recorded.begin < recorded.finish) ? 
+            LineSegment(recorded.begin, recorded.finish, pos) : 
+            LineSegment(recorded.begin, pos);
+    for (size_t i = 0; i < recorded.vertices.size(); ++i)
     {
-        // If we have finished the current scanline or all events, then we
-        // process the events on the current scanline in a couple of passes.
-        if ((i == totalEvents) || (events[i]->pos != thisPos))
+        const OrthogonalVisGraphSegments::Vertex& vertex = 
+                recorded.vertices[i];
+        VertInf *vert = vertex.connVertex;
+        if (!vert)
         {
-            posFinishIndex = i;
-            for (int pass = 2; pass <= 3; ++pass)
-            {
-                for (unsigned j = posStartIndex; j < posFinishIndex; ++j)
-                {
-                    processEventHori(router, scanline, vertSegments, 
-                            events[j], pass);
-                }
-            }
-            
-            // Process the merged line segments.
-            vertSegments.list().sort();
-            for (SegmentList::iterator curr = vertSegments.list().begin();
-                    curr != vertSegments.list().end(); ++curr)
-            {
-                intersectSegments(router, segments.list(), *curr);
-            }
-            vertSegments.list().clear();
+            vert = new (router->vertInfPool) VertInf(router, 
+                    (vertex.shapeCorner) ? dummyOrthogShapeID : 
+                    dummyOrthogID, vertex.point);
+        }
+        segment.vertInfs.insert(vert);
+    }
+    return segment;
+}
 
-            if (i == totalEvents)
+
+// Adds to verts the vertices at point along the unaffected segment kept, 
+// which an affected segment crosses there: the dummy vertices still in the 
+// graph and the connector endpoints recorded.
+static void keptVerticesAt(Router *router, const Point& point,
+        const OrthogonalVisGraphSegments::Segment& kept,
+        std::vector<VertInf *>& verts)
+{
+    for (size_t i = 0; i < kept.vertices.size(); ++i)
+    {
+        if (kept.vertices[i].connVertex && (kept.vertices[i].point == point))
+        {
+            verts.push_back(kept.vertices[i].connVertex);
+        }
+    }
+    std::vector<VertInf *> found;
+    router->vertices.getVerticesByPos(point, found);
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        if ((found[i]->id == dummyOrthogID) && !found[i]->orphaned())
+        {
+            verts.push_back(found[i]);
+        }
+    }
+}
+
+
+// Adds to the horizontal segment at a position outside the bands the 
+// vertices where it crosses unaffected vertical segments, in place of the
+// new dummy vertices there.  These crossings are not swept again.
+static void addKeptCrossingsHorizontal(Router *router, LineSegment& horiLine,
+        const OrthogonalVisGraphSegments::SegmentMap& vertical, 
+        const SweepBands& xBands, const SweepBands& yBands)
+{
+    std::set<Point> crossings;
+    std::vector<VertInf *> verts;
+    for (OrthogonalVisGraphSegments::SegmentMap::const_iterator curr =
+            vertical.lower_bound(horiLine.begin); 
+            (curr != vertical.end()) && (curr->first <= horiLine.finish); 
+            ++curr)
+    {
+        const OrthogonalVisGraphSegments::Segment& kept = curr->second;
+        if (xBands.contains(curr->first) || 
+                yBands.overlaps(kept.begin, kept.finish) ||
+                (horiLine.pos < kept.begin) || (horiLine.pos > kept.finish))
+        {
+            continue;
+        }
+        Point point(curr->first, horiLine.pos);
+        crossings.insert(point);
+        keptVerticesAt(router, point, kept, verts);
+    }
+
+    for (VertSet::iterator v = horiLine.vertInfs.begin(); 
+            v != horiLine.vertInfs.end(); )
+    {
+        if (((*v)->id == dummyOrthogID) && crossings.count((*v)->point))
+        {
+            horiLine.vertInfs.erase(v++);
+            continue;
+        }
+        ++v;
+    }
+    for (size_t i = 0; i < verts.size(); ++i)
+    {
+        if (verts[i]->id == dummyOrthogID)
+        {
+            // The flags for this dimension are set again.
+            verts[i]->orthogVisPropFlags &= 
+                    ~(XL_EDGE | XL_CONN | XH_EDGE | XH_CONN);
+        }
+        horiLine.vertInfs.insert(verts[i]);
+    }
+}
+
+
+// Adds to the vertical segment at a position outside the bands breakpoints
+// for the vertices where it crosses unaffected horizontal segments.  These
+// crossings are not swept again.
+static void addKeptCrossingsVertical(Router *router, LineSegment& vertLine,
+        const OrthogonalVisGraphSegments::SegmentMap& horizontal, 
+        const SweepBands& xBands, const SweepBands& yBands)
+{
+    for (OrthogonalVisGraphSegments::SegmentMap::const_iterator curr =
+            horizontal.lower_bound(vertLine.begin); 
+            (curr != horizontal.end()) && (curr->first <= vertLine.finish);
+            ++curr)
+    {
+        const OrthogonalVisGraphSegments::Segment& kept = curr->second;
+        if (yBands.contains(curr->first) || 
+                xBands.overlaps(kept.begin, kept.finish) ||
+                (vertLine.pos < kept.begin) || (vertLine.pos > kept.finish))
+        {
+            continue;
+        }
+        std::vector<VertInf *> verts;
+        keptVerticesAt(router, Point(vertLine.pos, curr->first), kept, verts);
+        for (size_t i = 0; i < verts.size(); ++i)
+        {
+            if (verts[i]->id == dummyOrthogID)
             {
-                // We have cleaned up, so we can now break out of loop.
-                break;
+                // The flags for this dimension are set again.
+                verts[i]->orthogVisPropFlags &= 
+                        ~(YL_EDGE | YL_CONN | YH_EDGE | YH_CONN);
             }
-
-            thisPos = events[i]->pos;
-            posStartIndex = i;
+            vertLine.breakPoints.insert(PosVertInf(curr->first, verts[i],
+                    getPosVertInfDirections(verts[i], YDIM)));
         }
+    }
+}
 
-        // Do the first sweep event handling -- building the correct 
-        // structure of the scanline.
-        const int pass = 1;
-        processEventHori(router, scanline, vertSegments, events[i], pass);
+
+// Orders vertical segments as the horizontal sweep intersects them.
+static bool vertSegmentSweepOrder(const LineSegment& lhs, 
+        const LineSegment& rhs)
+{
+    if (lhs.pos != rhs.pos)
+    {
+        return lhs.pos < rhs.pos;
     }
-    COLA_ASSERT(scanline.size() == 0);
-    for (unsigned i = 0; i < totalEvents; ++i)
+    return lhs < rhs;
+}
+
+
+// The graph is updated where obstacles or connector endpoints have changed
+// by finding the visibility segments again within the horizontal and 
+// vertical bands the changes span, where every line may have changed.  The
+// lines outside the bands that cross them are unchanged, but may now 
+// intersect different lines in the bands, so their edges are regenerated
+// from the recorded segments.  This is done by sweeping over all these 
+// affected lines as the graph is generated, except that where they cross
+// the unaffected lines, which are kept as they are, the existing vertices 
+// are added to them.
+extern void updateStaticOrthogonalVisGraph(Router *router,
+        const std::vector<BBox>& changes, OrthogonalVisGraphSegments& record)
+{
+    SweepBands xBands;
+    SweepBands yBands;
+    for (size_t i = 0; i < changes.size(); ++i)
     {
-        delete events[i];
+        xBands.add(changes[i].a.x, changes[i].b.x);
+        yBands.add(changes[i].a.y, changes[i].b.y);
     }
-    delete [] events;
+    xBands.merge();
+    yBands.merge();
+
+    deleteAffectedEdges(router, record, xBands, yBands);
 
-    // Add portions of the horizontal line that are after the final vertical
-    // position we considered.
-    for (SegmentList::iterator it = segments.list().begin(); 
-            it != segments.list().end(); )
+    // Find the segments within the bands, and record them in place of 
+    // those recorded there before.
+    SegmentListWrapper segments;
+    sweepVisibilitySegments(router, YDIM, &yBands, segments);
+    SegmentListWrapper vertSegments;
+    sweepVisibilitySegments(router, XDIM, &xBands, vertSegments);
+    yBands.eraseFrom(record.horizontal);
+    xBands.eraseFrom(record.vertical);
+    recordSegments(record.horizontal, segments.list());
+    recordSegments(record.vertical, vertSegments.list());
+
+    // Add the recorded segments that cross the bands.
+    SegmentList& horiList = segments.list();
+    for (OrthogonalVisGraphSegments::SegmentMap::const_iterator curr =
+            record.horizontal.begin(); curr != record.horizontal.end(); ++curr)
     {
-        LineSegment& horiLine = *it;
+        if (!yBands.contains(curr->first) && 
+                xBands.overlaps(curr->second.begin, curr->second.finish))
+        {
+            horiList.push_back(recordedSegment(router, curr->first, 
+                        curr->second));
+            addKeptCrossingsHorizontal(router, horiList.back(), 
+                    record.vertical, xBands, yBands);
+        }
+    }
+    SegmentList& vertList = vertSegments.list();
+    for (OrthogonalVisGraphSegments::SegmentMap::const_iterator curr =
+            record.vertical.begin(); curr != record.vertical.end(); ++curr)
+    {
+        if (!xBands.contains(curr->first) && 
+                yBands.overlaps(curr->second.begin, curr->second.finish))
+        {
+            vertList.push_back(recordedSegment(router, curr->first, 
+                        curr->second));
+            addKeptCrossingsVertical(router, vertList.back(), 
+                    record.horizontal, xBands, yBands);
+        }
+    }
 
-        horiLine.addEdgeHorizontal(router);
-        
-        size_t dim = XDIM; // x-dimension
-        horiLine.generateVisibilityEdgesFromBreakpointSet(router, dim);
+    // Intersect the affected lines, as the horizontal sweep would.
+    horiList.sort();
+    vertList.sort(vertSegmentSweepOrder);
+    for (SegmentList::iterator curr = vertList.begin(); 
+            curr != vertList.end(); ++curr)
+    {
+        intersectSegments(router, horiList, *curr);
+    }
+    finishHorizontalSegments(router, horiList);
 
-        it = segments.list().erase(it);
+    // Remove the vertices no longer in the graph.
+    VertInf *curr = router->vertices.shapesBegin();
+    while (curr)
+    {
+        if (curr->orphaned() && (curr->id == dummyOrthogID))
+        {
+            VertInf *following = router->vertices.removeVertex(curr);
+            delete curr;
+            curr = following;
+            continue;
+        }
+        curr = curr->lstNext;
     }
 }
 
@@ -2288,7 +2691,6 @@ static void processShiftEvent(NodeSet& scanline, Event *e, size_t dim,
         size_t result;
         result = scanline.erase(v);
         COLA_ASSERT(result == 1);
-        delete v;
     }
 }
 
@@ -2596,7 +2998,11 @@ static void buildOrthogonalChannelInfo(Router *router,
     const size_t cpn = segmentList.size();
     // Set up the events for the sweep.
     size_t totalEvents = 2 * (n + cpn);
-    events = new Event*[totalEvents];
+    Event **events = new Event*[totalEvents];
+    // The Nodes and Events are taken from pools and freed together at 
+    // the end.
+    MemoryPool nodePool(sizeof(Node), n + cpn + 1);
+    MemoryPool eventPool(sizeof(Event), totalEvents + 1);
     unsigned ctr = 0;
     ObstacleList::iterator obstacleIt = router->m_obstacles.begin();
     for (unsigned i = 0; i < n; i++)
@@ -2613,9 +3019,9 @@ static void buildOrthogonalChannelInfo(Router *router,
         Point min, max;
         obstacle->polygon().getBoundingRect(&min.x, &min.y, &max.x, &max.y);
         double mid = min[dim] + ((max[dim] - min[dim]) / 2);
-        Node *v = new Node(obstacle, mid);
-        events[ctr++] = new Event(Open, v, min[altDim]);
-        events[ctr++] = new Event(Close, v, max[altDim]);
+        Node *v = new (nodePool.allocate()) Node(obstacle, mid);
+        events[ctr++] = new (eventPool.allocate()) Event(Open, v, min[altDim]);
+        events[ctr++] = new (eventPool.allocate()) Event(Close, v, max[altDim]);
 
         ++obstacleIt;
     }
@@ -2627,9 +3033,11 @@ static void buildOrthogonalChannelInfo(Router *router,
 
         COLA_ASSERT(lowPt[dim] == highPt[dim]);
         COLA_ASSERT(lowPt[altDim] < highPt[altDim]);
-        Node *v = new Node(*curr, lowPt[dim]);
-        events[ctr++] = new Event(SegOpen, v, lowPt[altDim]);
-        events[ctr++] = new Event(SegClose, v, highPt[altDim]);
+        Node *v = new (nodePool.allocate()) Node(*curr, lowPt[dim]);
+        events[ctr++] = new (eventPool.allocate())
+                Event(SegOpen, v, lowPt[altDim]);
+        events[ctr++] = new (eventPool.allocate())
+                Event(SegClose, v, highPt[altDim]);
     }
     qsort((Event*)events, (size_t) totalEvents, sizeof(Event*), compare_events);
 
@@ -2671,10 +3079,6 @@ static void buildOrthogonalChannelInfo(Router *router,
         processShiftEvent(scanline, events[i], dim, pass);
     }
     COLA_ASSERT(scanline.size() == 0);
-    for (unsigned i = 0; i < totalEvents; ++i)
-    {
-        delete events[i];
-    }
     delete [] events;
 }
 
@@ -2929,295 +3333,375 @@ static ShiftSegmentList linesort(ShiftSegmentList origList,
 typedef std::list<ShiftSegment *> ShiftSegmentPtrList;
 
 
-static void nudgeOrthogonalRoutes(Router *router, size_t dimension, 
-        PtOrderMap& pointOrders, ShiftSegmentList& segmentList)
+// Finds regions of segments that transitively overlap, each of which may be
+// nudged independently of the others.  Candidate pairs are found with a 
+// sweep over the segments' extents.  Regions, and the segments within them,
+// are put in the order the segments would be reached by repeatedly taking 
+// the first remaining segment in the list that overlaps the region so far.
+static void buildNudgingRegions(const ShiftSegmentList& segmentList,
+        const size_t dimension, std::vector<ShiftSegmentList>& regions)
 {
-    double baseSepDist = router->orthogonalNudgeDistance();
-    COLA_ASSERT(baseSepDist >= 0);
-    // If we can fit things with the desired separtation distance, then
-    // we try 10 times, reducing eac time by a 10th of the original amount.
-    double reductionSteps = 10.0;
+    std::vector<ShiftSegment *> segments(segmentList.begin(), 
+            segmentList.end());
+    const size_t n = segments.size();
+    const size_t altDim = (dimension + 1) % 2;
+
+    std::vector<std::pair<double, size_t> > sweepOrder(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        sweepOrder[i] = std::make_pair(segments[i]->lowPoint()[altDim], i);
+    }
+    std::sort(sweepOrder.begin(), sweepOrder.end());
 
-    // Do the actual nudging.
-    ShiftSegmentList currentRegion;
-    while (!segmentList.empty())
+    // joiners[i] lists the segments that overlap segment i, and so would
+    // join a region containing it.
+    std::vector<std::vector<size_t> > joiners(n);
+    std::vector<size_t> active;
+    for (size_t s = 0; s < n; ++s)
     {
-        // Take a reference segment
-        ShiftSegment *currentSegment = segmentList.front();
-        // Then, find the segments that overlap this one.
-        currentRegion.clear();
-        currentRegion.push_back(currentSegment);
-        segmentList.erase(segmentList.begin());
-        for (ShiftSegmentList::iterator curr = segmentList.begin();
-                curr != segmentList.end(); )
+        const size_t i = sweepOrder[s].second;
+        const double low = sweepOrder[s].first;
+        size_t kept = 0;
+        for (size_t a = 0; a < active.size(); ++a)
         {
-            bool overlaps = false;
-            for (ShiftSegmentList::iterator curr2 = currentRegion.begin();
-                    curr2 != currentRegion.end(); ++curr2)
+            const size_t j = active[a];
+            if (segments[j]->highPoint()[altDim] < low)
             {
-                if ((*curr)->overlapsWith(*curr2, dimension))
-                {
-                    overlaps = true;
-                    break;
-                }
+                // We've swept past this segment.
+                continue;
             }
-            if (overlaps)
+            active[kept++] = j;
+
+            if (segments[i]->overlapsWith(segments[j], dimension))
             {
-                currentRegion.push_back(*curr);
-                segmentList.erase(curr);
-                // Consider segments from the beginning, since we mave have
-                // since passed segments that overlap with the new set.
-                curr = segmentList.begin();
+                joiners[j].push_back(i);
             }
-            else
+            if (segments[j]->overlapsWith(segments[i], dimension))
             {
-                ++curr;
+                joiners[i].push_back(j);
             }
         }
+        active.resize(kept);
+        active.push_back(i);
+    }
 
-        if (!pointOrders.empty())
+    std::vector<bool> assigned(n, false);
+    std::priority_queue<size_t, std::vector<size_t>, 
+            std::greater<size_t> > frontier;
+    for (size_t first = 0; first < n; ++first)
+    {
+        if (assigned[first])
         {
-            CmpLineOrder lineSortComp(pointOrders, dimension);
-            currentRegion = linesort(currentRegion, lineSortComp);
+            continue;
         }
-
-        if (currentRegion.size() == 1)
+        regions.push_back(ShiftSegmentList());
+        ShiftSegmentList& region = regions.back();
+        assigned[first] = true;
+        frontier.push(first);
+        while (!frontier.empty())
         {
-            // Save creating the solver instance if there is just one
-            // immovable segment.
-            if (currentRegion.front()->immovable())
+            const size_t curr = frontier.top();
+            frontier.pop();
+            region.push_back(segments[curr]);
+            for (size_t k = 0; k < joiners[curr].size(); ++k)
             {
-                delete currentRegion.front();
-                continue;
+                const size_t joiner = joiners[curr][k];
+                if (!assigned[joiner])
+                {
+                    assigned[joiner] = true;
+                    frontier.push(joiner);
+                }
             }
         }
+    }
+}
+
+
+// Nudges the segments of a single region, returning the number of block
+// merges the solver performed.
+static long nudgeOrthogonalRegion(Router *router, size_t dimension,
+        const bool justCentring, ShiftSegmentList& currentRegion)
+{
+    double baseSepDist = router->orthogonalNudgeDistance();
+    COLA_ASSERT(baseSepDist >= 0);
+    // If we can fit things with the desired separtation distance, then
+    // we try 10 times, reducing eac time by a 10th of the original amount.
+    double reductionSteps = 10.0;
+
+    if (currentRegion.size() == 1)
+    {
+        // Save creating the solver instance if there is just one
+        // immovable segment.
+        if (currentRegion.front()->immovable())
+        {
+            delete currentRegion.front();
+            return 0;
+        }
+    }
 
-        // Process these segments.
-        Variables vs;
-        Constraints cs;
-        Constraints gapcs;
-        ShiftSegmentPtrList prevVars;
-        double sepDist = baseSepDist;
+    // Process these segments.
+    Variables vs;
+    Constraints cs;
+    Constraints gapcs;
+    ShiftSegmentPtrList prevVars;
+    double sepDist = baseSepDist;
 #ifdef NUDGE_DEBUG 
-        printf("-------------------------------------------------------\n");
-        printf("Nudge -- size: %d\n", (int) currentRegion.size());
+    printf("-------------------------------------------------------\n");
+    printf("Nudge -- size: %d\n", (int) currentRegion.size());
 #endif
-        ShiftSegmentList::iterator matchingConnSegment = currentRegion.end();
-        for (ShiftSegmentList::iterator currSegmentIt = currentRegion.begin();
-                currSegmentIt != currentRegion.end(); ++currSegmentIt )
+    ShiftSegmentList::iterator matchingConnSegment = currentRegion.end();
+    for (ShiftSegmentList::iterator currSegmentIt = currentRegion.begin();
+            currSegmentIt != currentRegion.end(); ++currSegmentIt )
+    {
+        if (matchingConnSegment != currentRegion.end())
         {
-            if (matchingConnSegment != currentRegion.end())
-            {
-                // If we have a segment that should be aligned with the last
-                // processed segment, then we take it out of order, inserting
-                // it at the current position. 
-                currentRegion.insert(currSegmentIt, *matchingConnSegment);
-                currentRegion.erase(matchingConnSegment);
-                --currSegmentIt;
-            }
-            NudgingShiftSegment *currSegment = dynamic_cast<NudgingShiftSegment *> (*currSegmentIt);
-            
-            // Create a solver variable for the position of this segment.
-            currSegment->createSolverVariable();
-            
-            if (pointOrders.empty())
-            {
-                // If we are just doing centring, then we should use the
-                // same weights, otherwise we might move overlapping paths
-                // a tiny distance apart if they have different weights.
-                currSegment->variable->weight = freeWeight;
-            }
+            // If we have a segment that should be aligned with the last
+            // processed segment, then we take it out of order, inserting
+            // it at the current position. 
+            currSegmentIt = currentRegion.insert(currSegmentIt, 
+                    *matchingConnSegment);
+            currentRegion.erase(matchingConnSegment);
+        }
+        NudgingShiftSegment *currSegment = dynamic_cast<NudgingShiftSegment *> (*currSegmentIt);
+        
+        // Create a solver variable for the position of this segment.
+        currSegment->createSolverVariable();
+        
+        if (justCentring)
+        {
+            // If we are just doing centring, then we should use the
+            // same weights, otherwise we might move overlapping paths
+            // a tiny distance apart if they have different weights.
+            currSegment->variable->weight = freeWeight;
+        }
 
-            vs.push_back(currSegment->variable);
-            size_t index = vs.size() - 1;
+        vs.push_back(currSegment->variable);
+        size_t index = vs.size() - 1;
 #ifdef NUDGE_DEBUG
-            fprintf(stderr,"line(%d)  %.15f  dim: %d pos: %g   min: %g  max: %g\n"
-                   "minEndPt: %g  maxEndPt: %g weight: %g\n",
-                    currSegment->connRef->id(),
-                    lowPt[dimension], (int) dimension, idealPos, 
-                    currSegment->minSpaceLimit, currSegment->maxSpaceLimit,
-                    lowPt[!dimension], currSegment->highPoint()[!dimension], weight);
+        fprintf(stderr,"line(%d)  %.15f  dim: %d pos: %g   min: %g  max: %g\n"
+               "minEndPt: %g  maxEndPt: %g weight: %g\n",
+                currSegment->connRef->id(),
+                lowPt[dimension], (int) dimension, idealPos, 
+                currSegment->minSpaceLimit, currSegment->maxSpaceLimit,
+                lowPt[!dimension], currSegment->highPoint()[!dimension], weight);
 #endif
 #if 0
-            // Debugging info:
-            double minP = std::max(currSegment->minSpaceLimit, -5000.0);
-            double maxP = std::min(currSegment->maxSpaceLimit, 5000.0);
-            fprintf(stdout, "<rect style=\"fill: #f00; opacity: 0.2;\" "
-                    "x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\" />\n",
-                    lowPt[XDIM], minP, 
-                    currSegment->highPoint()[XDIM] - lowPt[XDIM], 
-                    maxP - minP);
-            fprintf(stdout, "<line style=\"stroke: #000;\" x1=\"%g\" "
-                    "y1=\"%g\" x2=\"%g\" y2=\"%g\" />\n",
-                    lowPt[XDIM], lowPt[YDIM], currSegment->highPoint()[XDIM], 
-                    currSegment->highPoint()[YDIM]);
+        // Debugging info:
+        double minP = std::max(currSegment->minSpaceLimit, -5000.0);
+        double maxP = std::min(currSegment->maxSpaceLimit, 5000.0);
+        fprintf(stdout, "<rect style=\"fill: #f00; opacity: 0.2;\" "
+                "x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\" />\n",
+                lowPt[XDIM], minP, 
+                currSegment->highPoint()[XDIM] - lowPt[XDIM], 
+                maxP - minP);
+        fprintf(stdout, "<line style=\"stroke: #000;\" x1=\"%g\" "
+                "y1=\"%g\" x2=\"%g\" y2=\"%g\" />\n",
+                lowPt[XDIM], lowPt[YDIM], currSegment->highPoint()[XDIM], 
+                currSegment->highPoint()[YDIM]);
 #endif
 
-            if (pointOrders.empty())
-            {
-                // Just doing centring, not nudging.
-                // Thus, we don't need to constrain position.
-                prevVars.push_back(&(*currSegment));
-                continue;
-            }
+        if (justCentring)
+        {
+            // Just doing centring, not nudging.
+            // Thus, we don't need to constrain position.
+            prevVars.push_back(&(*currSegment));
+            continue;
+        }
 
-            // Constrain position in relation to previously seen segments,
-            // if necessary (i.e. when they could overlap).
-            for (ShiftSegmentPtrList::iterator prevVarIt = prevVars.begin();
-                    prevVarIt != prevVars.end(); ++prevVarIt)
-            {
-                NudgingShiftSegment *prevSeg =
-                        dynamic_cast<NudgingShiftSegment *> (*prevVarIt);
-                Variable *prevVar = prevSeg->variable;
+        // Constrain position in relation to previously seen segments,
+        // if necessary (i.e. when they could overlap).
+        for (ShiftSegmentPtrList::iterator prevVarIt = prevVars.begin();
+                prevVarIt != prevVars.end(); ++prevVarIt)
+        {
+            NudgingShiftSegment *prevSeg =
+                    dynamic_cast<NudgingShiftSegment *> (*prevVarIt);
+            Variable *prevVar = prevSeg->variable;
+            
+            if (currSegment->overlapsWith(prevSeg, dimension) &&
+                    (!(currSegment->fixed) || !(prevSeg->fixed)))
+            {
+                // If there is a previous segment to the left that 
+                // could overlap this in the shift direction, then 
+                // constrain the two segments to be separated.
+                // Though don't add the constraint if both the 
+                // segments are fixed in place.
+                double thisSepDist = sepDist;
+                bool equality = false;
+                if (currSegment->shouldAlignWith(prevSeg, dimension))
+                {
+                    // Handles the case where the two end segments can
+                    // be brought together to make a single segment. This
+                    // can help in situations where having the small kink
+                    // can restrict other kinds of nudging.
+                    thisSepDist = 0;
+                    equality = true;
+                }
+                else if (currSegment->connRef == prevSeg->connRef)
+                {
+                    // We need to address the problem of two neighbouring
+                    // segments of the same connector being kept separated
+                    // due only to a kink created in the other dimension.
+                    // Here, we let such segments drift back together.
+                    thisSepDist = 0;
+                }
                 
-                if (currSegment->overlapsWith(prevSeg, dimension) &&
-                        (!(currSegment->fixed) || !(prevSeg->fixed)))
-                {
-                    // If there is a previous segment to the left that 
-                    // could overlap this in the shift direction, then 
-                    // constrain the two segments to be separated.
-                    // Though don't add the constraint if both the 
-                    // segments are fixed in place.
-                    double thisSepDist = sepDist;
-                    bool equality = false;
-                    if (currSegment->shouldAlignWith(prevSeg, dimension))
-                    {
-                        // Handles the case where the two end segments can
-                        // be brought together to make a single segment. This
-                        // can help in situations where having the small kink
-                        // can restrict other kinds of nudging.
-                        thisSepDist = 0;
-                        equality = true;
-                    }
-                    else if (currSegment->connRef == prevSeg->connRef)
-                    {
-                        // We need to address the problem of two neighbouring
-                        // segments of the same connector being kept separated
-                        // due only to a kink created in the other dimension.
-                        // Here, we let such segments drift back together.
-                        thisSepDist = 0;
-                    }
-                    
-                    Constraint *constraint = new Constraint(prevVar, 
-                            vs[index], thisSepDist, equality);
-                    cs.push_back(constraint);
-                    if (thisSepDist)
-                    {
-                        // Add to the list of gap constraints so we can 
-                        // rewrite the separation distance later.
-                        gapcs.push_back(constraint);
-                    }
+                Constraint *constraint = new Constraint(prevVar, 
+                        vs[index], thisSepDist, equality);
+                cs.push_back(constraint);
+                if (thisSepDist)
+                {
+                    // Add to the list of gap constraints so we can 
+                    // rewrite the separation distance later.
+                    gapcs.push_back(constraint);
                 }
             }
+        }
 
-            if (!currSegment->fixed)
+        if (!currSegment->fixed)
+        {
+            // If this segment sees a channel boundary to its left,
+            // then constrain its placement as such.
+            if (currSegment->minSpaceLimit > -CHANNEL_MAX)
             {
-                // If this segment sees a channel boundary to its left,
-                // then constrain its placement as such.
-                if (currSegment->minSpaceLimit > -CHANNEL_MAX)
-                {
-                    vs.push_back(new Variable(fixedID,
-                                currSegment->minSpaceLimit, fixedWeight));
-                    cs.push_back(new Constraint(vs[vs.size() - 1], vs[index],
-                                0.0));
-                }
+                vs.push_back(new Variable(fixedID,
+                            currSegment->minSpaceLimit, fixedWeight));
+                cs.push_back(new Constraint(vs[vs.size() - 1], vs[index],
+                            0.0));
+            }
 
-                // If this segment sees a channel boundary to its right,
-                // then constrain its placement as such.
-                if (currSegment->maxSpaceLimit < CHANNEL_MAX)
-                {
-                    vs.push_back(new Variable(fixedID,
-                                currSegment->maxSpaceLimit, fixedWeight));
-                    cs.push_back(new Constraint(vs[index], vs[vs.size() - 1],
-                                0.0));
-                }
+            // If this segment sees a channel boundary to its right,
+            // then constrain its placement as such.
+            if (currSegment->maxSpaceLimit < CHANNEL_MAX)
+            {
+                vs.push_back(new Variable(fixedID,
+                            currSegment->maxSpaceLimit, fixedWeight));
+                cs.push_back(new Constraint(vs[index], vs[vs.size() - 1],
+                            0.0));
             }
+        }
 
-            prevVars.push_back(&(*currSegment));
+        prevVars.push_back(&(*currSegment));
 
-            // Here we look for segments that should be aligned with the 
-            // current segment.  We record a reference to them here so that
-            // we may load them out of order.
-            matchingConnSegment = currentRegion.end();
-            if (currSegment->finalSegment)
+        // Here we look for segments that should be aligned with the 
+        // current segment.  We record a reference to them here so that
+        // we may load them out of order.
+        matchingConnSegment = currentRegion.end();
+        if (currSegment->finalSegment)
+        {
+            for (ShiftSegmentList::iterator matchingSegment = currSegmentIt;
+                    matchingSegment != currentRegion.end(); ++matchingSegment)
             {
-                for (ShiftSegmentList::iterator matchingSegment = currSegmentIt;
-                        matchingSegment != currentRegion.end(); ++matchingSegment)
+                if (matchingSegment == currSegmentIt)
                 {
-                    if (matchingSegment == currSegmentIt)
-                    {
-                        continue;
-                    }
-                    if ((*matchingSegment)->shouldAlignWith(currSegment, dimension))
-                    {
-                        matchingConnSegment = matchingSegment;
-                    }
+                    continue;
+                }
+                if ((*matchingSegment)->shouldAlignWith(currSegment, dimension))
+                {
+                    matchingConnSegment = matchingSegment;
                 }
             }
         }
+    }
 #ifdef NUDGE_DEBUG
-        for (unsigned i = 0;i < vs.size(); ++i)
-        {
-            printf("-vs[%d]=%f\n", i, vs[i]->desiredPosition);
-        }
+    for (unsigned i = 0;i < vs.size(); ++i)
+    {
+        printf("-vs[%d]=%f\n", i, vs[i]->desiredPosition);
+    }
 #endif
-        // Repeatedly try solving this with smaller separation distances till
-        // we find a solution that is satisfied.
-        bool satisfied;
-        do 
+    // Repeatedly try solving this with smaller separation distances till
+    // we find a solution that is satisfied.
+    bool satisfied;
+    long blocksMerged = 0;
+    do 
+    {
+        IncSolver f(vs,cs);
+        f.solve();
+        blocksMerged += f.blocksMerged();
+        satisfied = true;
+        for (size_t i = 0; i < vs.size(); ++i) 
         {
-            IncSolver f(vs,cs);
-            f.solve();
-            satisfied = true;
-            for (size_t i = 0; i < vs.size(); ++i) 
+            if (vs[i]->id == fixedID)
             {
-                if (vs[i]->id == fixedID)
+                if (fabs(vs[i]->finalPosition - 
+                        vs[i]->desiredPosition) > 0.01)
                 {
-                    if (fabs(vs[i]->finalPosition - 
-                            vs[i]->desiredPosition) > 0.01)
-                    {
-                        satisfied = false;
-                        break;
-                    }
+                    satisfied = false;
+                    break;
                 }
             }
+        }
 
-            if (!satisfied)
+        if (!satisfied)
+        {
+            // Reduce the separation distance.
+            sepDist -= (baseSepDist / reductionSteps);
+            // And rewrite all the gap constraints to have the new reduced
+            // separation distance.
+            for (Constraints::iterator cIt = gapcs.begin(); 
+                    cIt != gapcs.end(); ++cIt)
             {
-                // Reduce the separation distance.
-                sepDist -= (baseSepDist / reductionSteps);
-                // And rewrite all the gap constraints to have the new reduced
-                // separation distance.
-                for (Constraints::iterator cIt = gapcs.begin(); 
-                        cIt != gapcs.end(); ++cIt)
-                {
-                    Constraint *constraint = *cIt;
-                    constraint->gap = sepDist;
-                }
+                Constraint *constraint = *cIt;
+                constraint->gap = sepDist;
             }
         }
-        while (!satisfied && (sepDist > 0.0001));
+    }
+    while (!satisfied && (sepDist > 0.0001));
 
-        if (satisfied)
+    if (satisfied)
+    {
+        for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
+                currSegment != currentRegion.end(); ++currSegment)
         {
-            for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
-                    currSegment != currentRegion.end(); ++currSegment)
-            {
-                NudgingShiftSegment *segment =
-                        dynamic_cast<NudgingShiftSegment *> (*currSegment);
+            NudgingShiftSegment *segment =
+                    dynamic_cast<NudgingShiftSegment *> (*currSegment);
 
-                segment->updatePositionsFromSolver();
-            }
+            segment->updatePositionsFromSolver();
         }
-        for_each(currentRegion.begin(), currentRegion.end(), delete_object());
+    }
+    for_each(currentRegion.begin(), currentRegion.end(), delete_object());
 #ifdef NUDGE_DEBUG
-        for(unsigned i=0;i<vs.size();i++) {
-            printf("+vs[%d]=%f\n",i,vs[i]->finalPosition);
-        }
+    for(unsigned i=0;i<vs.size();i++) {
+        printf("+vs[%d]=%f\n",i,vs[i]->finalPosition);
+    }
 #endif
-        for_each(vs.begin(), vs.end(), delete_object());
-        for_each(cs.begin(), cs.end(), delete_object());
+    for_each(vs.begin(), vs.end(), delete_object());
+    for_each(cs.begin(), cs.end(), delete_object());
+    return blocksMerged;
+}
+
+
+static void nudgeOrthogonalRoutes(Router *router, size_t dimension, 
+        PtOrderMap& pointOrders, ShiftSegmentList& segmentList)
+{
+    std::vector<ShiftSegmentList> regions;
+    buildNudgingRegions(segmentList, dimension, regions);
+    segmentList.clear();
+
+    if (!pointOrders.empty())
+    {
+        // This reads and updates the point orders, so sort every region 
+        // before any are solved.
+        CmpLineOrder lineSortComp(pointOrders, dimension);
+        for (size_t r = 0; r < regions.size(); ++r)
+        {
+            regions[r] = linesort(regions[r], lineSortComp);
+        }
+    }
+
+    // Do the actual nudging.  The regions are separate problems that move
+    // different points, so can be solved on multiple threads.
+    const bool justCentring = pointOrders.empty();
+    const int regionCount = (int) regions.size();
+    long blocksMerged = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:blocksMerged) \
+        if (regionCount > 1)
+    for (int r = 0; r < regionCount; ++r)
+    {
+        blocksMerged += nudgeOrthogonalRegion(router, dimension, 
+                justCentring, regions[r]);
     }
+    router->statisticsRef().addToCounter(vpscBlocksMergedCounter, 
+            blocksMerged);
 }
 
 extern void improveOrthogonalRoutes(Router *router)
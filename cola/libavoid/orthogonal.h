@@ -29,7 +29,16 @@
 namespace Avoid {
 
 
-extern void generateStaticOrthogonalVisGraph(Router *router);
+// Generates the orthogonal visibility graph.  If segments is given, the
+// visibility segments it is built from are recorded there.
+extern void generateStaticOrthogonalVisGraph(Router *router,
+        OrthogonalVisGraphSegments *segments = NULL);
+// Updates the orthogonal visibility graph generated from segments, given 
+// the bounding boxes of the obstacles and connector endpoints that have 
+// changed, at both their old and new positions.
+extern void updateStaticOrthogonalVisGraph(Router *router,
+        const std::vector<BBox>& changes, 
+        OrthogonalVisGraphSegments& segments);
 extern void improveOrthogonalRoutes(Router *router);
 extern void improveHyperedgeRoutes(Router *router);
 
@@ -0,0 +1,176 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the 
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+*/
+
+#include <new>
+
+#include "libavoid/pool.h"
+#include "libavoid/assertions.h"
+
+
+namespace Avoid {
+
+
+// Rounds size up so blocks and the objects placed in them stay aligned 
+// for any type.
+static size_t alignedSize(const size_t size)
+{
+    const size_t alignment = 2 * sizeof(double);
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+
+MemoryPool::MemoryPool(const size_t blockSize, const size_t blocksPerChunk)
+    : m_block_size(alignedSize(blockSize)),
+      m_blocks_per_chunk(blocksPerChunk),
+      m_chunk_used(blocksPerChunk),
+      m_free_list(NULL),
+      m_in_use(0)
+{
+    COLA_ASSERT(blocksPerChunk > 0);
+}
+
+
+MemoryPool::~MemoryPool()
+{
+    reset();
+}
+
+
+void MemoryPool::reset(void)
+{
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        ::operator delete(m_chunks[i]);
+    }
+    m_chunks.clear();
+    m_chunk_used = m_blocks_per_chunk;
+    m_free_list = NULL;
+    m_in_use = 0;
+}
+
+
+void *MemoryPool::allocate(void)
+{
+    ++m_in_use;
+    if (m_free_list)
+    {
+        void *block = m_free_list;
+        m_free_list = *(static_cast<void **> (block));
+        return block;
+    }
+    if (m_chunk_used == m_blocks_per_chunk)
+    {
+        m_chunks.push_back(static_cast<char *> (
+                ::operator new(m_block_size * m_blocks_per_chunk)));
+        m_chunk_used = 0;
+    }
+    return m_chunks.back() + (m_block_size * m_chunk_used++);
+}
+
+
+void MemoryPool::deallocate(void *block)
+{
+    COLA_ASSERT(m_in_use > 0);
+    --m_in_use;
+    *(static_cast<void **> (block)) = m_free_list;
+    m_free_list = block;
+}
+
+
+size_t MemoryPool::blockSize(void) const
+{
+    return m_block_size;
+}
+
+
+size_t MemoryPool::blocksInUse(void) const
+{
+    return m_in_use;
+}
+
+
+size_t MemoryPool::chunkCount(void) const
+{
+    return m_chunks.size();
+}
+
+
+//===========================================================================
+
+
+// The pool an object was allocated from is stored in a header just before
+// the object.
+static const size_t pooledHeaderSize = alignedSize(sizeof(MemoryPool *));
+
+
+size_t pooledObjectBlockSize(const size_t objectSize)
+{
+    return pooledHeaderSize + objectSize;
+}
+
+
+void *allocatePooledObject(const size_t objectSize, MemoryPool *pool)
+{
+    char *block = NULL;
+    if (pool)
+    {
+        COLA_ASSERT(pooledObjectBlockSize(objectSize) <= pool->blockSize());
+        block = static_cast<char *> (pool->allocate());
+    }
+    else
+    {
+        block = static_cast<char *> (
+                ::operator new(pooledObjectBlockSize(objectSize)));
+    }
+    *(reinterpret_cast<MemoryPool **> (block)) = pool;
+    return block + pooledHeaderSize;
+}
+
+
+MemoryPool *pooledObjectPool(const void *object)
+{
+    const char *block = static_cast<const char *> (object) - pooledHeaderSize;
+    return *(reinterpret_cast<MemoryPool * const *> (block));
+}
+
+
+void freePooledObject(void *object)
+{
+    if (object == NULL)
+    {
+        return;
+    }
+    char *block = static_cast<char *> (object) - pooledHeaderSize;
+    MemoryPool *pool = *(reinterpret_cast<MemoryPool **> (block));
+    if (pool)
+    {
+        pool->deallocate(block);
+    }
+    else
+    {
+        ::operator delete(block);
+    }
+}
+
+
+}
+
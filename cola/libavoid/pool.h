@@ -0,0 +1,111 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the 
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+*/
+
+#ifndef AVOID_POOL_H
+#define AVOID_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+
+namespace Avoid {
+
+
+// This class is not intended for public use.
+// It hands out fixed-size blocks of memory carved from large chunks, 
+// avoiding a separate heap allocation for each of the many small objects
+// created while building the orthogonal visibility graph.  Blocks given
+// back with deallocate() are reused by later allocations.  All the chunks
+// are released together when the pool is reset or destroyed, so a pool 
+// can also be used as an arena for objects that are destroyed but never
+// individually deallocated.
+//
+// A pool must not be used from more than one thread at once.
+//
+class MemoryPool
+{
+    public:
+        MemoryPool(const size_t blockSize, 
+                const size_t blocksPerChunk = 1024);
+        ~MemoryPool();
+
+        void *allocate(void);
+        void deallocate(void *block);
+        // Releases every chunk, giving the pool's memory back to the heap.
+        // Any objects in its blocks must already have been destroyed.
+        void reset(void);
+        size_t blockSize(void) const;
+        // Returns the number of blocks currently allocated.
+        size_t blocksInUse(void) const;
+        size_t chunkCount(void) const;
+
+    private:
+        // Pools own their chunks, so are not copied.
+        MemoryPool(const MemoryPool& other);
+        MemoryPool& operator=(const MemoryPool& other);
+
+        size_t m_block_size;
+        size_t m_blocks_per_chunk;
+        std::vector<char *> m_chunks;
+        // Number of blocks handed out from the last chunk.
+        size_t m_chunk_used;
+        void *m_free_list;
+        size_t m_in_use;
+};
+
+
+// For classes whose objects may be placed in a MemoryPool.  Such classes 
+// define operator new and delete to call these functions, which record 
+// the pool (if any) the object came from just before the object, so it 
+// can be given back to the same pool when deleted.
+//
+// Returns the block size for pooled objects of the given size.
+extern size_t pooledObjectBlockSize(const size_t objectSize);
+// Allocates memory for an object of the given size from pool, or from 
+// the heap if pool is NULL.
+extern void *allocatePooledObject(const size_t objectSize, MemoryPool *pool);
+extern void freePooledObject(void *object);
+// Returns the pool the object was allocated from, or NULL if it was 
+// allocated from the heap.
+extern MemoryPool *pooledObjectPool(const void *object);
+
+
+// Destroys an object placed in a pool without giving its block back, for
+// when the pool is about to be reset.  Objects from the heap are deleted.
+// Returns whether the object was in a pool.
+template <typename T>
+bool destroyPooledObject(T *object)
+{
+    if (pooledObjectPool(object) == NULL)
+    {
+        delete object;
+        return false;
+    }
+    object->~T();
+    return true;
+}
+
+
+}
+
+
+#endif
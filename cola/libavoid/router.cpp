@@ -25,6 +25,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <set>
 
 #include "libavoid/shape.h"
 #include "libavoid/router.h"
@@ -67,7 +69,8 @@ class ActionInfo {
         }
         ActionInfo(ActionType t, ShapeRef *s)
             : type(t),
-              objPtr(s)
+              objPtr(s),
+              firstMove(false)
 
         {
             COLA_ASSERT((type == ShapeAdd) || (type == ShapeRemove) ||
@@ -76,26 +79,30 @@ class ActionInfo {
         ActionInfo(ActionType t, JunctionRef *j, const Point& p)
             : type(t),
               objPtr(j),
-              newPosition(p)
+              newPosition(p),
+              firstMove(false)
         {
             COLA_ASSERT(type == JunctionMove);
         }
         ActionInfo(ActionType t, JunctionRef *j)
             : type(t),
-              objPtr(j)
+              objPtr(j),
+              firstMove(false)
         {
             COLA_ASSERT((type == JunctionAdd) || (type == JunctionRemove) ||
                     (type == JunctionMove));
         }
         ActionInfo(ActionType t, ConnRef *c)
             : type(t),
-              objPtr(c)
+              objPtr(c),
+              firstMove(false)
         {
             COLA_ASSERT(type == ConnChange);
         }
         ActionInfo(ActionType t, ShapeConnectionPin *p)
             : type(t),
-              objPtr(p)
+              objPtr(p),
+              firstMove(false)
         {
             COLA_ASSERT(type == ConnectionPinChange);
         }
@@ -159,7 +166,9 @@ class ActionInfo {
 
 
 Router::Router(const unsigned int flags)
-    : visOrthogGraph(true),
+    : vertInfPool(pooledObjectBlockSize(sizeof(VertInf))),
+      edgeInfPool(pooledObjectBlockSize(sizeof(EdgeInf))),
+      visOrthogGraph(true),
       PartialTime(false),
       SimpleRouting(false),
       ClusteredRouting(true),
@@ -206,6 +215,11 @@ Router::Router(const unsigned int flags)
     _routingPenalties[portDirectionPenalty] = 100;
     _routingOptions[nudgeOrthogonalSegmentsConnectedToShapes] = false;
     _routingOptions[improveHyperedgeRoutesMovingJunctions] = true;
+    _routingOptions[searchConnectorPathsInParallel] = false;
+    _routingOptions[searchConnectorPathsFromSharedSources] = false;
+    _routingOptions[searchConnectorPathsBidirectionally] = false;
+    _routingOptions[updateOrthogonalVisGraphIncrementally] = false;
+    _routingOptions[verifyOrthogonalVisGraphUpdates] = false;
       
     m_hyperedge_rerouter.setRouter(this);
 }
@@ -452,22 +466,255 @@ void Router::setStaticGraphInvalidated(const bool invalidated)
 
 void Router::destroyOrthogonalVisGraph(void)
 {
+    // The edges and dummy vertices of the graph are nearly all in the 
+    // pools, so rather than give each block back they are just destroyed
+    // and the pools are then reset, releasing their memory all at once.
+
     // Remove orthogonal visibility graph edges.
-    visOrthogGraph.clear();
+    visOrthogGraphSnapshot.clear();
+    m_orthog_graph_segments.clear();
+    size_t pooledEdges = 0;
+    while (visOrthogGraph.begin() != visOrthogGraph.end())
+    {
+        pooledEdges += destroyPooledObject(visOrthogGraph.begin());
+    }
+    COLA_ASSERT(pooledEdges == edgeInfPool.blocksInUse());
+    if (pooledEdges == edgeInfPool.blocksInUse())
+    {
+        edgeInfPool.reset();
+    }
 
     // Remove the now orphaned vertices.
+    size_t pooledVertices = 0;
     VertInf *curr = vertices.shapesBegin();
     while (curr)
     {
         if (curr->orphaned() && (curr->id == dummyOrthogID))
         {
             VertInf *following = vertices.removeVertex(curr);
-            delete curr;
+            pooledVertices += destroyPooledObject(curr);
             curr = following;
             continue;
         }
         curr = curr->lstNext;
     }
+    COLA_ASSERT(pooledVertices == vertInfPool.blocksInUse());
+    if (pooledVertices == vertInfPool.blocksInUse())
+    {
+        vertInfPool.reset();
+    }
+}
+
+
+static bool isPinConnectionVertex(const VertInf *vert)
+{
+    return vert->id.isConnPt() && (vert->visDirections == ConnDirNone);
+}
+
+
+// Returns the set of orthogonal visibility graph edges, seen from each 
+// end.  Edges given to connector endpoints attached to connection pins are
+// ignored, since these are not part of the static graph.
+static std::multiset<std::pair<Point, Point> > orthogonalVisGraphEdges(
+        VertInfList& vertices)
+{
+    std::multiset<std::pair<Point, Point> > edges;
+    for (VertInf *curr = vertices.connsBegin(); curr != vertices.end();
+            curr = curr->lstNext)
+    {
+        if (isPinConnectionVertex(curr))
+        {
+            continue;
+        }
+        for (EdgeInfList::const_iterator edge = curr->orthogVisList.begin();
+                edge != curr->orthogVisList.end(); ++edge)
+        {
+            VertInf *other = (*edge)->otherVert(curr);
+            if (!isPinConnectionVertex(other))
+            {
+                edges.insert(std::make_pair(curr->point, other->point));
+            }
+        }
+    }
+    return edges;
+}
+
+
+bool OrthogonalVisGraphInputs::ObstacleInput::operator==(
+        const ObstacleInput& rhs) const
+{
+    return (id == rhs.id) && (freeJunction == rhs.freeJunction) &&
+            (min == rhs.min) && (max == rhs.max);
+}
+
+
+bool OrthogonalVisGraphInputs::VertexInput::operator==(
+        const VertexInput& rhs) const
+{
+    return (order == rhs.order) && (point == rhs.point) &&
+            (visDirections == rhs.visDirections) && 
+            (visEdges == rhs.visEdges);
+}
+
+
+void OrthogonalVisGraphInputs::clear(void)
+{
+    obstacles.clear();
+    vertices.clear();
+}
+
+
+bool OrthogonalVisGraphInputs::operator==(
+        const OrthogonalVisGraphInputs& rhs) const
+{
+    return (obstacles == rhs.obstacles) && (vertices == rhs.vertices);
+}
+
+
+// Records everything the orthogonal visibility graph is built from: the 
+// bounding boxes of obstacles and the connector endpoints given visibility.
+void Router::orthogonalVisGraphInputs(OrthogonalVisGraphInputs& inputs)
+{
+    inputs.clear();
+    for (ObstacleList::const_iterator curr = m_obstacles.begin();
+            curr != m_obstacles.end(); ++curr)
+    {
+        JunctionRef *junction = dynamic_cast<JunctionRef *> (*curr);
+        OrthogonalVisGraphInputs::ObstacleInput obstacle;
+        obstacle.id = (*curr)->id();
+        obstacle.freeJunction = junction && !junction->positionFixed();
+        (*curr)->polygon().getBoundingRect(&obstacle.min.x, &obstacle.min.y,
+                &obstacle.max.x, &obstacle.max.y);
+        inputs.obstacles.push_back(obstacle);
+    }
+    for (VertInf *curr = vertices.connsBegin(); curr != vertices.end();
+            curr = curr->lstNext)
+    {
+        if ((curr->id == dummyOrthogID) || (curr->id == dummyOrthogShapeID) ||
+                isPinConnectionVertex(curr))
+        {
+            continue;
+        }
+        OrthogonalVisGraphInputs::VertexInput vertex;
+        vertex.order = curr->lstOrder;
+        vertex.point = curr->point;
+        vertex.visDirections = curr->visDirections;
+        vertex.visEdges = 0;
+        if (curr->id.isConnPt() && !curr->id.isConnectionPin())
+        {
+            vertex.visEdges = curr->orthogVisListSize;
+        }
+        inputs.vertices.push_back(vertex);
+    }
+}
+
+
+void OrthogonalVisGraphSegments::clear(void)
+{
+    horizontal.clear();
+    vertical.clear();
+}
+
+
+bool OrthogonalVisGraphSegments::empty(void) const
+{
+    return horizontal.empty() && vertical.empty();
+}
+
+
+static void addChangedBox(std::vector<BBox>& changes, const Point& min,
+        const Point& max)
+{
+    BBox box;
+    box.a = min;
+    box.b = max;
+    changes.push_back(box);
+}
+
+
+// Adds to changes the bounding boxes, at both their old and new positions,
+// of the obstacles and vertices that differ between the inputs the 
+// orthogonal visibility graph was built from and those it is now to be 
+// built from.  Returns the number of obstacles and vertices that differ.
+static size_t orthogonalVisGraphChanges(
+        const OrthogonalVisGraphInputs& oldInputs,
+        const OrthogonalVisGraphInputs& newInputs, std::vector<BBox>& changes)
+{
+    typedef OrthogonalVisGraphInputs::ObstacleInput ObstacleInput;
+    typedef OrthogonalVisGraphInputs::VertexInput VertexInput;
+    size_t changed = 0;
+
+    // Junctions that are free to move are not obstacles, so are treated as
+    // if they were absent.
+    std::map<unsigned int, const ObstacleInput *> oldObstacles;
+    for (size_t i = 0; i < oldInputs.obstacles.size(); ++i)
+    {
+        if (!oldInputs.obstacles[i].freeJunction)
+        {
+            oldObstacles[oldInputs.obstacles[i].id] = &oldInputs.obstacles[i];
+        }
+    }
+    for (size_t i = 0; i < newInputs.obstacles.size(); ++i)
+    {
+        const ObstacleInput& obstacle = newInputs.obstacles[i];
+        if (obstacle.freeJunction)
+        {
+            continue;
+        }
+        std::map<unsigned int, const ObstacleInput *>::iterator old =
+                oldObstacles.find(obstacle.id);
+        if (old != oldObstacles.end())
+        {
+            if (*(old->second) == obstacle)
+            {
+                oldObstacles.erase(old);
+                continue;
+            }
+            addChangedBox(changes, old->second->min, old->second->max);
+            oldObstacles.erase(old);
+        }
+        addChangedBox(changes, obstacle.min, obstacle.max);
+        ++changed;
+    }
+    for (std::map<unsigned int, const ObstacleInput *>::iterator old = 
+            oldObstacles.begin(); old != oldObstacles.end(); ++old)
+    {
+        // Removed obstacles.
+        addChangedBox(changes, old->second->min, old->second->max);
+        ++changed;
+    }
+
+    std::map<long, const VertexInput *> oldVertices;
+    for (size_t i = 0; i < oldInputs.vertices.size(); ++i)
+    {
+        oldVertices[oldInputs.vertices[i].order] = &oldInputs.vertices[i];
+    }
+    for (size_t i = 0; i < newInputs.vertices.size(); ++i)
+    {
+        const VertexInput& vertex = newInputs.vertices[i];
+        std::map<long, const VertexInput *>::iterator old =
+                oldVertices.find(vertex.order);
+        if (old != oldVertices.end())
+        {
+            if (*(old->second) == vertex)
+            {
+                oldVertices.erase(old);
+                continue;
+            }
+            addChangedBox(changes, old->second->point, old->second->point);
+            oldVertices.erase(old);
+        }
+        addChangedBox(changes, vertex.point, vertex.point);
+        ++changed;
+    }
+    for (std::map<long, const VertexInput *>::iterator old = 
+            oldVertices.begin(); old != oldVertices.end(); ++old)
+    {
+        // Removed vertices.
+        addChangedBox(changes, old->second->point, old->second->point);
+        ++changed;
+    }
+    return changed;
 }
 
 
@@ -477,17 +724,66 @@ void Router::regenerateStaticBuiltGraph(void)
     // graph (if necessary) before we do any routing.
     if (_staticGraphInvalidated)
     {
+        m_statistics.startPhase(visibilityGraphPhase);
         if (_orthogonalRouting)
         {
-            destroyOrthogonalVisGraph();
+            // The graph only needs regenerating if something it was built
+            // from has changed, and then may just be updated where things
+            // have changed.
+            OrthogonalVisGraphInputs inputs;
+            orthogonalVisGraphInputs(inputs);
+            const bool incremental = 
+                    routingOption(updateOrthogonalVisGraphIncrementally);
+            bool reuseGraph = (inputs == m_orthog_graph_inputs);
+            bool updateGraph = false;
+            std::vector<BBox> changes;
+            if (!reuseGraph && incremental && !m_orthog_graph_segments.empty())
+            {
+                size_t changed = orthogonalVisGraphChanges(
+                        m_orthog_graph_inputs, inputs, changes);
+                size_t total = inputs.obstacles.size() + inputs.vertices.size();
+                // Updating the graph for a lot of changes is slower than
+                // regenerating it.
+                updateGraph = (changed * 10 <= total);
+            }
 
             timers.Register(tmOrthogGraph, timerStart);
-            // Regenerate a new visibility graph.
-            generateStaticOrthogonalVisGraph(this);
-            
+            if (updateGraph)
+            {
+                updateStaticOrthogonalVisGraph(this, changes,
+                        m_orthog_graph_segments);
+                orthogonalVisGraphInputs(m_orthog_graph_inputs);
+                visOrthogGraphSnapshot.build(vertices, visOrthogGraph);
+            }
+
+            std::multiset<std::pair<Point, Point> > keptEdges;
+            bool verifyGraph = (reuseGraph || updateGraph) &&
+                    routingOption(verifyOrthogonalVisGraphUpdates);
+            if (verifyGraph)
+            {
+                keptEdges = orthogonalVisGraphEdges(vertices);
+            }
+
+            if ((!reuseGraph && !updateGraph) || verifyGraph)
+            {
+                destroyOrthogonalVisGraph();
+
+                // Regenerate a new visibility graph.
+                generateStaticOrthogonalVisGraph(this,
+                        (incremental) ? &m_orthog_graph_segments : NULL);
+
+                orthogonalVisGraphInputs(m_orthog_graph_inputs);
+                visOrthogGraphSnapshot.build(vertices, visOrthogGraph);
+                if (verifyGraph)
+                {
+                    COLA_ASSERT(keptEdges == 
+                            orthogonalVisGraphEdges(vertices));
+                }
+            }
             timers.Stop();
         }
         _staticGraphInvalidated = false;
+        m_statistics.stopPhase(visibilityGraphPhase);
     }
 }
 
@@ -517,6 +813,9 @@ bool Router::processTransaction(void)
         return false;
     }
 
+    m_statistics.addToCounter(transactionsCounter, 1);
+    m_statistics.startPhase(visibilityGraphPhase);
+
     actionList.sort();
     ActionInfoList::iterator curr;
     ActionInfoList::iterator finish = actionList.end();
@@ -671,6 +970,7 @@ bool Router::processTransaction(void)
     }
     // Clear the actionList.
     actionList.clear();
+    m_statistics.stopPhase(visibilityGraphPhase);
     
     _staticGraphInvalidated = true;
     rerouteAndCallbackConnectors();
@@ -940,6 +1240,95 @@ void Router::attachedShapes(IntList &shapes, const unsigned int shapeId,
 }
 
 
+// Divides the connectors into groups whose paths are found by one search.
+// If sharedSearch is set, then connectors starting from equivalent source
+// vertices are grouped together, otherwise each connector is searched for
+// alone.  The groups are given by indexes into conns.
+//
+static void groupIsolatedSearches(const std::vector<ConnRef *>& conns,
+        const bool sharedSearch, std::vector<std::vector<size_t> >& groups)
+{
+    groups.clear();
+    if (!sharedSearch)
+    {
+        groups.resize(conns.size());
+        for (size_t c = 0; c < conns.size(); ++c)
+        {
+            groups[c].push_back(c);
+        }
+        return;
+    }
+
+    // Only connectors starting at the same point need to be compared.
+    typedef std::map<Point, std::vector<size_t> > GroupsAtPoint;
+    GroupsAtPoint groupsAtPoint;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        std::vector<size_t>& pointGroups = 
+                groupsAtPoint[conns[c]->src()->point];
+        bool grouped = false;
+        for (size_t g = 0; g < pointGroups.size(); ++g)
+        {
+            std::vector<size_t>& group = groups[pointGroups[g]];
+            if (equivalentSearchSources(conns[group[0]], conns[c]))
+            {
+                group.push_back(c);
+                grouped = true;
+                break;
+            }
+        }
+        if (!grouped)
+        {
+            pointGroups.push_back(groups.size());
+            groups.push_back(std::vector<size_t>(1, c));
+        }
+    }
+}
+
+
+// Removes the groups of just one connector, and those connectors, keeping
+// the remaining connectors in order.
+//
+static void removeUnsharedSearches(std::vector<ConnRef *>& conns,
+        std::vector<std::vector<size_t> >& groups)
+{
+    std::vector<bool> shared(conns.size(), false);
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        for (size_t c = 0; (groups[g].size() > 1) && 
+                (c < groups[g].size()); ++c)
+        {
+            shared[groups[g][c]] = true;
+        }
+    }
+    std::vector<size_t> newIndex(conns.size());
+    size_t sharedCount = 0;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        newIndex[c] = sharedCount;
+        if (shared[c])
+        {
+            conns[sharedCount++] = conns[c];
+        }
+    }
+    conns.resize(sharedCount);
+
+    size_t groupCount = 0;
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        if (groups[g].size() > 1)
+        {
+            for (size_t c = 0; c < groups[g].size(); ++c)
+            {
+                groups[g][c] = newIndex[groups[g][c]];
+            }
+            groups[groupCount++].swap(groups[g]);
+        }
+    }
+    groups.resize(groupCount);
+}
+
+
     // It's intended this function is called after visibility changes 
     // resulting from shape movement have happened.  It will alert 
     // rerouted connectors (via a callback) that they need to be redrawn.
@@ -964,6 +1353,78 @@ void Router::rerouteAndCallbackConnectors(void)
             m_hyperedge_rerouter.calcHyperedgeConnectors();
 
     timers.Register(tmOrthogRoute, timerStart);
+    m_statistics.startPhase(pathSearchPhase);
+
+    // If requested, search for the paths of connectors that don't need to
+    // modify the visibility graph in parallel, or together with those of
+    // other connectors starting from the same point, first.  These paths
+    // are then used when generating the connector routes below, in 
+    // connector order.
+    std::vector<ConnRef *> isolatedConns;
+    std::vector<std::vector<VertInf *> > isolatedPaths;
+    const bool parallelSearch = routingOption(searchConnectorPathsInParallel);
+    const bool sharedSearch = 
+            routingOption(searchConnectorPathsFromSharedSources) &&
+            connectorsCanShareSearch(this);
+    if (parallelSearch || sharedSearch)
+    {
+        for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i)
+        {
+            if ((hyperedgeConns.find(*i) == hyperedgeConns.end()) &&
+                    (*i)->canSearchPathIsolated())
+            {
+                isolatedConns.push_back(*i);
+            }
+        }
+        // Each search is for a group of connectors, given by their indexes
+        // in isolatedConns.
+        std::vector<std::vector<size_t> > searchGroups;
+        groupIsolatedSearches(isolatedConns, sharedSearch, searchGroups);
+        if (!parallelSearch)
+        {
+            // Only the shared searches are worth doing in advance.
+            removeUnsharedSearches(isolatedConns, searchGroups);
+        }
+        isolatedPaths.resize(isolatedConns.size());
+        const int searchCount = (int) searchGroups.size();
+#pragma omp parallel if (parallelSearch)
+        {
+            // Each thread reuses its own search storage.
+            AStarSearchContext context;
+            std::vector<ConnRef *> groupConns;
+            std::vector<std::vector<VertInf *> > groupPaths;
+#pragma omp for schedule(dynamic)
+            for (int s = 0; s < searchCount; ++s)
+            {
+                const std::vector<size_t>& group = searchGroups[s];
+                if (group.size() == 1)
+                {
+                    isolatedConns[group[0]]->searchPathIsolated(
+                            isolatedPaths[group[0]], context);
+                    continue;
+                }
+                groupConns.clear();
+                for (size_t c = 0; c < group.size(); ++c)
+                {
+                    groupConns.push_back(isolatedConns[group[c]]);
+                }
+                aStarPathsIsolated(groupConns, groupPaths, context);
+                for (size_t c = 0; c < group.size(); ++c)
+                {
+                    isolatedPaths[group[c]].swap(groupPaths[c]);
+                }
+            }
+#pragma omp critical
+            {
+                m_statistics.addToCounter(aStarNodesExpandedCounter,
+                        context.nodesExpanded);
+                m_statistics.addToCounter(aStarEdgesRelaxedCounter,
+                        context.edgesRelaxed);
+            }
+        }
+    }
+
+    size_t isolatedIndex = 0;
     for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
     {
         if (hyperedgeConns.find(*i) != hyperedgeConns.end())
@@ -972,29 +1433,59 @@ void Router::rerouteAndCallbackConnectors(void)
             continue;
         }
 
+        const std::vector<VertInf *> *searchedPath = NULL;
+        if ((isolatedIndex < isolatedConns.size()) && 
+                (isolatedConns[isolatedIndex] == *i))
+        {
+            searchedPath = &(isolatedPaths[isolatedIndex]);
+            ++isolatedIndex;
+        }
+
         (*i)->m_needs_repaint = false;
-        bool rerouted = (*i)->generatePath();
+        bool rerouted = (*i)->generatePath(searchedPath);
         if (rerouted)
         {
             reroutedConns.push_back(*i);
         }
     }
     timers.Stop();
+    m_statistics.stopPhase(pathSearchPhase);
 
 
     // Perform any complete hyperedge rerouting that has been requested.
+    m_statistics.startPhase(hyperedgeRoutingPhase);
     m_hyperedge_rerouter.performRerouting();
+    m_statistics.stopPhase(hyperedgeRoutingPhase);
 
     // Find and reroute crossing connectors if crossing penalties are set.
+    m_statistics.startPhase(crossingImprovementPhase);
     improveCrossings();
+    m_statistics.stopPhase(crossingImprovementPhase);
 
     if (routingOption(improveHyperedgeRoutesMovingJunctions))
     {
+        m_statistics.startPhase(hyperedgeRoutingPhase);
         improveHyperedgeRoutes(this);
+        m_statistics.stopPhase(hyperedgeRoutingPhase);
     }
 
     // Perform centring and nudging for orthogonal routes.
+    m_statistics.startPhase(nudgingPhase);
     improveOrthogonalRoutes(this);
+    m_statistics.stopPhase(nudgingPhase);
+
+    // Record the work done by searches using the router's own context.
+    m_statistics.addToCounter(aStarNodesExpandedCounter, 
+            aStarContext.nodesExpanded);
+    m_statistics.addToCounter(aStarEdgesRelaxedCounter, 
+            aStarContext.edgesRelaxed);
+    aStarContext.nodesExpanded = 0;
+    aStarContext.edgesRelaxed = 0;
+    m_statistics.setCounter(graphVerticesCounter, 
+            vertices.connsSize() + vertices.shapesSize());
+    m_statistics.setCounter(polyLineGraphEdgesCounter, visGraph.size());
+    m_statistics.setCounter(orthogonalGraphEdgesCounter, 
+            visOrthogGraph.size());
 
     // Alert connectors that they need redrawing.
     fin = reroutedConns.end();
@@ -1041,54 +1532,66 @@ void Router::improveCrossings(void)
     
     // Find crossings and reroute connectors.
     _inCrossingPenaltyReroutingStage = true;
+
+    // Only pairs of connectors whose routes come near each other can
+    // cross, so find these first rather than testing every pair.
+    std::vector<ConnRef *> conns(connRefs.begin(), connRefs.end());
+    RouteList routes;
+    std::vector<double> costs;
+    for (size_t i = 0; i < conns.size(); ++i)
+    {
+        routes.push_back(&(conns[i]->routeRef()));
+        costs.push_back(estimatedCost(conns[i]));
+    }
+    RouteIndexPairList nearbyPairs;
+    findPossiblyCrossingRoutes(routes, nearbyPairs);
+
     ConnCostRefSet crossingConns;
-    ConnRefList::iterator fin = connRefs.end();
-    for (ConnRefList::iterator i = connRefs.begin(); i != fin; ++i) 
+    std::vector<bool> hasCrossing(conns.size(), false);
+    for (RouteIndexPairList::iterator pair = nearbyPairs.begin(); 
+            pair != nearbyPairs.end(); ++pair)
     {
-        Avoid::Polygon& iRoute = (*i)->routeRef();
-        ConnCostRef iCostRef = std::make_pair(estimatedCost(*i), *i);
-        ConnRefList::iterator j = i;
-        for (++j; j != fin; ++j) 
+        const size_t i = pair->first;
+        const size_t j = pair->second;
+        if (hasCrossing[i] && hasCrossing[j])
         {
-            ConnCostRef jCostRef = std::make_pair(estimatedCost(*j), *j);
-            if ((crossingConns.find(iCostRef) != crossingConns.end()) && 
-                    (crossingConns.find(jCostRef) != crossingConns.end()))
-            {
-                // We already know both these have crossings.
-                continue;
-            }
-            // Determine if this pair cross.
-            Avoid::Polygon& jRoute = (*j)->routeRef();
-            bool meetsPenaltyCriteria = false;
-            ConnectorCrossings cross(iRoute, true, jRoute, *i, *j);
-            for (size_t jInd = 1; jInd < jRoute.size(); ++jInd)
+            // We already know both these have crossings.
+            continue;
+        }
+        // Determine if this pair cross.
+        Avoid::Polygon& iRoute = *(routes[i]);
+        Avoid::Polygon& jRoute = *(routes[j]);
+        bool meetsPenaltyCriteria = false;
+        ConnectorCrossings cross(iRoute, true, jRoute, conns[i], conns[j]);
+        for (size_t jInd = 1; jInd < jRoute.size(); ++jInd)
+        {
+            const bool finalSegment = ((jInd + 1) == jRoute.size());
+            cross.countForSegment(jInd, finalSegment);
+
+            if ((shared_path_penalty > 0) && 
+                (cross.crossingFlags & CROSSING_SHARES_PATH) && 
+                (cross.crossingFlags & CROSSING_SHARES_FIXED_SEGMENT) && 
+                !(cross.crossingFlags & CROSSING_SHARES_PATH_AT_END)) 
             {
-                const bool finalSegment = ((jInd + 1) == jRoute.size());
-                cross.countForSegment(jInd, finalSegment);
-                
-                if ((shared_path_penalty > 0) && 
-                    (cross.crossingFlags & CROSSING_SHARES_PATH) && 
-                    (cross.crossingFlags & CROSSING_SHARES_FIXED_SEGMENT) && 
-                    !(cross.crossingFlags & CROSSING_SHARES_PATH_AT_END)) 
-                {
-                    // We are penalising fixedSharedPaths and there is a
-                    // fixedSharedPath.
-                    meetsPenaltyCriteria = true;
-                    break;
-                }
-                else if ((crossing_penalty > 0) && (cross.crossingCount > 0))
-                {
-                    // We are penalising crossings and this is a crossing.
-                    meetsPenaltyCriteria = true;
-                    break;
-                }
+                // We are penalising fixedSharedPaths and there is a
+                // fixedSharedPath.
+                meetsPenaltyCriteria = true;
+                break;
             }
-            if (meetsPenaltyCriteria)
+            else if ((crossing_penalty > 0) && (cross.crossingCount > 0))
             {
-                crossingConns.insert(std::make_pair(estimatedCost(*i), *i));
-                crossingConns.insert(std::make_pair(estimatedCost(*j), *j));
+                // We are penalising crossings and this is a crossing.
+                meetsPenaltyCriteria = true;
+                break;
             }
         }
+        if (meetsPenaltyCriteria)
+        {
+            hasCrossing[i] = true;
+            hasCrossing[j] = true;
+            crossingConns.insert(std::make_pair(costs[i], conns[i]));
+            crossingConns.insert(std::make_pair(costs[j], conns[j]));
+        }
     }
 
     for (ConnCostRefSet::iterator i = crossingConns.begin(); 
@@ -1120,13 +1623,25 @@ void Router::improveCrossings(void)
 
 void Router::newBlockingShape(const Polygon& poly, int pid)
 {
-    // o  Check all visibility edges to see if this one shape
-    //    blocks them.
-    EdgeInf *finish = visGraph.end();
-    for (EdgeInf *iter = visGraph.begin(); iter != finish ; )
+    // o  Check the visibility edges near this shape to see if it 
+    //    blocks them.  Other edges cannot intersect the shape.
+    BBox polyBBox;
+    polyBBox.a = polyBBox.b = poly.ps[0];
+    for (size_t pt_i = 1; pt_i < poly.size(); ++pt_i)
     {
-        EdgeInf *tmp = iter;
-        iter = iter->lstNext;
+        const Point& p = poly.ps[pt_i];
+        polyBBox.a.x = std::min(p.x, polyBBox.a.x);
+        polyBBox.a.y = std::min(p.y, polyBBox.a.y);
+        polyBBox.b.x = std::max(p.x, polyBBox.b.x);
+        polyBBox.b.y = std::max(p.y, polyBBox.b.y);
+    }
+    EdgeInfVector nearbyEdges;
+    spatialIndex.edgesNearBox(polyBBox, nearbyEdges);
+
+    for (EdgeInfVector::iterator iter = nearbyEdges.begin(); 
+            iter != nearbyEdges.end(); ++iter)
+    {
+        EdgeInf *tmp = *iter;
 
         if (tmp->getDist() != 0)
         {
@@ -1613,6 +2128,24 @@ double& Router::penaltyRef(const PenaltyType penType)
 }
 
 
+const RoutingStatistics& Router::statistics(void) const
+{
+    return m_statistics;
+}
+
+
+RoutingStatistics& Router::statisticsRef(void)
+{
+    return m_statistics;
+}
+
+
+void Router::resetStatistics(void)
+{
+    m_statistics.reset();
+}
+
+
 HyperedgeRerouter *Router::hyperedgeRerouter(void)
 {
     return &m_hyperedge_rerouter;
@@ -30,6 +30,8 @@
 #define AVOID_ROUTER_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <utility>
 #include <string>
 
@@ -37,7 +39,11 @@
 #include "libavoid/vertices.h"
 #include "libavoid/graph.h"
 #include "libavoid/timer.h"
+#include "libavoid/statistics.h"
+#include "libavoid/pool.h"
 #include "libavoid/hyperedge.h"
+#include "libavoid/spatialindex.h"
+#include "libavoid/makepath.h"
 
 #if defined(LINEDEBUG) || defined(ASTAR_DEBUG) || defined(LIBAVOID_SDL)
     #include <SDL.h>
@@ -139,6 +145,64 @@ enum RoutingOption
     //!         will effectively move junctions, setting new ideal positions
     //!         ( JunctionRef::recommendedPosition() ) for each junction.
     improveHyperedgeRoutesMovingJunctions,
+    //! @brief  This option causes the paths for connectors being rerouted
+    //!         to be searched for in parallel, on multiple threads.  The
+    //!         resulting routes are the same as when searching one at a 
+    //!         time.  Connectors attached to connection pins or with 
+    //!         checkpoints are still routed one at a time.  This option
+    //!         has no effect if libavoid was built without OpenMP support.
+    //!         The number of threads used can be controlled via the 
+    //!         OMP_NUM_THREADS environment variable.  This option is not
+    //!         set by default.
+    searchConnectorPathsInParallel,
+    //! @brief  This option causes the orthogonal visibility graph to be
+    //!         updated, rather than regenerated, when obstacles have been
+    //!         moved, added or removed, or connector endpoints have 
+    //!         changed.  Only the visibility segments within the 
+    //!         horizontal and vertical bands spanned by the changes, and 
+    //!         those crossing these bands, are swept again and have their
+    //!         edges regenerated.  The rest of the graph is kept.  The 
+    //!         graph is still regenerated in full when more than a tenth 
+    //!         of the obstacles and vertices it is built from change at 
+    //!         once.
+    //!         This option is not set by default.
+    updateOrthogonalVisGraphIncrementally,
+    //! @brief  The orthogonal visibility graph is only regenerated in full
+    //!         when the obstacles or connector endpoints it is built from 
+    //!         have changed, and otherwise reused, or updated if the 
+    //!         updateOrthogonalVisGraphIncrementally option is set.  This
+    //!         option causes the graph to be regenerated in full whenever
+    //!         it would otherwise be reused or updated, with an assertion 
+    //!         that the result has the same edges as the reused or updated
+    //!         graph.  It is intended for testing and is not set by 
+    //!         default.
+    verifyOrthogonalVisGraphUpdates,
+    //! @brief  This option causes connectors being rerouted that start 
+    //!         at the same point, with the same visibility, to have their
+    //!         paths found together by a single search that continues 
+    //!         until it reaches all their targets, rather than by one 
+    //!         search each.  The routes may differ from those found 
+    //!         when searching one at a time where there are several 
+    //!         routes of equal cost.  It has no effect when
+    //!         cluster crossing penalties are in use, and, as with the
+    //!         searchConnectorPathsInParallel option, connectors attached
+    //!         to connection pins or with checkpoints are still routed
+    //!         one at a time.  This option is not set by default.
+    searchConnectorPathsFromSharedSources,
+    //! @brief  This option causes the paths of orthogonal connectors to be
+    //!         searched for from both ends at once.  This explores much 
+    //!         less of the visibility graph for connectors whose targets 
+    //!         are enclosed, such as in a pocket of shapes facing away 
+    //!         from the source, but somewhat more where the search from 
+    //!         the source heads almost directly to the target.  Each 
+    //!         route costs the same as when searching from the source 
+    //!         alone, but may differ from it where there are several 
+    //!         routes of equal cost.  It has no effect when cluster 
+    //!         crossing penalties are in use, or while connectors are 
+    //!         being rerouted to reduce crossings, since the cost of a 
+    //!         path then depends on more than its segments and bends.
+    //!         This option is not set by default.
+    searchConnectorPathsBidirectionally,
     // Used for determining the size of the routing options array.
     // This should always we the last value in the enum.
     lastRoutingOptionMarker
@@ -165,6 +229,73 @@ class ConnRerouteFlagDelegate {
         std::list<std::pair<ConnRef *, bool> > m_mapping;
 };
 
+
+// NOTE: This is an internal helper class that should not be used by the user.
+//
+// This class records everything the orthogonal visibility graph is built
+// from, so the router can tell whether a transaction has changed any of
+// it and the graph needs regenerating.
+class OrthogonalVisGraphInputs {
+    public:
+        // An obstacle, and whether it is a junction that may be moved.
+        struct ObstacleInput {
+            unsigned int id;
+            bool freeJunction;
+            Point min;
+            Point max;
+            bool operator==(const ObstacleInput& rhs) const;
+        };
+        // A vertex given visibility.  It is identified by its position in
+        // the vertex list, which is unique, so removed and readded vertices
+        // will differ.  The number of graph edges at a connector endpoint
+        // is kept to catch endpoints having been removed from the graph,
+        // and is zero for other vertices.
+        struct VertexInput {
+            long order;
+            Point point;
+            ConnDirFlags visDirections;
+            unsigned int visEdges;
+            bool operator==(const VertexInput& rhs) const;
+        };
+        void clear(void);
+        bool operator==(const OrthogonalVisGraphInputs& rhs) const;
+
+        std::vector<ObstacleInput> obstacles;
+        std::vector<VertexInput> vertices;
+};
+
+// NOTE: This is an internal helper class that should not be used by the user.
+//
+// This class records the visibility segments the orthogonal visibility 
+// graph was built from, as found by each of its sweeps before they are 
+// intersected, so that the graph can later be updated by sweeping again 
+// only where something has changed.
+class OrthogonalVisGraphSegments {
+    public:
+        // A vertex a segment starts with.  Connector endpoints are kept, 
+        // while shape corners and other dummy vertices are made again at 
+        // the same point if the segment is intersected again.
+        struct Vertex {
+            Point point;
+            VertInf *connVertex;
+            bool shapeCorner;
+        };
+        struct Segment {
+            double begin;
+            double finish;
+            std::vector<Vertex> vertices;
+        };
+        typedef std::multimap<double, Segment> SegmentMap;
+
+        void clear(void);
+        bool empty(void) const;
+
+        // Horizontal segments, by their y position, and vertical ones, by
+        // their x position.
+        SegmentMap horizontal;
+        SegmentMap vertical;
+};
+
 static const double noPenalty = 0;
 static const double chooseSensiblePenalty = -1;
 
@@ -189,6 +320,11 @@ class Router {
         //!         pointers to them.
         virtual ~Router();
 
+        // Pools for the vertices and edges of the orthogonal visibility 
+        // graph.  These come first so they outlive everything allocated
+        // from them.
+        MemoryPool vertInfPool;
+        MemoryPool edgeInfPool;
         ObstacleList m_obstacles;
         ConnRefList connRefs;
         ClusterRefList clusterRefs;
@@ -198,6 +334,11 @@ class Router {
         ContainsMap contains;
         VertInfList vertices;
         ContainsMap enclosingClusters;
+        SpatialIndex spatialIndex;
+        // Working storage reused by the router's own path searches.
+        AStarSearchContext aStarContext;
+        // Compact copy of visOrthogGraph read by the orthogonal path search.
+        OrthogVisGraphSnapshot visOrthogGraphSnapshot;
         
         bool PartialTime;
         bool SimpleRouting;
@@ -466,6 +607,18 @@ class Router {
         //!
         void outputInstanceToSVG(std::string filename = std::string());
 
+        //! @brief  Returns the time spent in each phase of routing and 
+        //!         counts of the work done, accumulated over all 
+        //!         transactions since the statistics were last reset.
+        //!
+        //! @return  A reference to the router's RoutingStatistics.
+        //!
+        const RoutingStatistics& statistics(void) const;
+
+        //! @brief  Resets all routing statistics to zero.
+        //!
+        void resetStatistics(void);
+
         //! @brief  Returns the object ID used for automatically generated 
         //!         objects, such as during hyeredge routing.
         //! 
@@ -500,6 +653,7 @@ class Router {
         void setStaticGraphInvalidated(const bool invalidated);
         ConnType validConnType(const ConnType select = ConnType_None) const;
         double& penaltyRef(const PenaltyType penType);
+        RoutingStatistics& statisticsRef(void);
         bool existsOrthogonalPathOverlap(void);
         bool existsOrthogonalTouchingPaths(void);
         int  existsOrthogonalCrossings(void);
@@ -532,6 +686,7 @@ class Router {
                 const int p_cluster);
         void adjustClustersWithDel(const int p_cluster);
         void rerouteAndCallbackConnectors(void);
+        void orthogonalVisGraphInputs(OrthogonalVisGraphInputs& inputs);
         void improveCrossings(void);
 
         ActionInfoList actionList;
@@ -541,8 +696,13 @@ class Router {
         double _orthogonalNudgeDistance;
         double _routingPenalties[lastPenaltyMarker];
         bool _routingOptions[lastRoutingOptionMarker];
+        RoutingStatistics m_statistics;
 
         ConnRerouteFlagDelegate m_conn_reroute_flags;
+        // The inputs the orthogonal visibility graph was last built from,
+        // and the segments it was built from, if it may be updated.
+        OrthogonalVisGraphInputs m_orthog_graph_inputs;
+        OrthogonalVisGraphSegments m_orthog_graph_segments;
         HyperedgeRerouter m_hyperedge_rerouter;
 public:
         // Overall modes:
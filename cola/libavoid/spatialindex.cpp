@@ -0,0 +1,471 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include "libavoid/spatialindex.h"
+#include "libavoid/obstacle.h"
+#include "libavoid/graph.h"
+#include "libavoid/connector.h"
+#include "libavoid/assertions.h"
+
+
+namespace Avoid {
+
+
+// The cell size used before any obstacles have been added.
+static const double defaultCellSize = 100;
+
+// Cells are sized to hold roughly a couple of average obstacles.
+static const double cellSizeObstacleFactor = 2;
+
+// An edge is kept in the finest grid in which it crosses at most this 
+// many columns and rows, and the cells of each grid are this factor 
+// larger than those of the last.
+static const double maxEdgeCellSpan = 8;
+static const double edgeLevelFactor = 8;
+
+
+static bool cmpObstacleIds(const Obstacle *lhs, const Obstacle *rhs)
+{
+    return lhs->id() < rhs->id();
+}
+
+
+static bool cmpConnRefIds(const ConnRef *lhs, const ConnRef *rhs)
+{
+    return lhs->id() < rhs->id();
+}
+
+
+SpatialIndex::SpatialIndex()
+    : m_cell_size(defaultCellSize),
+      m_total_obstacle_extent(0),
+      m_next_resize_check(1)
+{
+}
+
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+
+size_t SpatialIndex::obstacleCount(void) const
+{
+    return m_obstacle_bboxes.size();
+}
+
+
+double SpatialIndex::cellSize(void) const
+{
+    return m_cell_size;
+}
+
+
+int SpatialIndex::cellIndex(const double pos, const double size) const
+{
+    return (int) floor(pos / size);
+}
+
+
+double SpatialIndex::levelCellSize(const size_t level) const
+{
+    return m_cell_size * pow(edgeLevelFactor, (double) level);
+}
+
+
+// Returns the grid the edge a--b is kept in.  This depends only on the 
+// points and the cell size, so it is the same when the edge is removed.
+size_t SpatialIndex::edgeLevel(const Point& a, const Point& b) const
+{
+    const double span = std::max(fabs(b.x - a.x), fabs(b.y - a.y));
+    size_t level = 0;
+    while (span > maxEdgeCellSpan * levelCellSize(level))
+    {
+        ++level;
+    }
+    return level;
+}
+
+
+// Returns the cells of the given size overlapped by the closed box bbox.
+// The box is grown very slightly so that geometry touching a cell 
+// boundary is reported in the cells on both sides of it.
+void SpatialIndex::bboxCells(const BBox& bbox, const double size,
+        CellKeyList& cells) const
+{
+    const double eps = size * 1e-9;
+    int minX = cellIndex(std::min(bbox.a.x, bbox.b.x) - eps, size);
+    int maxX = cellIndex(std::max(bbox.a.x, bbox.b.x) + eps, size);
+    int minY = cellIndex(std::min(bbox.a.y, bbox.b.y) - eps, size);
+    int maxY = cellIndex(std::max(bbox.a.y, bbox.b.y) + eps, size);
+
+    cells.clear();
+    for (int x = minX; x <= maxX; ++x)
+    {
+        for (int y = minY; y <= maxY; ++y)
+        {
+            cells.push_back(std::make_pair(x, y));
+        }
+    }
+}
+
+
+// Returns the cells of the given size crossed by the segment a--b, by 
+// walking the columns it spans and taking the range of rows it covers 
+// within each.
+void SpatialIndex::segmentCells(const Point& a, const Point& b, 
+        const double size, CellKeyList& cells) const
+{
+    const double eps = size * 1e-9;
+    const Point& left = (a.x <= b.x) ? a : b;
+    const Point& right = (a.x <= b.x) ? b : a;
+    const double dx = right.x - left.x;
+
+    cells.clear();
+    int minCol = cellIndex(left.x - eps, size);
+    int maxCol = cellIndex(right.x + eps, size);
+    for (int col = minCol; col <= maxCol; ++col)
+    {
+        double y1 = left.y;
+        double y2 = right.y;
+        if (dx > 0)
+        {
+            double x1 = std::max(left.x, col * size);
+            double x2 = std::min(right.x, (col + 1) * size);
+            double slope = (right.y - left.y) / dx;
+            y1 = left.y + (x1 - left.x) * slope;
+            y2 = left.y + (x2 - left.x) * slope;
+        }
+        int minRow = cellIndex(std::min(y1, y2) - eps, size);
+        int maxRow = cellIndex(std::max(y1, y2) + eps, size);
+        for (int row = minRow; row <= maxRow; ++row)
+        {
+            cells.push_back(std::make_pair(col, row));
+        }
+    }
+}
+
+
+void SpatialIndex::insertObstacleIntoCells(Obstacle *obstacle,
+        const BBox& bbox)
+{
+    CellKeyList cells;
+    bboxCells(bbox, m_cell_size, cells);
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        m_cells[*it].obstacles.push_back(obstacle);
+    }
+}
+
+
+void SpatialIndex::insertEdgeIntoCells(EdgeInf *edge)
+{
+    const Point& a = edge->m_index_points.first;
+    const Point& b = edge->m_index_points.second;
+    const size_t level = edgeLevel(a, b);
+    if (level >= m_edge_levels.size())
+    {
+        m_edge_levels.resize(level + 1);
+    }
+    CellKeyList cells;
+    segmentCells(a, b, levelCellSize(level), cells);
+    EdgeCellMap& edgeCells = m_edge_levels[level];
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        edgeCells[*it].insert(edge);
+    }
+}
+
+
+void SpatialIndex::insertRouteIntoCells(ConnRef *conn,
+        const std::vector<Point>& points)
+{
+    CellKeyList cells;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        segmentCells(points[i - 1], points[i], m_cell_size, cells);
+        for (CellKeyList::iterator it = cells.begin(); it != cells.end(); 
+                ++it)
+        {
+            m_cells[*it].connectors.push_back(conn);
+        }
+    }
+}
+
+
+void SpatialIndex::addObstacle(Obstacle *obstacle)
+{
+    COLA_ASSERT(m_obstacle_bboxes.find(obstacle) == m_obstacle_bboxes.end());
+
+    BBox bbox;
+    obstacle->boundingBox(bbox);
+    m_obstacle_bboxes[obstacle] = bbox;
+    m_total_obstacle_extent += std::max(bbox.b.x - bbox.a.x,
+            bbox.b.y - bbox.a.y);
+
+    insertObstacleIntoCells(obstacle, bbox);
+
+    resizeIfNeeded();
+}
+
+
+void SpatialIndex::removeObstacle(Obstacle *obstacle)
+{
+    ObstacleBBoxMap::iterator found = m_obstacle_bboxes.find(obstacle);
+    COLA_ASSERT(found != m_obstacle_bboxes.end());
+
+    const BBox& bbox = found->second;
+    m_total_obstacle_extent -= std::max(bbox.b.x - bbox.a.x,
+            bbox.b.y - bbox.a.y);
+
+    CellKeyList cells;
+    bboxCells(bbox, m_cell_size, cells);
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        CellMap::iterator cell = m_cells.find(*it);
+        COLA_ASSERT(cell != m_cells.end());
+        ObstacleVector& obstacles = cell->second.obstacles;
+        ObstacleVector::iterator pos =
+                std::find(obstacles.begin(), obstacles.end(), obstacle);
+        COLA_ASSERT(pos != obstacles.end());
+        *pos = obstacles.back();
+        obstacles.pop_back();
+        if (cell->second.empty())
+        {
+            m_cells.erase(cell);
+        }
+    }
+    m_obstacle_bboxes.erase(found);
+
+    if (m_obstacle_bboxes.empty())
+    {
+        m_total_obstacle_extent = 0;
+    }
+}
+
+
+void SpatialIndex::addEdge(EdgeInf *edge)
+{
+    edge->m_index_points = edge->points();
+    insertEdgeIntoCells(edge);
+}
+
+
+void SpatialIndex::removeEdge(EdgeInf *edge)
+{
+    const Point& a = edge->m_index_points.first;
+    const Point& b = edge->m_index_points.second;
+    const size_t level = edgeLevel(a, b);
+    COLA_ASSERT(level < m_edge_levels.size());
+    CellKeyList cells;
+    segmentCells(a, b, levelCellSize(level), cells);
+    EdgeCellMap& edgeCells = m_edge_levels[level];
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        EdgeCellMap::iterator cell = edgeCells.find(*it);
+        COLA_ASSERT(cell != edgeCells.end());
+        size_t erased = cell->second.erase(edge);
+        COLA_ASSERT(erased == 1);
+        if (cell->second.empty())
+        {
+            edgeCells.erase(cell);
+        }
+    }
+}
+
+
+void SpatialIndex::addRoute(ConnRef *conn)
+{
+    removeRoute(conn);
+
+    std::vector<Point>& points = m_route_points[conn];
+    points = conn->route().ps;
+    insertRouteIntoCells(conn, points);
+}
+
+
+void SpatialIndex::removeRoute(ConnRef *conn)
+{
+    RoutePointsMap::iterator found = m_route_points.find(conn);
+    if (found == m_route_points.end())
+    {
+        return;
+    }
+
+    const std::vector<Point>& points = found->second;
+    CellKeyList cells;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        segmentCells(points[i - 1], points[i], m_cell_size, cells);
+        for (CellKeyList::iterator it = cells.begin(); it != cells.end(); 
+                ++it)
+        {
+            CellMap::iterator cell = m_cells.find(*it);
+            if (cell == m_cells.end())
+            {
+                // Already emptied by an earlier segment in the same cell.
+                continue;
+            }
+            ConnRefVector& conns = cell->second.connectors;
+            conns.erase(std::remove(conns.begin(), conns.end(), conn),
+                    conns.end());
+            if (cell->second.empty())
+            {
+                m_cells.erase(cell);
+            }
+        }
+    }
+    m_route_points.erase(found);
+}
+
+
+void SpatialIndex::obstaclesNearSegment(const Point& a, const Point& b,
+        ObstacleVector& obstacles) const
+{
+    obstacles.clear();
+
+    CellKeyList cells;
+    segmentCells(a, b, m_cell_size, cells);
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        CellMap::const_iterator cell = m_cells.find(*it);
+        if (cell != m_cells.end())
+        {
+            obstacles.insert(obstacles.end(), cell->second.obstacles.begin(),
+                    cell->second.obstacles.end());
+        }
+    }
+
+    // Remove duplicates from obstacles spanning multiple cells and
+    // return them in a consistent order.
+    std::sort(obstacles.begin(), obstacles.end(), cmpObstacleIds);
+    obstacles.erase(std::unique(obstacles.begin(), obstacles.end()),
+            obstacles.end());
+}
+
+
+void SpatialIndex::edgesNearBox(const BBox& bbox, EdgeInfVector& edges) const
+{
+    edges.clear();
+
+    CellKeyList cells;
+    for (size_t level = 0; level < m_edge_levels.size(); ++level)
+    {
+        const EdgeCellMap& edgeCells = m_edge_levels[level];
+        bboxCells(bbox, levelCellSize(level), cells);
+        for (CellKeyList::iterator it = cells.begin(); it != cells.end(); 
+                ++it)
+        {
+            EdgeCellMap::const_iterator cell = edgeCells.find(*it);
+            if (cell != edgeCells.end())
+            {
+                edges.insert(edges.end(), cell->second.begin(),
+                        cell->second.end());
+            }
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+}
+
+
+void SpatialIndex::connectorsNearSegment(const Point& a, const Point& b,
+        ConnRefVector& conns) const
+{
+    conns.clear();
+
+    CellKeyList cells;
+    segmentCells(a, b, m_cell_size, cells);
+    for (CellKeyList::iterator it = cells.begin(); it != cells.end(); ++it)
+    {
+        CellMap::const_iterator cell = m_cells.find(*it);
+        if (cell != m_cells.end())
+        {
+            conns.insert(conns.end(), cell->second.connectors.begin(),
+                    cell->second.connectors.end());
+        }
+    }
+
+    std::sort(conns.begin(), conns.end(), cmpConnRefIds);
+    conns.erase(std::unique(conns.begin(), conns.end()), conns.end());
+}
+
+
+// Each time the number of obstacles doubles, check whether the cell size
+// still suits the average obstacle size, and if not rebuild the grid.
+void SpatialIndex::resizeIfNeeded(void)
+{
+    size_t count = m_obstacle_bboxes.size();
+    if (count < m_next_resize_check)
+    {
+        return;
+    }
+    m_next_resize_check = 2 * count;
+
+    double idealSize = cellSizeObstacleFactor *
+            (m_total_obstacle_extent / count);
+    if ((idealSize <= 0) ||
+            ((idealSize < 2 * m_cell_size) && (idealSize > m_cell_size / 2)))
+    {
+        return;
+    }
+
+    // Gather the indexed edges before throwing away the old grid.
+    std::set<EdgeInf *> edges;
+    for (size_t level = 0; level < m_edge_levels.size(); ++level)
+    {
+        EdgeCellMap& edgeCells = m_edge_levels[level];
+        for (EdgeCellMap::iterator cell = edgeCells.begin(); 
+                cell != edgeCells.end(); ++cell)
+        {
+            edges.insert(cell->second.begin(), cell->second.end());
+        }
+    }
+    m_cells.clear();
+    m_edge_levels.clear();
+
+    m_cell_size = idealSize;
+
+    for (ObstacleBBoxMap::iterator it = m_obstacle_bboxes.begin();
+            it != m_obstacle_bboxes.end(); ++it)
+    {
+        insertObstacleIntoCells(it->first, it->second);
+    }
+    for (std::set<EdgeInf *>::iterator it = edges.begin();
+            it != edges.end(); ++it)
+    {
+        insertEdgeIntoCells(*it);
+    }
+    for (RoutePointsMap::iterator it = m_route_points.begin();
+            it != m_route_points.end(); ++it)
+    {
+        insertRouteIntoCells(it->first, it->second);
+    }
+}
+
+
+}
+
@@ -0,0 +1,144 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#ifndef AVOID_SPATIALINDEX_H
+#define AVOID_SPATIALINDEX_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+
+#include "libavoid/geomtypes.h"
+
+
+namespace Avoid {
+
+class Obstacle;
+class EdgeInf;
+class ConnRef;
+
+typedef std::vector<Obstacle *> ObstacleVector;
+typedef std::vector<EdgeInf *> EdgeInfVector;
+typedef std::vector<ConnRef *> ConnRefVector;
+
+
+// This class is not intended for public use.
+// It is a uniform grid over the scene, owned by the Router, that records
+// which cells each active obstacle's bounding box and each poly-line
+// visibility edge pass through.  It lets the poly-line visibility code
+// test an edge against only the obstacles near it, and test a newly
+// added obstacle against only the visibility edges near it.  It also
+// records the segments of each connector's current route, so that
+// crossing penalties need only consider the connectors near a segment.
+//
+// The cell size is chosen from the average obstacle dimension and the
+// grid is rebuilt when this changes significantly as obstacles are added.
+//
+// Poly-line visibility edges may cross the whole scene, so rather than 
+// record a long edge in every cell it crosses, each edge is kept in the
+// finest of a series of coarser grids in which it crosses only a few 
+// cells.  This bounds the cells used by each edge.
+//
+class SpatialIndex
+{
+    public:
+        SpatialIndex();
+        ~SpatialIndex();
+
+        void addObstacle(Obstacle *obstacle);
+        void removeObstacle(Obstacle *obstacle);
+        // The edge remembers the endpoint positions it was indexed with,
+        // since its vertices may be moved before it is removed.
+        void addEdge(EdgeInf *edge);
+        void removeEdge(EdgeInf *edge);
+        // A connector's route is copied when it is added, so it must be 
+        // re-added (which replaces the old copy) whenever it changes.
+        void addRoute(ConnRef *conn);
+        void removeRoute(ConnRef *conn);
+
+        // Returns, ordered by ID, the obstacles whose bounding boxes are
+        // in grid cells crossed by the segment a--b.
+        void obstaclesNearSegment(const Point& a, const Point& b,
+                ObstacleVector& obstacles) const;
+        // Returns the visibility edges passing through the grid cells
+        // overlapped by bbox.
+        void edgesNearBox(const BBox& bbox, EdgeInfVector& edges) const;
+        // Returns, ordered by ID, the connectors with a route segment in 
+        // the grid cells crossed by the segment a--b.
+        void connectorsNearSegment(const Point& a, const Point& b,
+                ConnRefVector& conns) const;
+
+        size_t obstacleCount(void) const;
+        double cellSize(void) const;
+
+    private:
+        typedef std::pair<int, int> CellKey;
+        struct Cell
+        {
+            ObstacleVector obstacles;
+            // A connector appears once for each of its segments here.
+            ConnRefVector connectors;
+
+            bool empty(void) const
+            {
+                return obstacles.empty() && connectors.empty();
+            }
+        };
+        typedef std::map<CellKey, Cell> CellMap;
+        typedef std::map<CellKey, std::set<EdgeInf *> > EdgeCellMap;
+        typedef std::map<Obstacle *, BBox> ObstacleBBoxMap;
+        typedef std::map<ConnRef *, std::vector<Point> > RoutePointsMap;
+        typedef std::vector<CellKey> CellKeyList;
+
+        int cellIndex(const double pos, const double size) const;
+        void bboxCells(const BBox& bbox, const double size,
+                CellKeyList& cells) const;
+        void segmentCells(const Point& a, const Point& b, const double size,
+                CellKeyList& cells) const;
+        size_t edgeLevel(const Point& a, const Point& b) const;
+        double levelCellSize(const size_t level) const;
+        void insertObstacleIntoCells(Obstacle *obstacle, const BBox& bbox);
+        void insertEdgeIntoCells(EdgeInf *edge);
+        void insertRouteIntoCells(ConnRef *conn, 
+                const std::vector<Point>& points);
+        void resizeIfNeeded(void);
+
+        CellMap m_cells;
+        // The edges in each grid, the first of which uses the same cells
+        // as m_cells and each other of which has cells a fixed factor 
+        // larger than the last.
+        std::vector<EdgeCellMap> m_edge_levels;
+        ObstacleBBoxMap m_obstacle_bboxes;
+        RoutePointsMap m_route_points;
+        double m_cell_size;
+        double m_total_obstacle_extent;
+        size_t m_next_resize_check;
+};
+
+
+}
+
+
+#endif
+
+
@@ -0,0 +1,160 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#ifdef _OPENMP
+#include <omp.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "libavoid/statistics.h"
+#include "libavoid/assertions.h"
+
+namespace Avoid {
+
+
+static const char *phaseNames[lastRoutingPhaseMarker] = 
+{
+    "visibilityGraph",
+    "pathSearch",
+    "crossingImprovement",
+    "hyperedgeRouting",
+    "nudging"
+};
+
+static const char *counterNames[lastRoutingCounterMarker] = 
+{
+    "transactions",
+    "aStarNodesExpanded",
+    "aStarEdgesRelaxed",
+    "vpscBlocksMerged",
+    "graphVertices",
+    "polyLineGraphEdges",
+    "orthogonalGraphEdges"
+};
+
+
+// Returns the wall clock time in seconds, since some fixed point.
+static double wallTime(void)
+{
+#if defined(_OPENMP)
+    return omp_get_wtime();
+#elif !defined(_WIN32)
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (tv.tv_usec / 1000000.0);
+#else
+    LARGE_INTEGER frequency, count;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return ((double) count.QuadPart) / frequency.QuadPart;
+#endif
+}
+
+
+RoutingStatistics::RoutingStatistics()
+{
+    reset();
+}
+
+
+void RoutingStatistics::reset(void)
+{
+    for (size_t p = 0; p < lastRoutingPhaseMarker; ++p)
+    {
+        m_phase_start[p] = 0;
+        m_phase_time[p] = 0;
+    }
+    for (size_t c = 0; c < lastRoutingCounterMarker; ++c)
+    {
+        m_counters[c] = 0;
+    }
+}
+
+
+double RoutingStatistics::phaseTime(const RoutingPhase phase) const
+{
+    COLA_ASSERT(phase < lastRoutingPhaseMarker);
+    return m_phase_time[phase];
+}
+
+
+unsigned long RoutingStatistics::counter(
+        const RoutingCounter counter) const
+{
+    COLA_ASSERT(counter < lastRoutingCounterMarker);
+    return m_counters[counter];
+}
+
+
+void RoutingStatistics::startPhase(const RoutingPhase phase)
+{
+    COLA_ASSERT(phase < lastRoutingPhaseMarker);
+    m_phase_start[phase] = wallTime();
+}
+
+
+void RoutingStatistics::stopPhase(const RoutingPhase phase)
+{
+    COLA_ASSERT(phase < lastRoutingPhaseMarker);
+    m_phase_time[phase] += wallTime() - m_phase_start[phase];
+}
+
+
+void RoutingStatistics::addToCounter(const RoutingCounter counter, 
+        const unsigned long value)
+{
+    COLA_ASSERT(counter < lastRoutingCounterMarker);
+    m_counters[counter] += value;
+}
+
+
+void RoutingStatistics::setCounter(const RoutingCounter counter, 
+        const unsigned long value)
+{
+    COLA_ASSERT(counter < lastRoutingCounterMarker);
+    m_counters[counter] = value;
+}
+
+
+void RoutingStatistics::outputJSON(FILE *fp) const
+{
+    fprintf(fp, "{\n    \"phaseTimes\": {");
+    for (size_t p = 0; p < lastRoutingPhaseMarker; ++p)
+    {
+        fprintf(fp, "%s\n        \"%s\": %.6f", (p > 0) ? "," : "",
+                phaseNames[p], m_phase_time[p]);
+    }
+    fprintf(fp, "\n    },\n    \"counters\": {");
+    for (size_t c = 0; c < lastRoutingCounterMarker; ++c)
+    {
+        fprintf(fp, "%s\n        \"%s\": %lu", (c > 0) ? "," : "",
+                counterNames[c], m_counters[c]);
+    }
+    fprintf(fp, "\n    }\n}\n");
+}
+
+
+}
+
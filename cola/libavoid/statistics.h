@@ -0,0 +1,144 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+//! @file    statistics.h
+//! @brief   Contains the interface for the RoutingStatistics class.
+
+
+#ifndef AVOID_STATISTICS_H
+#define AVOID_STATISTICS_H
+
+#include <cstdio>
+
+
+namespace Avoid {
+
+//! @brief  Phases of routing that the Router records the time spent in.
+//!
+//! @sa  RoutingStatistics::phaseTime()
+//!
+enum RoutingPhase
+{
+    //! @brief  Updating the poly-line visibility graph and regenerating 
+    //!         the orthogonal visibility graph after changes to obstacles
+    //!         and connectors.
+    visibilityGraphPhase = 0,
+    //! @brief  Searching for the paths of connectors being rerouted.
+    pathSearchPhase,
+    //! @brief  Rerouting connectors to remove crossings, if the 
+    //!         crossingPenalty or clusterCrossingPenalty is set.
+    crossingImprovementPhase,
+    //! @brief  Routing hyperedges as minimum terminal spanning trees and
+    //!         improving their routes.
+    hyperedgeRoutingPhase,
+    //! @brief  Centring and nudging apart orthogonal connector routes.
+    nudgingPhase,
+    // Used for determining the size of the phase times array.
+    // This should always we the last value in the enum.
+    lastRoutingPhaseMarker
+};
+
+//! @brief  Quantities that the Router counts while routing.
+//!
+//! @sa  RoutingStatistics::counter()
+//!
+enum RoutingCounter
+{
+    //! @brief  The number of transactions processed.
+    transactionsCounter = 0,
+    //! @brief  The number of nodes expanded by A* path searches.
+    aStarNodesExpandedCounter,
+    //! @brief  The number of edges considered by A* path searches when 
+    //!         expanding nodes.
+    aStarEdgesRelaxedCounter,
+    //! @brief  The number of block merges performed by the VPSC solver 
+    //!         while nudging.
+    vpscBlocksMergedCounter,
+    //! @brief  The number of visibility graph vertices, including those
+    //!         added for the orthogonal visibility graph, after the last 
+    //!         transaction.  This is not a running total.
+    graphVerticesCounter,
+    //! @brief  The number of edges in the poly-line visibility graph 
+    //!         after the last transaction.  This is not a running total.
+    polyLineGraphEdgesCounter,
+    //! @brief  The number of edges in the orthogonal visibility graph
+    //!         after the last transaction.  This is not a running total.
+    orthogonalGraphEdgesCounter,
+    // Used for determining the size of the counters array.
+    // This should always we the last value in the enum.
+    lastRoutingCounterMarker
+};
+
+
+//! @brief   The RoutingStatistics class records the time spent in each 
+//!          phase of routing and counts of the work done, accumulated 
+//!          over all transactions since they were last reset.
+//!
+//! These are always recorded by the Router and can be queried via
+//! Router::statistics().
+//!
+class RoutingStatistics
+{
+    public:
+        RoutingStatistics();
+
+        //! @brief  Resets all phase times and counters to zero.
+        void reset(void);
+
+        //! @brief  Returns the wall clock time spent in the given phase.
+        //!
+        //! @param[in] phase  The RoutingPhase of interest.
+        //! @return   The time in seconds.
+        //!
+        double phaseTime(const RoutingPhase phase) const;
+
+        //! @brief  Returns the value of the given counter.
+        //!
+        //! @param[in] counter  The RoutingCounter of interest.
+        //! @return   The count.
+        //!
+        unsigned long counter(const RoutingCounter counter) const;
+
+        //! @brief  Writes the phase times and counters as a JSON object.
+        //!
+        //! @param[in] fp  The file to write to.
+        //!
+        void outputJSON(FILE *fp) const;
+
+        // Internal use: records time spent in phases and counts.
+        void startPhase(const RoutingPhase phase);
+        void stopPhase(const RoutingPhase phase);
+        void addToCounter(const RoutingCounter counter, 
+                const unsigned long value);
+        void setCounter(const RoutingCounter counter, 
+                const unsigned long value);
+
+    private:
+        double m_phase_start[lastRoutingPhaseMarker];
+        double m_phase_time[lastRoutingPhaseMarker];
+        unsigned long m_counters[lastRoutingCounterMarker];
+};
+
+
+}
+
+#endif
@@ -0,0 +1,547 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Benchmark for the router on generated instances.  Each instance is 
+// built from a seed, so runs are reproducible and can be compared between
+// versions of the library.  Instance kinds are:
+//
+//   grid       shapes on a regular grid, connecting nearby shapes;
+//   random     shapes of random size scattered over the diagram, 
+//              connecting random pairs of shapes;
+//   clustered  groups of shapes, mostly connecting shapes in the same
+//              group;
+//   bus        shapes in rows, with many long connectors running in 
+//              parallel from the left of the diagram to the right; and
+//   fan        shapes in a grid, with connectors fanning out from one
+//              shape in each hundred to random shapes.
+//
+// For each instance, all shapes and connectors are added in one 
+// transaction, and then a small fraction of the shapes are moved in a 
+// second transaction.  The time for each transaction, the router's 
+// statistics for it, the connectors routed per second and the peak 
+// memory use are written to standard output as JSON.  Each instance is
+// routed in a child process of its own where fork() is available, so the
+// peak memory is for that instance alone; elsewhere it is the peak for 
+// the benchmark process so far, including all earlier instances.
+// Routes are checked to start and end at their connector endpoints, and
+// for orthogonal connectors to contain only horizontal and vertical 
+// segments.  The exit status is non-zero if any check fails.
+//
+// With --shared-searches, the searchConnectorPathsFromSharedSources 
+// option is set, so its effect on the path search phase can be timed by
+// comparing runs with and without it, e.g., for the "fan" kind.
+//
+// Usage:  benchmark [--full] [--kind grid|random|clustered|bus|fan] 
+//                   [--mode polyline|orthogonal] [--shapes N] 
+//                   [--connectors M] [--seed S] [--shared-searches]
+//
+// Without arguments a small instance of each kind is routed in each mode,
+// as a quick check.  With --full each kind is routed with 100, 1000, 
+// 10000 and 50000 shapes and connectors; poly-line routing is limited to
+// 10000, since its visibility graph grows quadratically.  Otherwise the
+// given instance is routed.
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const char *kinds[] = { "grid", "random", "clustered", "bus", "fan" };
+static const size_t kindCount = sizeof(kinds) / sizeof(kinds[0]);
+
+static double wallTime(void)
+{
+#ifndef _WIN32
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + (tv.tv_usec / 1000000.0);
+#else
+    LARGE_INTEGER frequency, count;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return ((double) count.QuadPart) / frequency.QuadPart;
+#endif
+}
+
+// Returns the peak resident memory of the process so far, in KiB, or -1
+// if this is not available.  See runInstance().
+static long peakMemory(void)
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+static size_t randomIndex(unsigned int& seed, size_t n)
+{
+    return std::min((size_t) randomValue(seed, 0, n), n - 1);
+}
+
+struct Instance
+{
+    std::vector<Rectangle> shapes;
+    std::vector<std::pair<size_t, size_t> > connectors;
+};
+
+// Space given to each shape, and the largest shape size.
+static const double cellSize = 80;
+static const double maxShapeSize = 40;
+
+static Rectangle shapeInCell(unsigned int& seed, double x, double y)
+{
+    double width = randomValue(seed, 10, maxShapeSize);
+    double height = randomValue(seed, 10, maxShapeSize);
+    double left = x + randomValue(seed, 0, cellSize - maxShapeSize - 10);
+    double top = y + randomValue(seed, 0, cellSize - maxShapeSize - 10);
+    return Rectangle(Point(left, top), Point(left + width, top + height));
+}
+
+static Instance generateInstance(const std::string& kind, 
+        const size_t shapeCount, const size_t connCount, unsigned int seed)
+{
+    Instance instance;
+    const size_t columns = (size_t) ceil(sqrt((double) shapeCount));
+
+    if (kind == "clustered")
+    {
+        // Clusters of up to 25 shapes, placed on a coarse grid with gaps
+        // between them.
+        const size_t clusterSide = 5;
+        const size_t clusterCount = 
+                (shapeCount + (clusterSide * clusterSide) - 1) / 
+                (clusterSide * clusterSide);
+        const size_t clusterColumns = 
+                (size_t) ceil(sqrt((double) clusterCount));
+        const double clusterSpace = (clusterSide + 3) * cellSize;
+        for (size_t i = 0; i < shapeCount; ++i)
+        {
+            size_t cluster = i / (clusterSide * clusterSide);
+            size_t member = i % (clusterSide * clusterSide);
+            double x = (cluster % clusterColumns) * clusterSpace +
+                    (member % clusterSide) * cellSize;
+            double y = (cluster / clusterColumns) * clusterSpace +
+                    (member / clusterSide) * cellSize;
+            instance.shapes.push_back(shapeInCell(seed, x, y));
+        }
+        for (size_t c = 0; c < connCount; ++c)
+        {
+            size_t src = randomIndex(seed, shapeCount);
+            size_t tar = randomIndex(seed, shapeCount);
+            if (randomValue(seed, 0, 1) < 0.9)
+            {
+                // Keep within the cluster of the source.
+                size_t first = src - (src % (clusterSide * clusterSide));
+                size_t size = std::min(clusterSide * clusterSide, 
+                        shapeCount - first);
+                tar = first + randomIndex(seed, size);
+            }
+            instance.connectors.push_back(std::make_pair(src, tar));
+        }
+        return instance;
+    }
+
+    // Other kinds place the shapes on a grid, though "random" and "bus" 
+    // have wider spacing, making room for connectors between them.
+    const double spacing = (kind == "grid") ? 1 : 1.5;
+    for (size_t i = 0; i < shapeCount; ++i)
+    {
+        double x = (i % columns) * cellSize * spacing;
+        double y = (i / columns) * cellSize * spacing;
+        instance.shapes.push_back(shapeInCell(seed, x, y));
+    }
+    for (size_t c = 0; c < connCount; ++c)
+    {
+        size_t src = randomIndex(seed, shapeCount);
+        size_t tar = src;
+        if (kind == "grid")
+        {
+            // Connect to a shape at most three rows and columns away.
+            long row = (long) (src / columns) + 
+                    (long) randomValue(seed, -3, 4);
+            long column = (long) (src % columns) + 
+                    (long) randomValue(seed, -3, 4);
+            row = std::max(0L, row);
+            column = std::max(0L, std::min((long) columns - 1, column));
+            tar = std::min((size_t) (row * columns + column), 
+                    shapeCount - 1);
+        }
+        else if (kind == "fan")
+        {
+            // Fan out from one shape in each hundred to random shapes, so
+            // that many connectors share each source point.
+            src = std::min(randomIndex(seed, (shapeCount + 99) / 100) * 100,
+                    shapeCount - 1);
+            tar = randomIndex(seed, shapeCount);
+        }
+        else if (kind == "bus")
+        {
+            // Connect from the left quarter of a row to the right 
+            // quarter of a nearby row.
+            size_t row = src / columns;
+            size_t quarter = std::max((size_t) 1, columns / 4);
+            size_t tarRow = std::min(row + randomIndex(seed, 2), 
+                    (shapeCount - 1) / columns);
+            src = std::min(row * columns + randomIndex(seed, quarter), 
+                    shapeCount - 1);
+            tar = std::min(tarRow * columns + columns - 1 - 
+                    randomIndex(seed, quarter), shapeCount - 1);
+        }
+        else
+        {
+            tar = randomIndex(seed, shapeCount);
+        }
+        instance.connectors.push_back(std::make_pair(src, tar));
+    }
+    return instance;
+}
+
+static Point sourcePoint(const Rectangle& shape)
+{
+    return shape.ps[0] + Point(5, -5);
+}
+
+static Point targetPoint(const Rectangle& shape)
+{
+    return shape.ps[2] + Point(-5, 5);
+}
+
+// Checks the route of each connector, returning the number of failures.
+static int checkRoutes(const std::vector<ConnRef *>& conns, 
+        const std::vector<Point>& srcs, const std::vector<Point>& tars)
+{
+    int failures = 0;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        const PolyLine& route = conns[c]->displayRoute();
+        bool valid = (route.size() >= 2) && (route.ps[0] == srcs[c]) &&
+                (route.ps[route.size() - 1] == tars[c]);
+        if (valid && (conns[c]->routingType() == ConnType_Orthogonal))
+        {
+            for (size_t i = 1; i < route.size(); ++i)
+            {
+                if ((route.ps[i - 1].x != route.ps[i].x) &&
+                        (route.ps[i - 1].y != route.ps[i].y))
+                {
+                    valid = false;
+                }
+            }
+        }
+        if (!valid)
+        {
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+static void outputTransaction(const char *name, const double seconds,
+        const size_t connCount, const Router *router, const bool last)
+{
+    printf("        {\n");
+    printf("          \"name\": \"%s\",\n", name);
+    printf("          \"seconds\": %.6f,\n", seconds);
+    printf("          \"connectorsPerSecond\": %.1f,\n", 
+            (seconds > 0) ? (connCount / seconds) : 0.0);
+    printf("          \"statistics\": ");
+    fflush(stdout);
+    router->statistics().outputJSON(stdout);
+    printf("        }%s\n", (last) ? "" : ",");
+}
+
+// Routes the given instance, writing its results as a JSON object.  
+// Returns the number of routes that failed their checks.
+static int runBenchmark(const std::string& kind, const bool orthogonal,
+        const size_t shapeCount, const size_t connCount, 
+        const unsigned int seed, const bool sharedSearches, const bool last)
+{
+    Instance instance = generateInstance(kind, shapeCount, connCount, seed);
+    unsigned int moveSeed = seed + 1;
+
+    Router *router = new Router((orthogonal) ? OrthogonalRouting :
+            PolyLineRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+    router->setRoutingOption(searchConnectorPathsFromSharedSources, 
+            sharedSearches);
+
+    std::vector<ShapeRef *> shapes;
+    for (size_t s = 0; s < instance.shapes.size(); ++s)
+    {
+        shapes.push_back(new ShapeRef(router, instance.shapes[s]));
+    }
+    std::vector<ConnRef *> conns;
+    std::vector<Point> srcs, tars;
+    for (size_t c = 0; c < instance.connectors.size(); ++c)
+    {
+        srcs.push_back(sourcePoint(instance.shapes[
+                    instance.connectors[c].first]));
+        tars.push_back(targetPoint(instance.shapes[
+                    instance.connectors[c].second]));
+        ConnRef *conn = new ConnRef(router, srcs[c], tars[c]);
+        conn->setRoutingType((orthogonal) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+
+    printf("  {\n");
+    printf("    \"kind\": \"%s\",\n", kind.c_str());
+    printf("    \"mode\": \"%s\",\n", (orthogonal) ? "orthogonal" : 
+            "polyline");
+    printf("    \"shapes\": %lu,\n", (unsigned long) shapeCount);
+    printf("    \"connectors\": %lu,\n", (unsigned long) connCount);
+    printf("    \"seed\": %u,\n", seed);
+    printf("    \"sharedSearches\": %s,\n", 
+            (sharedSearches) ? "true" : "false");
+    printf("    \"transactions\": [\n");
+
+    router->resetStatistics();
+    double start = wallTime();
+    router->processTransaction();
+    double seconds = wallTime() - start;
+    int failures = checkRoutes(conns, srcs, tars);
+    outputTransaction("initial", seconds, conns.size(), router, false);
+
+    // Move one in a hundred shapes, along with connectors from them.
+    for (size_t s = 0; s < shapes.size(); s += 100)
+    {
+        Point offset(randomValue(moveSeed, -5, 5), 
+                randomValue(moveSeed, -5, 5));
+        router->moveShape(shapes[s], offset.x, offset.y);
+        for (size_t c = 0; c < conns.size(); ++c)
+        {
+            if (instance.connectors[c].first == s)
+            {
+                srcs[c] = srcs[c] + offset;
+                conns[c]->setSourceEndpoint(srcs[c]);
+            }
+            if (instance.connectors[c].second == s)
+            {
+                tars[c] = tars[c] + offset;
+                conns[c]->setDestEndpoint(tars[c]);
+            }
+        }
+    }
+    router->resetStatistics();
+    start = wallTime();
+    router->processTransaction();
+    seconds = wallTime() - start;
+    failures += checkRoutes(conns, srcs, tars);
+    outputTransaction("move", seconds, conns.size(), router, true);
+
+    printf("    ],\n");
+    printf("    \"failedRoutes\": %d,\n", failures);
+    printf("    \"peakMemoryKiB\": %ld\n", peakMemory());
+    printf("  }%s\n", (last) ? "" : ",");
+    fflush(stdout);
+
+    delete router;
+    return failures;
+}
+
+// Routes one instance, in a child process where fork() is available, so
+// that the peak memory reported by that process is for this instance 
+// alone.  Returns non-zero if any routes failed.
+static int runInstance(const std::string& kind, const bool orthogonal,
+        const size_t shapeCount, const size_t connCount, 
+        const unsigned int seed, const bool sharedSearches, const bool last)
+{
+#ifndef _WIN32
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int failures = runBenchmark(kind, orthogonal, shapeCount, connCount,
+                seed, sharedSearches, last);
+        fflush(stdout);
+        _exit((failures == 0) ? 0 : 1);
+    }
+    else if (pid > 0)
+    {
+        int status = 0;
+        if ((waitpid(pid, &status, 0) == pid) && WIFEXITED(status))
+        {
+            return WEXITSTATUS(status);
+        }
+        fprintf(stderr, "benchmark: %s instance did not finish\n", 
+                kind.c_str());
+        return 1;
+    }
+#endif
+    return runBenchmark(kind, orthogonal, shapeCount, connCount, seed, 
+            sharedSearches, last);
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--full] "
+            "[--kind grid|random|clustered|bus|fan] "
+            "[--mode polyline|orthogonal] [--shapes N] "
+            "[--connectors M] [--seed S] [--shared-searches]\n", program);
+    return 2;
+}
+
+static bool isKind(const std::string& kind)
+{
+    for (size_t k = 0; k < kindCount; ++k)
+    {
+        if (kind == kinds[k])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    bool full = false;
+    bool sharedSearches = false;
+    std::string kind;
+    std::string mode;
+    size_t shapeCount = 0;
+    size_t connCount = 0;
+    unsigned int seed = 1;
+    for (int a = 1; a < argc; ++a)
+    {
+        std::string arg = argv[a];
+        bool hasValue = (a + 1 < argc);
+        if (arg == "--full")
+        {
+            full = true;
+        }
+        else if (arg == "--shared-searches")
+        {
+            sharedSearches = true;
+        }
+        else if ((arg == "--kind") && hasValue)
+        {
+            kind = argv[++a];
+        }
+        else if ((arg == "--mode") && hasValue)
+        {
+            mode = argv[++a];
+        }
+        else if ((arg == "--shapes") && hasValue)
+        {
+            shapeCount = strtoul(argv[++a], NULL, 10);
+        }
+        else if ((arg == "--connectors") && hasValue)
+        {
+            connCount = strtoul(argv[++a], NULL, 10);
+        }
+        else if ((arg == "--seed") && hasValue)
+        {
+            seed = strtoul(argv[++a], NULL, 10);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    // Reject unknown kinds and modes rather than routing some other
+    // instance, or none, and reporting that as the result.
+    if ((!kind.empty() && !isKind(kind)) || (!mode.empty() && 
+                (mode != "polyline") && (mode != "orthogonal")))
+    {
+        return usage(argv[0]);
+    }
+
+    std::vector<size_t> sizes;
+    if (shapeCount > 0)
+    {
+        sizes.push_back(shapeCount);
+    }
+    else if (full)
+    {
+        sizes.push_back(100);
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(50000);
+    }
+    else
+    {
+        sizes.push_back(100);
+    }
+
+    // Work out the runs, so we know which is last.
+    std::vector<std::pair<std::string, std::pair<bool, size_t> > > runs;
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        for (size_t m = 0; m < 2; ++m)
+        {
+            bool orthogonal = (m == 1);
+            if (!mode.empty() && 
+                    ((mode == "orthogonal") != orthogonal))
+            {
+                continue;
+            }
+            if (!orthogonal && (shapeCount == 0) && (sizes[s] > 10000))
+            {
+                continue;
+            }
+            for (size_t k = 0; k < kindCount; ++k)
+            {
+                if (kind.empty() || (kind == kinds[k]))
+                {
+                    runs.push_back(std::make_pair(std::string(kinds[k]),
+                                std::make_pair(orthogonal, sizes[s])));
+                }
+            }
+        }
+    }
+
+    int failures = 0;
+    printf("[\n");
+    for (size_t r = 0; r < runs.size(); ++r)
+    {
+        size_t n = runs[r].second.second;
+        failures += runInstance(runs[r].first, runs[r].second.first, n,
+                (connCount > 0) ? connCount : n, seed, sharedSearches,
+                (r + 1 == runs.size()));
+    }
+    printf("]\n");
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes long orthogonal connectors across a grid of shapes with and
+// without the searchConnectorPathsBidirectionally option, and checks that
+// each route has the same length and number of bends either way.  Some
+// connectors are attached to connection pins, some are poly-line, and the
+// bidirectional searches are also run in parallel, which returns their
+// paths rather than setting the vertices' links.  The same is checked for
+// connectors to points inside pockets that open away from the sources,
+// which a search from the source alone has to explore around, and where 
+// searching from both ends must expand fewer nodes.
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/geometry.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const double segmentPenaltyValue = 50;
+static const unsigned int pinClass = 1;
+
+// The cost of a route, as used by the search: its length plus a penalty
+// for each bend.  Routes may pass straight through some of their points.
+static double routeCost(const PolyLine& route, const bool orthogonal)
+{
+    double cost = 0;
+    for (size_t i = 1; i < route.size(); ++i)
+    {
+        double xDiff = route.ps[i].x - route.ps[i - 1].x;
+        double yDiff = route.ps[i].y - route.ps[i - 1].y;
+        cost += (orthogonal) ? (fabs(xDiff) + fabs(yDiff)) :
+                sqrt((xDiff * xDiff) + (yDiff * yDiff));
+        if (orthogonal && (i + 1 < route.size()) &&
+                (vecDir(route.ps[i - 1], route.ps[i], route.ps[i + 1]) != 0))
+        {
+            cost += segmentPenaltyValue;
+        }
+    }
+    return cost;
+}
+
+// Adds a grid of shapes to the router, and connectors running from the
+// left of the grid to the right.  Every eighth connector leaves from a
+// pin on a shape on the left, and every fifth is poly-line.
+static std::vector<ConnRef *> addGridDiagram(Router *router)
+{
+    const int shapesPerSide = 12;
+    unsigned int seed = 11;
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < shapesPerSide; ++i)
+    {
+        for (int j = 0; j < shapesPerSide; ++j)
+        {
+            double x = i * 90 + randomValue(seed, 0, 20);
+            double y = j * 90 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 50),
+                        y + randomValue(seed, 20, 50)));
+            ShapeRef *shape = new ShapeRef(router, rect);
+            new ShapeConnectionPin(shape, pinClass, ATTACH_POS_RIGHT,
+                    ATTACH_POS_CENTRE, 0.0, ConnDirRight);
+            shapes.push_back(shape);
+        }
+    }
+
+    const double extent = shapesPerSide * 90;
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 40; ++c)
+    {
+        ConnEnd srcEnd(Point(-50, randomValue(seed, 0, extent)));
+        if ((c % 8) == 0)
+        {
+            srcEnd = ConnEnd(shapes[(int) randomValue(seed, 0,
+                        shapesPerSide)], pinClass);
+        }
+        ConnEnd dstEnd(Point(extent + 50, randomValue(seed, 0, extent)));
+        ConnRef *conn = new ConnRef(router, srcEnd, dstEnd);
+        conn->setRoutingType(((c % 5) == 4) ? ConnType_PolyLine :
+                ConnType_Orthogonal);
+        conns.push_back(conn);
+    }
+    return conns;
+}
+
+// Adds a grid of pockets, each made of three shapes and open to the 
+// right, and connectors from the left of the grid to points inside the 
+// pockets on its right half.
+static std::vector<ConnRef *> addPocketDiagram(Router *router)
+{
+    const int pocketsPerSide = 8;
+    unsigned int seed = 5;
+    for (int i = 0; i < pocketsPerSide; ++i)
+    {
+        for (int j = 0; j < pocketsPerSide; ++j)
+        {
+            Point corner(i * 400 + 100, j * 400 + 100);
+            Rectangle top(corner, corner + Point(200, 10));
+            Rectangle bottom(corner + Point(0, 190), corner + Point(200, 200));
+            Rectangle back(corner, corner + Point(10, 200));
+            new ShapeRef(router, top);
+            new ShapeRef(router, bottom);
+            new ShapeRef(router, back);
+        }
+    }
+
+    const double extent = pocketsPerSide * 400;
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 20; ++c)
+    {
+        int i = (int) randomValue(seed, pocketsPerSide / 2, pocketsPerSide);
+        int j = (int) randomValue(seed, 0, pocketsPerSide);
+        ConnEnd srcEnd(Point(-100, randomValue(seed, 0, extent)));
+        ConnEnd dstEnd(Point(i * 400 + 150, j * 400 + 200));
+        ConnRef *conn = new ConnRef(router, srcEnd, dstEnd);
+        conn->setRoutingType(ConnType_Orthogonal);
+        conns.push_back(conn);
+    }
+    return conns;
+}
+
+static std::vector<double> routeDiagram(const bool pockets, 
+        const bool bidirectional, const bool parallel, 
+        unsigned long& nodesExpanded)
+{
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingOption(searchConnectorPathsBidirectionally,
+            bidirectional);
+    router->setRoutingOption(searchConnectorPathsInParallel, parallel);
+    router->setRoutingPenalty(segmentPenalty, segmentPenaltyValue);
+    std::vector<ConnRef *> conns = (pockets) ? addPocketDiagram(router) :
+            addGridDiagram(router);
+    router->processTransaction();
+    nodesExpanded =
+            router->statistics().counter(aStarNodesExpandedCounter);
+
+    std::vector<double> costs;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        costs.push_back(routeCost(conns[c]->route(),
+                    conns[c]->routingType() == ConnType_Orthogonal));
+    }
+    delete router;
+    return costs;
+}
+
+// Returns whether the routes found cost the same as those in expected.
+static bool sameCosts(const std::vector<double>& expected,
+        const std::vector<double>& costs, const char *searches)
+{
+    bool same = true;
+    for (size_t c = 0; c < expected.size(); ++c)
+    {
+        if (fabs(expected[c] - costs[c]) > 0.0001)
+        {
+            printf("Route %d costs %g with %s searches, not %g.\n",
+                    (int) c, costs[c], searches, expected[c]);
+            same = false;
+        }
+    }
+    return same;
+}
+
+// Routes one of the diagrams each way, returning whether the routes cost
+// the same, and, if fewerNodes is set, whether the bidirectional searches
+// expanded fewer nodes.
+static bool compareSearches(const bool pockets, const bool fewerNodes)
+{
+    unsigned long forwardNodes = 0;
+    unsigned long bidirectionalNodes = 0;
+    unsigned long parallelNodes = 0;
+    std::vector<double> forwardCosts =
+            routeDiagram(pockets, false, false, forwardNodes);
+    std::vector<double> bidirectionalCosts =
+            routeDiagram(pockets, true, false, bidirectionalNodes);
+    std::vector<double> parallelCosts =
+            routeDiagram(pockets, true, true, parallelNodes);
+    printf("Bidirectional searches expanded %lu nodes, forward ones %lu.\n",
+            bidirectionalNodes, forwardNodes);
+
+    bool same = sameCosts(forwardCosts, bidirectionalCosts, "bidirectional");
+    same = sameCosts(forwardCosts, parallelCosts, "parallel bidirectional") &&
+            same;
+    return same && (!fewerNodes || (bidirectionalNodes < forwardNodes));
+}
+
+int main(void)
+{
+    if (!compareSearches(false, false) || !compareSearches(true, true))
+    {
+        return 1;
+    }
+    return 0;
+}
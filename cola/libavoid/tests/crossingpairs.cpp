@@ -0,0 +1,125 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes a diagram with the crossing and shared path penalties set, then
+// checks that every pair of routes found to cross or share a path by
+// comparing all pairs is also reported by findPossiblyCrossingRoutes(),
+// which the router uses to skip the pairs that can't cross.
+
+#include <vector>
+#include <set>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+int main(void)
+{
+    unsigned int seed = 3;
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+    router->setRoutingPenalty(crossingPenalty, 200);
+    router->setRoutingPenalty(fixedSharedPathPenalty, 110);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 7; ++i)
+    {
+        for (int j = 0; j < 7; ++j)
+        {
+            double x = i * 70 + randomValue(seed, 0, 20);
+            double y = j * 70 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 35),
+                        y + randomValue(seed, 20, 35)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 80; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        conn->setRoutingType((c % 3) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    router->processTransaction();
+
+    std::vector<Polygon> routeCopies;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        routeCopies.push_back(conns[c]->displayRoute());
+    }
+    RouteList routes;
+    for (size_t c = 0; c < routeCopies.size(); ++c)
+    {
+        routes.push_back(&routeCopies[c]);
+    }
+    RouteIndexPairList pairs;
+    findPossiblyCrossingRoutes(routes, pairs);
+    std::set<RouteIndexPair> nearby(pairs.begin(), pairs.end());
+
+    int crossingPairs = 0;
+    int missed = 0;
+    for (size_t i = 0; i < routes.size(); ++i)
+    {
+        for (size_t j = i + 1; j < routes.size(); ++j)
+        {
+            Polygon& iRoute = *(routes[i]);
+            Polygon& jRoute = *(routes[j]);
+            ConnectorCrossings cross(iRoute, true, jRoute, conns[i], 
+                    conns[j]);
+            bool crosses = false;
+            for (size_t jInd = 1; jInd < jRoute.size(); ++jInd)
+            {
+                cross.countForSegment(jInd, (jInd + 1) == jRoute.size());
+                if ((cross.crossingCount > 0) || 
+                        (cross.crossingFlags != CROSSING_NONE))
+                {
+                    crosses = true;
+                }
+            }
+            if (crosses)
+            {
+                ++crossingPairs;
+                if (nearby.find(std::make_pair(i, j)) == nearby.end())
+                {
+                    printf("Missed crossing of connectors %u and %u.\n",
+                            conns[i]->id(), conns[j]->id());
+                    ++missed;
+                }
+            }
+        }
+    }
+    printf("%d crossing pairs, %d nearby pairs, of %d pairs.\n",
+            crossingPairs, (int) pairs.size(), 
+            (int) (routes.size() * (routes.size() - 1) / 2));
+
+    delete router;
+    return (missed == 0) ? 0 : 1;
+}
+
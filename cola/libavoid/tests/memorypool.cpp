@@ -0,0 +1,140 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+
+// Checks that MemoryPool reuses freed blocks and releases its memory when
+// reset, and that the router's pools hold exactly the vertices and edges 
+// of the orthogonal visibility graph as it is regenerated.
+
+#include <set>
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/pool.h"
+
+using namespace Avoid;
+
+// Returns false if the router's pools hold anything other than the 
+// current orthogonal visibility graph.
+static bool poolsMatchGraph(Router *router)
+{
+    size_t dummyVertices = 0;
+    for (VertInf *vert = router->vertices.connsBegin(); 
+            vert != router->vertices.end(); vert = vert->lstNext)
+    {
+        if ((vert->id == dummyOrthogID) || (vert->id == dummyOrthogShapeID))
+        {
+            ++dummyVertices;
+        }
+    }
+    return (dummyVertices > 0) &&
+            (router->vertInfPool.blocksInUse() == dummyVertices) &&
+            (router->edgeInfPool.blocksInUse() == 
+                (size_t) router->visOrthogGraph.size());
+}
+
+int main(void)
+{
+    int errors = 0;
+
+    MemoryPool pool(sizeof(double), 4);
+    std::vector<void *> blocks;
+    for (int i = 0; i < 10; ++i)
+    {
+        blocks.push_back(pool.allocate());
+    }
+    if ((std::set<void *>(blocks.begin(), blocks.end()).size() != 10) ||
+            (pool.blocksInUse() != 10))
+    {
+        fprintf(stderr, "Pool blocks not distinct.\n");
+        ++errors;
+    }
+    std::set<void *> freed;
+    for (int i = 3; i < 6; ++i)
+    {
+        pool.deallocate(blocks[i]);
+        freed.insert(blocks[i]);
+    }
+    for (int i = 3; i < 6; ++i)
+    {
+        if (freed.count(pool.allocate()) == 0)
+        {
+            fprintf(stderr, "Freed pool block not reused.\n");
+            ++errors;
+        }
+    }
+    if (pool.blocksInUse() != 10)
+    {
+        fprintf(stderr, "Wrong pool block count.\n");
+        ++errors;
+    }
+    pool.reset();
+    if ((pool.blocksInUse() != 0) || (pool.chunkCount() != 0))
+    {
+        fprintf(stderr, "Pool memory not released by reset.\n");
+        ++errors;
+    }
+    pool.allocate();
+    if ((pool.blocksInUse() != 1) || (pool.chunkCount() != 1))
+    {
+        fprintf(stderr, "Pool not usable after reset.\n");
+        ++errors;
+    }
+
+    Router *router = new Router(OrthogonalRouting);
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            Rectangle rect(Point(i * 60, j * 60), 
+                    Point(i * 60 + 30, j * 60 + 30));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+    for (int c = 0; c < 8; ++c)
+    {
+        new ConnRef(router, ConnEnd(Point(c * 60 + 15, -20)),
+                ConnEnd(Point((7 - c) * 30 + 15, 250)));
+    }
+    router->processTransaction();
+    if (!poolsMatchGraph(router))
+    {
+        fprintf(stderr, "Pools don't match graph after routing.\n");
+        ++errors;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        router->moveShape(shapes[5 * i], 7, 4);
+        router->processTransaction();
+        if (!poolsMatchGraph(router))
+        {
+            fprintf(stderr, "Pools don't match graph after move %d.\n", i);
+            ++errors;
+        }
+    }
+
+    delete router;
+    return (errors == 0) ? 0 : 1;
+}
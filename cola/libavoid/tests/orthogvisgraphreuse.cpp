@@ -0,0 +1,212 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Makes the same changes to three routers: one that regenerates the
+// orthogonal visibility graph whenever something it is built from changes,
+// one that updates the graph where things have changed instead, and one 
+// that also does so but regenerates the graph after every transaction to 
+// check it matches the graph that would otherwise have been reused or 
+// updated.  Changes to connectors attached to connection pins leave the 
+// graph unchanged, while moving free connector endpoints and moving, 
+// adding or removing shapes change it.  The routes found by the routers 
+// must be the same throughout.
+
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const unsigned int pinClassId = 1;
+
+struct Diagram
+{
+    Diagram(bool incremental, bool verify)
+        : router(new Router(OrthogonalRouting)),
+          addedShape(NULL)
+    {
+        router->setRoutingPenalty(segmentPenalty, 50);
+        router->setRoutingOption(updateOrthogonalVisGraphIncrementally,
+                incremental);
+        router->setRoutingOption(verifyOrthogonalVisGraphUpdates, verify);
+
+        unsigned int seed = 5;
+        for (int i = 0; i < 6; ++i)
+        {
+            for (int j = 0; j < 6; ++j)
+            {
+                double x = i * 90 + randomValue(seed, 0, 20);
+                double y = j * 90 + randomValue(seed, 0, 20);
+                Rectangle rect(Point(x, y), 
+                        Point(x + randomValue(seed, 20, 40),
+                            y + randomValue(seed, 20, 40)));
+                ShapeRef *shape = new ShapeRef(router, rect);
+                new ShapeConnectionPin(shape, pinClassId,
+                        ATTACH_POS_LEFT, ATTACH_POS_CENTRE);
+                new ShapeConnectionPin(shape, pinClassId,
+                        ATTACH_POS_RIGHT, ATTACH_POS_CENTRE);
+                shapes.push_back(shape);
+            }
+        }
+
+        for (int c = 0; c < 40; ++c)
+        {
+            ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+            ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+            ConnRef *conn = NULL;
+            if (c % 2)
+            {
+                conn = new ConnRef(router, ConnEnd(src, pinClassId),
+                        ConnEnd(tar, pinClassId));
+            }
+            else
+            {
+                conn = new ConnRef(router,
+                        ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                        ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+            }
+            conn->setRoutingType(ConnType_Orthogonal);
+            conns.push_back(conn);
+        }
+        router->processTransaction();
+    }
+
+    ~Diagram()
+    {
+        delete router;
+    }
+
+    std::vector<double> routes(void) const
+    {
+        return routeCoords(conns);
+    }
+
+    // Reattaches pinned connectors to other shapes.
+    void reattachPinnedConnectors(int step)
+    {
+        for (size_t c = 1; c < conns.size(); c += 2)
+        {
+            ShapeRef *src = shapes[(c * 7 + step) % shapes.size()];
+            ShapeRef *tar = shapes[(c * 13 + step * 5) % shapes.size()];
+            conns[c]->setEndpoints(ConnEnd(src, pinClassId), 
+                    ConnEnd(tar, pinClassId));
+        }
+        router->processTransaction();
+    }
+
+    // Sets free connector endpoints to where they already are.
+    void resetFreeConnectors(void)
+    {
+        for (size_t c = 0; c < conns.size(); c += 2)
+        {
+            std::pair<ConnEnd, ConnEnd> ends = conns[c]->endpointConnEnds();
+            conns[c]->setEndpoints(ends.first, ends.second);
+        }
+        router->processTransaction();
+    }
+
+    // Moves the free endpoints of one of the connectors that has them.
+    void moveFreeConnector(int step)
+    {
+        size_t c = (step * 6) % conns.size();
+        std::pair<ConnEnd, ConnEnd> ends = conns[c]->endpointConnEnds();
+        conns[c]->setEndpoints(
+                ConnEnd(ends.first.position() + Point(11, -4)), 
+                ConnEnd(ends.second.position() + Point(-6, 9)));
+        router->processTransaction();
+    }
+
+    void moveShape(size_t index, double xDiff, double yDiff)
+    {
+        router->moveShape(shapes[index], xDiff, yDiff);
+        router->processTransaction();
+    }
+
+    // Adds a shape between those in the grid, or removes the one added.
+    void addOrRemoveShape(int step)
+    {
+        if (addedShape)
+        {
+            router->deleteShape(addedShape);
+            addedShape = NULL;
+        }
+        else
+        {
+            double x = 60 + (step % 3) * 90;
+            double y = 25 + (step % 4) * 90;
+            Rectangle rect(Point(x, y), Point(x + 22, y + 50));
+            addedShape = new ShapeRef(router, rect);
+        }
+        router->processTransaction();
+    }
+
+    Router *router;
+    std::vector<ShapeRef *> shapes;
+    std::vector<ConnRef *> conns;
+    ShapeRef *addedShape;
+};
+
+int main(void)
+{
+    Diagram regenerated(false, false);
+    Diagram updated(true, false);
+    Diagram verified(true, true);
+    Diagram *diagrams[] = { &regenerated, &updated, &verified };
+
+    int mismatches = 0;
+    for (int step = 0; step < 24; ++step)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            switch (step % 6)
+            {
+                case 0:
+                    diagrams[d]->reattachPinnedConnectors(step);
+                    break;
+                case 1:
+                    diagrams[d]->resetFreeConnectors();
+                    break;
+                case 2:
+                    diagrams[d]->moveFreeConnector(step);
+                    break;
+                case 3:
+                case 4:
+                    diagrams[d]->moveShape((step * 5) % 36, 7, -3);
+                    break;
+                case 5:
+                    diagrams[d]->addOrRemoveShape(step);
+                    break;
+            }
+        }
+
+        if ((updated.routes() != regenerated.routes()) ||
+                (verified.routes() != regenerated.routes()))
+        {
+            printf("Routes differ after step %d.\n", step);
+            ++mismatches;
+        }
+    }
+
+    return (mismatches == 0) ? 0 : 1;
+}
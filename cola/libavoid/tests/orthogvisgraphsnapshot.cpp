@@ -0,0 +1,162 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+
+// Checks that the router's compact copy of the orthogonal visibility graph
+// matches the graph itself.  Vertices whose edges change after the copy is
+// made must no longer be found in it, until the graph is regenerated.
+
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/graph.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const unsigned int pinClassId = 1;
+
+// Returns the number of vertices found in the copy, or -1 if the 
+// neighbours of any of them differ from those in the graph.
+static int checkSnapshot(Router *router)
+{
+    int found = 0;
+    VisNeighbourList neighbours;
+    for (VertInf *vert = router->vertices.connsBegin(); 
+            vert != router->vertices.end(); vert = vert->lstNext)
+    {
+        if (!router->visOrthogGraphSnapshot.copyNeighbours(vert, neighbours))
+        {
+            continue;
+        }
+        ++found;
+        if (neighbours.size() != vert->orthogVisListSize)
+        {
+            return -1;
+        }
+        size_t i = 0;
+        for (EdgeInfList::const_iterator edge = vert->orthogVisList.begin();
+                edge != vert->orthogVisList.end(); ++edge, ++i)
+        {
+            if ((neighbours[i].edge != *edge) || 
+                    (neighbours[i].vert != (*edge)->otherVert(vert)) ||
+                    (neighbours[i].dist != (*edge)->getDist()))
+            {
+                return -1;
+            }
+        }
+    }
+    return found;
+}
+
+int main(void)
+{
+    Router *router = new Router(OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+
+    unsigned int seed = 3;
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 5; ++i)
+    {
+        for (int j = 0; j < 5; ++j)
+        {
+            double x = i * 80 + randomValue(seed, 0, 20);
+            double y = j * 80 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + 30, y + 30));
+            ShapeRef *shape = new ShapeRef(router, rect);
+            new ShapeConnectionPin(shape, pinClassId,
+                    ATTACH_POS_CENTRE, ATTACH_POS_TOP);
+            shapes.push_back(shape);
+        }
+    }
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 20; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnEnd srcEnd = (c % 2) ? ConnEnd(src, pinClassId) : 
+                ConnEnd(src->polygon().ps[0]);
+        conns.push_back(new ConnRef(router, srcEnd, ConnEnd(tar, pinClassId)));
+    }
+    router->processTransaction();
+
+    int errors = 0;
+    int initialCount = checkSnapshot(router);
+    if (initialCount <= 0)
+    {
+        fprintf(stderr, "Snapshot missing or wrong after routing.\n");
+        ++errors;
+    }
+
+    // Adding an edge must remove both its vertices from the copy.
+    VertInf *vert1 = NULL, *vert2 = NULL;
+    VisNeighbourList neighbours;
+    for (VertInf *vert = router->vertices.shapesBegin(); 
+            vert != router->vertices.end(); vert = vert->lstNext)
+    {
+        if ((vert->orthogVisListSize > 0) && 
+                router->visOrthogGraphSnapshot.copyNeighbours(vert, 
+                    neighbours))
+        {
+            vert1 = vert;
+            vert2 = neighbours[0].vert;
+            break;
+        }
+    }
+    EdgeInf *edge = new EdgeInf(vert1, vert2, true);
+    edge->setDist(1);
+    if (router->visOrthogGraphSnapshot.copyNeighbours(vert1, neighbours) ||
+            router->visOrthogGraphSnapshot.copyNeighbours(vert2, neighbours))
+    {
+        fprintf(stderr, "Changed vertex found in snapshot.\n");
+        ++errors;
+    }
+    delete edge;
+    if (checkSnapshot(router) != initialCount - 2)
+    {
+        fprintf(stderr, "Snapshot wrong after removing edge.\n");
+        ++errors;
+    }
+
+    // Changing connection pin connectors leaves the graph to be reused.
+    conns[1]->setDestEndpoint(ConnEnd(shapes[7], pinClassId));
+    router->processTransaction();
+    if (checkSnapshot(router) <= 0)
+    {
+        fprintf(stderr, "Snapshot wrong after connector change.\n");
+        ++errors;
+    }
+
+    // Moving a shape regenerates the graph and the copy.
+    router->moveShape(shapes[12], 5, 5);
+    router->processTransaction();
+    int movedCount = checkSnapshot(router);
+    if (movedCount <= 0)
+    {
+        fprintf(stderr, "Snapshot wrong after regeneration.\n");
+        ++errors;
+    }
+
+    delete router;
+    return (errors == 0) ? 0 : 1;
+}
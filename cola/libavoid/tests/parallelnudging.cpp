@@ -0,0 +1,92 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Nudges the routes of a dense diagram using one thread and then several
+// threads, and checks the resulting routes are identical.  Each region of
+// overlapping segments is nudged independently, so the order regions are
+// solved in must not matter.
+
+#include <vector>
+#include <cstdio>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static std::vector<double> routeDiagram(const int threads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    unsigned int seed = 7;
+    Router *router = new Router(OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+    router->setOrthogonalNudgeDistance(4);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int j = 0; j < 6; ++j)
+        {
+            double x = i * 100 + randomValue(seed, 0, 20);
+            double y = j * 100 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 40),
+                        y + randomValue(seed, 20, 40)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    // Many connectors between few shapes, so that routes share channels.
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 120; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-3, -3 - (c % 5))),
+                ConnEnd(tar->polygon().ps[2] + Point(3 + (c % 7), 3)));
+        conn->setRoutingType(ConnType_Orthogonal);
+        conns.push_back(conn);
+    }
+    router->processTransaction();
+
+    std::vector<double> routes = routeCoords(conns);
+    delete router;
+    return routes;
+}
+
+int main(void)
+{
+    std::vector<double> serialRoutes = routeDiagram(1);
+    std::vector<double> parallelRoutes = routeDiagram(4);
+
+    if (serialRoutes != parallelRoutes)
+    {
+        printf("Routes differ when nudged in parallel.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes the same diagram with and without the searchConnectorPathsInParallel
+// option and checks that the resulting routes are identical.
+
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static std::vector<double> routeDiagram(const bool parallel)
+{
+    unsigned int seed = 42;
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingOption(searchConnectorPathsInParallel, parallel);
+    router->setRoutingPenalty(segmentPenalty, 50);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 8; ++i)
+    {
+        for (int j = 0; j < 8; ++j)
+        {
+            double x = i * 80 + randomValue(seed, 0, 20);
+            double y = j * 80 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 40),
+                        y + randomValue(seed, 20, 40)));
+            ShapeRef *shape = new ShapeRef(router, rect);
+            new ShapeConnectionPin(shape, 1, 0.5, 0.5, 0, ConnDirAll);
+            shapes.push_back(shape);
+        }
+    }
+
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 60; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = NULL;
+        if (c % 10 == 0)
+        {
+            // Pin connections are still routed one at a time.
+            conn = new ConnRef(router, ConnEnd(src, 1), ConnEnd(tar, 1));
+        }
+        else
+        {
+            conn = new ConnRef(router,
+                    ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                    ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        }
+        conn->setRoutingType((c % 3) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    router->processTransaction();
+
+    for (size_t s = 0; s < shapes.size(); s += 3)
+    {
+        router->moveShape(shapes[s], randomValue(seed, -15, 15),
+                randomValue(seed, -15, 15));
+    }
+    router->processTransaction();
+
+    std::vector<double> routes = routeCoords(conns);
+    delete router;
+    return routes;
+}
+
+int main(void)
+{
+    std::vector<double> serialRoutes = routeDiagram(false);
+    std::vector<double> parallelRoutes = routeDiagram(true);
+
+    if (serialRoutes != parallelRoutes)
+    {
+        printf("Routes differ when searched in parallel.\n");
+        return 1;
+    }
+    return 0;
+}
+
@@ -0,0 +1,152 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes poly-line connectors through a grid of shapes while shapes are
+// moved, removed and re-added, and checks that no route ever passes
+// through a shape.  This exercises the blocking tests that use the
+// router's spatial index of obstacles and visibility edges.
+
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/geometry.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const int gridSize = 8;
+static const double cellSize = 60;
+
+static unsigned int seed = 1;
+
+static int countBlockedRoutes(Router *router,
+        const std::vector<ShapeRef *>& shapes,
+        const std::vector<ConnRef *>& conns)
+{
+    int blocked = 0;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        const PolyLine& route = conns[c]->displayRoute();
+        const Point& src = route.ps.front();
+        const Point& tar = route.ps.back();
+        for (size_t s = 0; s < shapes.size(); ++s)
+        {
+            if (shapes[s] == NULL)
+            {
+                continue;
+            }
+            const Polygon& poly = shapes[s]->polygon();
+            if (inPoly(poly, src) || inPoly(poly, tar))
+            {
+                // Routes may leave shapes containing their endpoints.
+                continue;
+            }
+            for (size_t i = 1; i < route.size(); ++i)
+            {
+                const Point& a = route.ps[i - 1];
+                const Point& b = route.ps[i];
+                Point mid((a.x + b.x) / 2, (a.y + b.y) / 2);
+                bool crosses = inPoly(poly, mid, false);
+                for (size_t j = 0; !crosses && (j < poly.size()); ++j)
+                {
+                    const Point& p1 = poly.ps[j];
+                    const Point& p2 = poly.ps[(j + 1) % poly.size()];
+                    crosses = segmentIntersect(a, b, p1, p2);
+                }
+                if (crosses)
+                {
+                    printf("Connector %u passes through shape %u.\n",
+                            conns[c]->id(), shapes[s]->id());
+                    ++blocked;
+                    break;
+                }
+            }
+        }
+    }
+    return blocked;
+}
+
+int main(void)
+{
+    Router *router = new Router(PolyLineRouting);
+
+    std::vector<ShapeRef *> shapes;
+    std::vector<Polygon> polys;
+    for (int i = 0; i < gridSize; ++i)
+    {
+        for (int j = 0; j < gridSize; ++j)
+        {
+            double x = i * cellSize + randomValue(seed, 0, 10);
+            double y = j * cellSize + randomValue(seed, 0, 10);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 15, 30),
+                        y + randomValue(seed, 15, 30)));
+            polys.push_back(rect);
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    // Connector endpoints are placed in the gaps between shapes.
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 30; ++c)
+    {
+        int i1 = (int) randomValue(seed, 0, gridSize);
+        int j1 = (int) randomValue(seed, 0, gridSize);
+        int i2 = (int) randomValue(seed, 0, gridSize);
+        int j2 = (int) randomValue(seed, 0, gridSize);
+        ConnEnd srcPt(Point(i1 * cellSize + 50, j1 * cellSize + 50));
+        ConnEnd tarPt(Point(i2 * cellSize + 50, j2 * cellSize + 50));
+        conns.push_back(new ConnRef(router, srcPt, tarPt));
+    }
+    router->processTransaction();
+    int blocked = countBlockedRoutes(router, shapes, conns);
+
+    // Move some shapes across the gaps.
+    for (size_t s = 0; s < shapes.size(); s += 5)
+    {
+        router->moveShape(shapes[s], randomValue(seed, -30, 30),
+                randomValue(seed, -30, 30));
+    }
+    router->processTransaction();
+    blocked += countBlockedRoutes(router, shapes, conns);
+
+    // Remove some shapes.
+    for (size_t s = 3; s < shapes.size(); s += 7)
+    {
+        router->deleteShape(shapes[s]);
+        shapes[s] = NULL;
+    }
+    router->processTransaction();
+    blocked += countBlockedRoutes(router, shapes, conns);
+
+    // And then add them back, one transaction at a time.
+    for (size_t s = 3; s < shapes.size(); s += 7)
+    {
+        shapes[s] = new ShapeRef(router, polys[s]);
+        router->processTransaction();
+    }
+    blocked += countBlockedRoutes(router, shapes, conns);
+
+    delete router;
+    return (blocked == 0) ? 0 : 1;
+}
+
@@ -0,0 +1,147 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes a diagram with the crossing and shared path penalties set, moves
+// some shapes and routes it again, then checks that the router's index of
+// route segments reports every connector with a segment touching each
+// route segment, as the crossing penalty cost relies on this.  Only
+// horizontal and vertical segments are compared, as for these touching
+// bounding boxes means touching segments.
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/spatialindex.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static bool isAxisAligned(const Point& a, const Point& b)
+{
+    return (a.x == b.x) || (a.y == b.y);
+}
+
+// For axis-aligned segments, touching bounding boxes means the segments
+// themselves touch.
+static bool segmentBoxesTouch(const Point& a1, const Point& a2,
+        const Point& b1, const Point& b2)
+{
+    return (std::min(a1.x, a2.x) <= std::max(b1.x, b2.x)) &&
+            (std::min(b1.x, b2.x) <= std::max(a1.x, a2.x)) &&
+            (std::min(a1.y, a2.y) <= std::max(b1.y, b2.y)) &&
+            (std::min(b1.y, b2.y) <= std::max(a1.y, a2.y));
+}
+
+static int countMissedConnectors(Router *router, 
+        const std::vector<ConnRef *>& conns)
+{
+    int missed = 0;
+    ConnRefVector nearby;
+    for (size_t i = 0; i < conns.size(); ++i)
+    {
+        const PolyLine& iRoute = conns[i]->route();
+        for (size_t s = 1; s < iRoute.size(); ++s)
+        {
+            if (!isAxisAligned(iRoute.ps[s - 1], iRoute.ps[s]))
+            {
+                continue;
+            }
+            router->spatialIndex.connectorsNearSegment(iRoute.ps[s - 1],
+                    iRoute.ps[s], nearby);
+            for (size_t j = 0; j < conns.size(); ++j)
+            {
+                const PolyLine& jRoute = conns[j]->route();
+                bool touches = false;
+                for (size_t t = 1; !touches && (t < jRoute.size()); ++t)
+                {
+                    touches = isAxisAligned(jRoute.ps[t - 1], jRoute.ps[t]) &&
+                            segmentBoxesTouch(iRoute.ps[s - 1], 
+                            iRoute.ps[s], jRoute.ps[t - 1], jRoute.ps[t]);
+                }
+                if (touches && (std::find(nearby.begin(), nearby.end(), 
+                                conns[j]) == nearby.end()))
+                {
+                    printf("Connector %u missing near connector %u.\n",
+                            conns[j]->id(), conns[i]->id());
+                    ++missed;
+                }
+            }
+        }
+    }
+    return missed;
+}
+
+int main(void)
+{
+    unsigned int seed = 5;
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+    router->setRoutingPenalty(crossingPenalty, 200);
+    router->setRoutingPenalty(fixedSharedPathPenalty, 110);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int j = 0; j < 6; ++j)
+        {
+            double x = i * 70 + randomValue(seed, 0, 20);
+            double y = j * 70 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 35),
+                        y + randomValue(seed, 20, 35)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 60; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        conn->setRoutingType((c % 3) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    clock_t start = clock();
+    router->processTransaction();
+    printf("Routed with crossing penalties in %.3fs.\n",
+            (double) (clock() - start) / CLOCKS_PER_SEC);
+    int missed = countMissedConnectors(router, conns);
+
+    for (size_t s = 0; s < shapes.size(); s += 5)
+    {
+        router->moveShape(shapes[s], randomValue(seed, -15, 15),
+                randomValue(seed, -15, 15));
+    }
+    router->deleteConnector(conns.back());
+    conns.pop_back();
+    router->processTransaction();
+    missed += countMissedConnectors(router, conns);
+
+    delete router;
+    return (missed == 0) ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes a diagram with a hyperedge and checks that the router records the
+// work done in its statistics, that these can be written as JSON and that
+// they can be reset.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "libavoid/libavoid.h"
+
+using namespace Avoid;
+
+int main(void)
+{
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            Rectangle rect(Point(i * 100, j * 100), 
+                    Point(i * 100 + 40, j * 100 + 40));
+            new ShapeRef(router, rect);
+        }
+    }
+    JunctionRef *junction = new JunctionRef(router, Point(270, 270));
+    for (int c = 0; c < 10; ++c)
+    {
+        ConnRef *conn = new ConnRef(router, 
+                ConnEnd(Point(c * 35 - 10, -10)), 
+                ConnEnd(Point(360 - c * 20, 370)));
+        conn->setRoutingType((c % 2) ? ConnType_Orthogonal : 
+                ConnType_PolyLine);
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+        new ConnRef(router, ConnEnd(junction), 
+                ConnEnd(Point(c * 150 - 10, 380)));
+    }
+    router->processTransaction();
+
+    const RoutingStatistics& statistics = router->statistics();
+    int errors = 0;
+    if (statistics.counter(transactionsCounter) != 1)
+    {
+        printf("Expected one transaction.\n");
+        ++errors;
+    }
+    const RoutingCounter nonZero[] = { aStarNodesExpandedCounter, 
+            aStarEdgesRelaxedCounter, graphVerticesCounter, 
+            polyLineGraphEdgesCounter, orthogonalGraphEdgesCounter };
+    for (size_t c = 0; c < sizeof(nonZero) / sizeof(nonZero[0]); ++c)
+    {
+        if (statistics.counter(nonZero[c]) == 0)
+        {
+            printf("Counter %d was not counted.\n", (int) nonZero[c]);
+            ++errors;
+        }
+    }
+    for (int p = 0; p < lastRoutingPhaseMarker; ++p)
+    {
+        if (statistics.phaseTime((RoutingPhase) p) < 0)
+        {
+            printf("Phase %d has a negative time.\n", p);
+            ++errors;
+        }
+    }
+
+    FILE *fp = tmpfile();
+    statistics.outputJSON(fp);
+    rewind(fp);
+    std::string json;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), fp))
+    {
+        json += buffer;
+    }
+    fclose(fp);
+    if ((json.find("\"nudging\": ") == std::string::npos) ||
+            (json.find("\"aStarNodesExpanded\": ") == std::string::npos))
+    {
+        printf("Unexpected JSON:\n%s", json.c_str());
+        ++errors;
+    }
+
+    router->resetStatistics();
+    for (int c = 0; c < lastRoutingCounterMarker; ++c)
+    {
+        if (statistics.counter((RoutingCounter) c) != 0)
+        {
+            printf("Counter %d was not reset.\n", c);
+            ++errors;
+        }
+    }
+
+    delete router;
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes a diagram, then moves every shape away and back again so that
+// all connectors are rerouted with the router's search storage already in
+// use, and checks that the routes found are the same as the first time.
+// Searches must not depend on what earlier searches left behind.
+
+#include <vector>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const int repeats = 3;
+
+int main(void)
+{
+    unsigned int seed = 11;
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 7; ++i)
+    {
+        for (int j = 0; j < 7; ++j)
+        {
+            double x = i * 80 + randomValue(seed, 0, 20);
+            double y = j * 80 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 40),
+                        y + randomValue(seed, 20, 40)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 50; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        conn->setRoutingType((c % 2) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    router->processTransaction();
+    std::vector<double> firstRoutes = routeCoords(conns);
+
+    int mismatches = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        for (size_t s = 0; s < shapes.size(); ++s)
+        {
+            router->moveShape(shapes[s], 1000, 1000);
+        }
+        router->processTransaction();
+        for (size_t s = 0; s < shapes.size(); ++s)
+        {
+            router->moveShape(shapes[s], -1000, -1000);
+        }
+        router->processTransaction();
+
+        if (routeCoords(conns) != firstRoutes)
+        {
+            printf("Routes differ after rerouting %d.\n", r + 1);
+            ++mismatches;
+        }
+    }
+
+    delete router;
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes connectors fanning out from two shared source points with and
+// without the searchConnectorPathsFromSharedSources option, and checks
+// that each route has the same length and number of bends either way, and
+// that sharing the searches reduces the work done.  This is checked for
+// a small diagram and a larger one with many more connectors from each
+// source, which also covers estimating the distance to the nearest of 
+// many targets.  The benchmark's "fan" instances time the searches.
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const double segmentPenaltyValue = 50;
+
+// The cost of a route, as used by the search: its length plus a penalty
+// for each bend.
+static double routeCost(const PolyLine& route, const bool orthogonal)
+{
+    double cost = 0;
+    for (size_t i = 1; i < route.size(); ++i)
+    {
+        double xDiff = route.ps[i].x - route.ps[i - 1].x;
+        double yDiff = route.ps[i].y - route.ps[i - 1].y;
+        cost += (orthogonal) ? (fabs(xDiff) + fabs(yDiff)) :
+                sqrt((xDiff * xDiff) + (yDiff * yDiff));
+    }
+    if (orthogonal && (route.size() > 2))
+    {
+        cost += (route.size() - 2) * segmentPenaltyValue;
+    }
+    return cost;
+}
+
+// Adds a grid of shapes to the router, and connectors from two source 
+// points to random shapes.
+static std::vector<ConnRef *> addDiagram(Router *router, 
+        const int shapesPerSide, const int connCount)
+{
+    unsigned int seed = 7;
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < shapesPerSide; ++i)
+    {
+        for (int j = 0; j < shapesPerSide; ++j)
+        {
+            double x = i * 90 + randomValue(seed, 0, 20);
+            double y = j * 90 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 50),
+                        y + randomValue(seed, 20, 50)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    const Point sources[] = { Point(-40, -40), Point(300, 75) };
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < connCount; ++c)
+    {
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router, ConnEnd(sources[c % 2]),
+                ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        conn->setRoutingType((c % 4) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    return conns;
+}
+
+static std::vector<double> routeDiagram(const int shapesPerSide,
+        const int connCount, const bool shared, unsigned long& nodesExpanded)
+{
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setRoutingOption(searchConnectorPathsFromSharedSources, shared);
+    router->setRoutingPenalty(segmentPenalty, segmentPenaltyValue);
+    std::vector<ConnRef *> conns = addDiagram(router, shapesPerSide, connCount);
+    router->processTransaction();
+    nodesExpanded =
+            router->statistics().counter(aStarNodesExpandedCounter);
+
+    std::vector<double> costs;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        costs.push_back(routeCost(conns[c]->route(),
+                    conns[c]->routingType() == ConnType_Orthogonal));
+    }
+    delete router;
+    return costs;
+}
+
+// Routes the diagram with and without shared searches, returning whether
+// the routes cost the same and the shared searches expanded fewer nodes.
+static bool compareSearches(const int shapesPerSide, const int connCount)
+{
+    unsigned long separateNodes = 0;
+    unsigned long sharedNodes = 0;
+    std::vector<double> separateCosts = 
+            routeDiagram(shapesPerSide, connCount, false, separateNodes);
+    std::vector<double> sharedCosts = 
+            routeDiagram(shapesPerSide, connCount, true, sharedNodes);
+
+    for (size_t c = 0; c < separateCosts.size(); ++c)
+    {
+        if (fabs(separateCosts[c] - sharedCosts[c]) > 0.0001)
+        {
+            printf("Route %d costs %g with shared searches, not %g.\n",
+                    (int) c, sharedCosts[c], separateCosts[c]);
+            return false;
+        }
+    }
+    printf("Shared searches expanded %lu nodes, separate ones %lu.\n",
+            sharedNodes, separateNodes);
+    return (sharedNodes < separateNodes);
+}
+
+int main(void)
+{
+    if (!compareSearches(7, 60) || !compareSearches(10, 200))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Helpers shared by the libavoid tests.
+
+#ifndef AVOID_TESTS_TESTUTILS_H
+#define AVOID_TESTS_TESTUTILS_H
+
+#include <vector>
+
+#include "libavoid/libavoid.h"
+
+// Returns a value between min and max from a fixed generator, so that 
+// tests lay out the same diagrams on every platform.
+static inline double randomValue(unsigned int& seed, double min, double max)
+{
+    seed = seed * 1103515245 + 12345;
+    double fraction = ((seed / 65536) % 32768) / 32768.0;
+    return min + (fraction * (max - min));
+}
+
+// Returns the coordinates of the points of the connectors' display routes,
+// in order, for comparing the routes found in different ways.
+static inline std::vector<double> routeCoords(
+        const std::vector<Avoid::ConnRef *>& conns)
+{
+    std::vector<double> coords;
+    for (size_t c = 0; c < conns.size(); ++c)
+    {
+        const Avoid::PolyLine& route = conns[c]->displayRoute();
+        for (size_t i = 0; i < route.size(); ++i)
+        {
+            coords.push_back(route.ps[i].x);
+            coords.push_back(route.ps[i].y);
+        }
+    }
+    return coords;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Routes several independent diagrams, each with its own Router, first
+// one after another and then concurrently on separate threads, and checks
+// that every diagram gets exactly the same routes both ways.
+
+#include <vector>
+#include <cstdio>
+#include <pthread.h>
+
+#include "libavoid/libavoid.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const int diagramCount = 8;
+static const int repeats = 3;
+
+struct Diagram
+{
+    unsigned int seed;
+    std::vector<double> routes;
+};
+
+static void routeDiagram(Diagram *diagram)
+{
+    unsigned int seed = diagram->seed;
+    Router *router = new Router(PolyLineRouting | OrthogonalRouting);
+    router->setOrthogonalNudgeDistance(4);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int j = 0; j < 6; ++j)
+        {
+            double x = i * 80 + randomValue(seed, 0, 20);
+            double y = j * 80 + randomValue(seed, 0, 20);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 20, 40),
+                        y + randomValue(seed, 20, 40)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+
+    std::vector<ConnRef *> conns;
+    for (int c = 0; c < 24; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-5, -5)),
+                ConnEnd(tar->polygon().ps[2] + Point(5, 5)));
+        conn->setRoutingType((c % 2) ? ConnType_Orthogonal :
+                ConnType_PolyLine);
+        conns.push_back(conn);
+    }
+    router->processTransaction();
+
+    for (size_t s = 0; s < shapes.size(); s += 4)
+    {
+        router->moveShape(shapes[s], randomValue(seed, -15, 15),
+                randomValue(seed, -15, 15));
+    }
+    router->processTransaction();
+
+    diagram->routes = routeCoords(conns);
+    delete router;
+}
+
+static void *routeDiagramThread(void *data)
+{
+    routeDiagram(static_cast<Diagram *> (data));
+    return NULL;
+}
+
+int main(void)
+{
+    std::vector<Diagram> serial(diagramCount);
+    for (int d = 0; d < diagramCount; ++d)
+    {
+        serial[d].seed = d + 1;
+        routeDiagram(&serial[d]);
+    }
+
+    int mismatches = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        std::vector<Diagram> parallel(diagramCount);
+        std::vector<pthread_t> threads(diagramCount);
+        for (int d = 0; d < diagramCount; ++d)
+        {
+            parallel[d].seed = d + 1;
+            if (pthread_create(&threads[d], NULL, routeDiagramThread,
+                        &parallel[d]) != 0)
+            {
+                printf("Failed to create thread %d.\n", d);
+                return 1;
+            }
+        }
+        for (int d = 0; d < diagramCount; ++d)
+        {
+            pthread_join(threads[d], NULL);
+        }
+        for (int d = 0; d < diagramCount; ++d)
+        {
+            if (parallel[d].routes != serial[d].routes)
+            {
+                printf("Diagram %d routed differently on thread.\n", d);
+                ++mismatches;
+            }
+        }
+    }
+    return (mismatches == 0) ? 0 : 1;
+}
+
@@ -0,0 +1,202 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * Licensees holding a valid commercial license may use this file in
+ * accordance with the commercial license agreement provided with the
+ * library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// Builds a diagram about the size of performance01 and looks up every
+// vertex in the router's vertex list by ID and by position, checking the
+// indexed lookups against a linear search of the list and reporting the
+// time taken by each.
+
+#include <vector>
+#include <cstdio>
+#include <ctime>
+
+#include "libavoid/libavoid.h"
+#include "libavoid/vertices.h"
+#include "testutils.h"
+
+using namespace Avoid;
+
+static const int gridSize = 16;
+static const int connCount = 400;
+static const int lookupRepeats = 100;
+static const unsigned int sampleStride = 100;
+
+static VertInf *linearFindByID(Router *router, const VertID& id)
+{
+    VertInf *last = router->vertices.end();
+    for (VertInf *curr = router->vertices.connsBegin(); curr != last;
+            curr = curr->lstNext)
+    {
+        if (curr->id == id)
+        {
+            return curr;
+        }
+    }
+    return NULL;
+}
+
+static VertInf *linearFindByPos(Router *router, const Point& p)
+{
+    VertInf *last = router->vertices.end();
+    for (VertInf *curr = router->vertices.shapesBegin(); curr != last;
+            curr = curr->lstNext)
+    {
+        if (curr->point == p)
+        {
+            return curr;
+        }
+    }
+    return NULL;
+}
+
+static double elapsed(clock_t start)
+{
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    unsigned int seed = 7;
+    Router *router = new Router(OrthogonalRouting);
+    router->setRoutingPenalty(segmentPenalty, 50);
+    router->setOrthogonalNudgeDistance(4);
+
+    std::vector<ShapeRef *> shapes;
+    for (int i = 0; i < gridSize; ++i)
+    {
+        for (int j = 0; j < gridSize; ++j)
+        {
+            double x = i * 50 + randomValue(seed, 0, 10);
+            double y = j * 50 + randomValue(seed, 0, 10);
+            Rectangle rect(Point(x, y), Point(x + randomValue(seed, 15, 30),
+                        y + randomValue(seed, 15, 30)));
+            shapes.push_back(new ShapeRef(router, rect));
+        }
+    }
+    for (int c = 0; c < connCount; ++c)
+    {
+        ShapeRef *src = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ShapeRef *tar = shapes[(int) randomValue(seed, 0, shapes.size())];
+        ConnRef *conn = new ConnRef(router,
+                ConnEnd(src->polygon().ps[0] + Point(-4, -4)),
+                ConnEnd(tar->polygon().ps[2] + Point(4, 4)));
+        conn->setRoutingType(ConnType_Orthogonal);
+    }
+    router->processTransaction();
+
+    // Gather the IDs of connector and shape vertices, and the positions
+    // of all shape vertices (including dummy orthogonal ones).  A linear
+    // search of the list for every one of these would take minutes, so
+    // only a sample of them are used.
+    std::vector<VertID> ids;
+    std::vector<Point> positions;
+    unsigned int count = 0;
+    for (VertInf *curr = router->vertices.connsBegin();
+            curr != router->vertices.end(); curr = curr->lstNext)
+    {
+        if ((count++ % sampleStride) != 0)
+        {
+            continue;
+        }
+        if (curr->id != dummyOrthogID)
+        {
+            ids.push_back(curr->id);
+        }
+        if (!curr->id.isConnPt())
+        {
+            positions.push_back(curr->point);
+        }
+    }
+    const unsigned int lookups = ids.size() + positions.size();
+    printf("%u conn and %u shape vertices in router.\n",
+            router->vertices.connsSize(), router->vertices.shapesSize());
+
+    int mismatches = 0;
+    std::vector<VertInf *> linearResults;
+    clock_t start = clock();
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        linearResults.push_back(linearFindByID(router, ids[i]));
+    }
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        linearResults.push_back(linearFindByPos(router, positions[i]));
+    }
+    printf("Linear search:  %.3fs for %u lookups.\n", elapsed(start),
+            lookups);
+
+    std::vector<VertInf *> indexedResults;
+    start = clock();
+    for (int r = 0; r < lookupRepeats; ++r)
+    {
+        indexedResults.clear();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            indexedResults.push_back(router->vertices.getVertexByID(ids[i]));
+        }
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            indexedResults.push_back(
+                    router->vertices.getVertexByPos(positions[i]));
+        }
+    }
+    printf("Indexed lookup: %.3fs for %u lookups.\n", elapsed(start),
+            lookupRepeats * lookups);
+
+    if (indexedResults != linearResults)
+    {
+        ++mismatches;
+    }
+    if (router->vertices.getVertexByPos(Point(-1000, -1000)) != NULL)
+    {
+        ++mismatches;
+    }
+
+    // Move some shapes and check lookups still find the moved vertices.
+    for (size_t s = 0; s < shapes.size(); s += 9)
+    {
+        router->moveShape(shapes[s], randomValue(seed, -5, 5),
+                randomValue(seed, -5, 5));
+    }
+    router->processTransaction();
+    for (size_t s = 0; s < shapes.size(); s += 9)
+    {
+        const Polygon& poly = shapes[s]->polygon();
+        for (size_t i = 0; i < poly.size(); ++i)
+        {
+            if (router->vertices.getVertexByPos(poly.ps[i]) !=
+                    linearFindByPos(router, poly.ps[i]))
+            {
+                ++mismatches;
+            }
+        }
+    }
+
+    delete router;
+    if (mismatches > 0)
+    {
+        printf("%d lookups differ from a linear search.\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
+
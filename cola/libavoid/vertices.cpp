@@ -33,6 +33,7 @@
 #include "libavoid/router.h"
 #include "libavoid/assertions.h"
 #include "libavoid/connend.h"
+#include "libavoid/pool.h"
 
 using std::ostream;
 
@@ -160,13 +161,16 @@ VertInf::VertInf(Router *router, const VertID& vid, const Point& vpoint,
       point(vpoint),
       lstPrev(NULL),
       lstNext(NULL),
+      lstOrder(0),
       shPrev(NULL),
       shNext(NULL),
       visListSize(0),
       orthogVisListSize(0),
+      orthogVisListStamp(0),
       invisListSize(0),
       pathNext(NULL),
       visDirections(ConnDirNone),
+      searchIndex(router->vertices.allocateSearchIndex()),
       orthogVisPropFlags(0)
 {
     point.id = vid.objID;
@@ -182,6 +186,31 @@ VertInf::VertInf(Router *router, const VertID& vid, const Point& vpoint,
 VertInf::~VertInf()
 {
     COLA_ASSERT(orphaned());
+    _router->vertices.freeSearchIndex(searchIndex);
+}
+
+
+void *VertInf::operator new(size_t size, MemoryPool& pool)
+{
+    return allocatePooledObject(size, &pool);
+}
+
+
+void *VertInf::operator new(size_t size)
+{
+    return allocatePooledObject(size, NULL);
+}
+
+
+void VertInf::operator delete(void *ptr, MemoryPool&)
+{
+    freePooledObject(ptr);
+}
+
+
+void VertInf::operator delete(void *ptr)
+{
+    freePooledObject(ptr);
 }
 
 
@@ -202,18 +231,25 @@ bool VertInf::hasNeighbour(VertInf *target, bool orthogonal) const
 
 void VertInf::Reset(const VertID& vid, const Point& vpoint)
 {
+    const bool listed = (lstOrder != 0);
+    if (listed)
+    {
+        _router->vertices.removeFromIndexes(this);
+    }
     id = vid;
     point = vpoint;
     point.id = id.objID;
     point.vn = id.vn;
+    if (listed)
+    {
+        _router->vertices.addToIndexes(this);
+    }
 }
 
 
 void VertInf::Reset(const Point& vpoint)
 {
-    point = vpoint;
-    point.id = id.objID;
-    point.vn = id.vn;
+    Reset(id, vpoint);
 }
 
 
@@ -326,8 +362,36 @@ VertInfList::VertInfList()
       _lastShapeVert(NULL),
       _lastConnVert(NULL),
       _shapeVertices(0),
-      _connVertices(0)
+      _connVertices(0),
+      _connOrder(0),
+      _shapeOrder(0),
+      _searchIndexLimit(0)
+{
+}
+
+
+unsigned int VertInfList::allocateSearchIndex(void)
+{
+    if (_freeSearchIndexes.empty())
+    {
+        return _searchIndexLimit++;
+    }
+    unsigned int index = _freeSearchIndexes.back();
+    _freeSearchIndexes.pop_back();
+    return index;
+}
+
+
+void VertInfList::freeSearchIndex(const unsigned int index)
+{
+    COLA_ASSERT(index < _searchIndexLimit);
+    _freeSearchIndexes.push_back(index);
+}
+
+
+unsigned int VertInfList::searchIndexLimit(void) const
 {
+    return _searchIndexLimit;
 }
 
 
@@ -378,6 +442,7 @@ void VertInfList::addVertex(VertInf *vert)
             vert->lstNext = _firstShapeVert;
         }
         _connVertices++;
+        vert->lstOrder = --_connOrder;
     }
     else // if (vert->id.shape > 0)
     {
@@ -406,7 +471,9 @@ void VertInfList::addVertex(VertInf *vert)
             }
         }
         _shapeVertices++;
+        vert->lstOrder = ++_shapeOrder;
     }
+    addToIndexes(vert);
     checkVertInfListConditions();
 }
 
@@ -422,6 +489,8 @@ VertInf *VertInfList::removeVertex(VertInf *vert)
     // Conditions for correct data structure
     checkVertInfListConditions();
     
+    removeFromIndexes(vert);
+
     VertInf *following = vert->lstNext;
 
     if (vert->id.isConnPt())
@@ -509,6 +578,7 @@ VertInf *VertInfList::removeVertex(VertInf *vert)
     }
     vert->lstPrev = NULL;
     vert->lstNext = NULL;
+    vert->lstOrder = 0;
 
     checkVertInfListConditions();
 
@@ -516,6 +586,70 @@ VertInf *VertInfList::removeVertex(VertInf *vert)
 }
 
 
+// Adds the vertex to the lookup indexes.  Connector and shape vertices
+// are indexed by ID, and shape vertices (including dummy orthogonal ones)
+// by position, matching what the lookups below search.
+void VertInfList::addToIndexes(VertInf *vert)
+{
+    COLA_ASSERT(vert->lstOrder != 0);
+
+    if (vert->id != dummyOrthogID)
+    {
+        _idIndex.insert(std::make_pair(vert->id, vert));
+    }
+    if (!vert->id.isConnPt())
+    {
+        _posIndex.insert(std::make_pair(vert->point, vert));
+    }
+}
+
+
+void VertInfList::removeFromIndexes(VertInf *vert)
+{
+    if (vert->id != dummyOrthogID)
+    {
+        std::pair<VertIDIndex::iterator, VertIDIndex::iterator> range =
+                _idIndex.equal_range(vert->id);
+        VertIDIndex::iterator it = range.first;
+        while ((it != range.second) && (it->second != vert))
+        {
+            ++it;
+        }
+        COLA_ASSERT(it != range.second);
+        _idIndex.erase(it);
+    }
+    if (!vert->id.isConnPt())
+    {
+        std::pair<VertPosIndex::iterator, VertPosIndex::iterator> range =
+                _posIndex.equal_range(vert->point);
+        VertPosIndex::iterator it = range.first;
+        while ((it != range.second) && (it->second != vert))
+        {
+            ++it;
+        }
+        COLA_ASSERT(it != range.second);
+        _posIndex.erase(it);
+    }
+}
+
+
+// Of several indexed vertices with the same key, returns the one that 
+// comes first in the list, as a linear search of the list would.
+template <typename Iterator>
+static VertInf *firstInListOrder(const std::pair<Iterator, Iterator>& range)
+{
+    VertInf *first = NULL;
+    for (Iterator it = range.first; it != range.second; ++it)
+    {
+        if (!first || (it->second->lstOrder < first->lstOrder))
+        {
+            first = it->second;
+        }
+    }
+    return first;
+}
+
+
 VertInf *VertInfList::getVertexByID(const VertID& id)
 {
     VertID searchID = id;
@@ -532,6 +666,12 @@ VertInf *VertInfList::getVertexByID(const VertID& id)
             searchID.vn = VertID::tar;
         }
     }
+    if (searchID != dummyOrthogID)
+    {
+        return firstInListOrder(_idIndex.equal_range(searchID));
+    }
+
+    // Dummy vertices aren't in the ID index.
     VertInf *last = end();
     for (VertInf *curr = connsBegin(); curr != last; curr = curr->lstNext)
     {
@@ -546,15 +686,19 @@ VertInf *VertInfList::getVertexByID(const VertID& id)
 
 VertInf *VertInfList::getVertexByPos(const Point& p)
 {
-    VertInf *last = end();
-    for (VertInf *curr = shapesBegin(); curr != last; curr = curr->lstNext)
+    return firstInListOrder(_posIndex.equal_range(p));
+}
+
+
+void VertInfList::getVerticesByPos(const Point& p, 
+        std::vector<VertInf *>& verts)
+{
+    std::pair<VertPosIndex::iterator, VertPosIndex::iterator> range =
+            _posIndex.equal_range(p);
+    for (VertPosIndex::iterator it = range.first; it != range.second; ++it)
     {
-        if (curr->point == p)
-        {
-            return curr;
-        }
+        verts.push_back(it->second);
     }
-    return NULL;
 }
 
 
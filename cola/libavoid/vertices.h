@@ -27,6 +27,7 @@
 #define AVOID_VERTICES_H
 
 #include <list>
+#include <vector>
 #include <set>
 #include <map>
 #include <iostream>
@@ -38,6 +39,7 @@ namespace Avoid {
 
 class EdgeInf;
 class Router;
+class MemoryPool;
 
 typedef std::list<EdgeInf *> EdgeInfList;
 
@@ -114,6 +116,12 @@ class VertInf
         VertInf(Router *router, const VertID& vid, const Point& vpoint,
                 const bool addToRouter = true);
         ~VertInf();
+        // VertInfs may be allocated from one of the router's pools, with
+        // new (pool) VertInf(...).  They are deleted as usual.
+        static void *operator new(size_t size, MemoryPool& pool);
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, MemoryPool& pool);
+        static void operator delete(void *ptr);
         void Reset(const VertID& vid, const Point& vpoint);
         void Reset(const Point& vpoint);
         void removeFromGraph(const bool isConnVert = true);
@@ -129,12 +137,19 @@ class VertInf
         Point  point;
         VertInf *lstPrev;
         VertInf *lstNext;
+        // Position of the vertex in the router's VertInfList, used to
+        // keep lookups through the list's indexes in list order.  Zero
+        // if the vertex is not in the list.
+        long lstOrder;
         VertInf *shPrev;
         VertInf *shNext;
         EdgeInfList visList;
         unsigned int visListSize;
         EdgeInfList orthogVisList;
         unsigned int orthogVisListSize;
+        // Changed whenever the orthogVisList changes, so the router's
+        // OrthogVisGraphSnapshot can tell if it is out of date.
+        unsigned long orthogVisListStamp;
         EdgeInfList invisList;
         unsigned int invisListSize;
         VertInf *pathNext;
@@ -144,7 +159,9 @@ class VertInf
         double sptfDist;
 
         ConnDirFlags visDirections;
-        std::list<unsigned int> aStarDoneIndexes;
+        // A small number, unique among the router's current vertices, 
+        // used to index per-vertex arrays during path searches.
+        unsigned int searchIndex;
         // Flags for orthogonal visibility properties, i.e., whether the 
         // line points to a shape edge, connection point or an obstacle.
         unsigned int orthogVisPropFlags;
@@ -178,18 +195,43 @@ class VertInfList
         VertInf *removeVertex(VertInf *vert);
         VertInf *getVertexByID(const VertID& id);
         VertInf *getVertexByPos(const Point& p);
+        // Adds every vertex getVertexByPos() could find at p to verts.
+        void getVerticesByPos(const Point& p, std::vector<VertInf *>& verts);
         VertInf *shapesBegin(void);
         VertInf *connsBegin(void);
         VertInf *end(void);
         unsigned int connsSize(void) const;
         unsigned int shapesSize(void) const;
+        // Search indexes are given to every vertex, whether or not it is
+        // in the list, and reused once the vertex is deleted.  All are 
+        // less than searchIndexLimit().
+        unsigned int allocateSearchIndex(void);
+        void freeSearchIndex(const unsigned int index);
+        unsigned int searchIndexLimit(void) const;
     private:
+        friend class VertInf;
+        typedef std::multimap<VertID, VertInf *> VertIDIndex;
+        typedef std::multimap<Point, VertInf *> VertPosIndex;
+
+        void addToIndexes(VertInf *vert);
+        void removeFromIndexes(VertInf *vert);
         VertInf *_firstShapeVert;
         VertInf *_firstConnVert;
         VertInf *_lastShapeVert;
         VertInf *_lastConnVert;
         unsigned int _shapeVertices;
         unsigned int _connVertices;
+        // Orders given to the last conn and shape vertices added.  Conn
+        // vertices are added to the front of the list, so count down.
+        long _connOrder;
+        long _shapeOrder;
+        // Lookup indexes for getVertexByID() and getVertexByPos().  
+        // Dummy orthogonal vertices all share one ID, so are only found
+        // by position.
+        VertIDIndex _idIndex;
+        VertPosIndex _posIndex;
+        std::vector<unsigned int> _freeSearchIndexes;
+        unsigned int _searchIndexLimit;
 };
 
 
@@ -40,6 +40,7 @@
 #include <map>
 #include <cfloat>
 #include <cstdio>
+#include <algorithm>
 
 #include "libavoid/vpsc.h"
 #include "libavoid/assertions.h"
@@ -53,11 +54,14 @@ namespace Avoid {
 static const double ZERO_UPPERBOUND=-1e-10;
 static const double LAGRANGIAN_TOLERANCE=-1e-4;
 
-IncSolver::IncSolver(vector<Variable*> const &vs, vector<Constraint *> const &cs) 
+IncSolver::IncSolver(vector<Variable*> const &vs, vector<Constraint *> const &cs,
+        const bool violationHeap) 
     : m(cs.size()), 
       cs(cs), 
       n(vs.size()), 
-      vs(vs) 
+      vs(vs),
+      useViolationHeap(violationHeap),
+      maxViolationHeapSize(0)
 {
     for(unsigned i=0;i<n;++i) {
         vs[i]->in.clear();
@@ -254,6 +258,9 @@ bool IncSolver::satisfy() {
     f<<"satisfy_inc()..."<<endl;
 #endif
     splitBlocks();
+    if(useViolationHeap) {
+        rebuildViolationHeap();
+    }
     //long splitCtr = 0;
     Constraint* v = NULL;
     //CBuffer buffer(inactive);
@@ -263,7 +270,10 @@ bool IncSolver::satisfy() {
         COLA_ASSERT(!v->active);
         Block *lb = v->left->block, *rb = v->right->block;
         if(lb != rb) {
-            lb->merge(rb,v);
+            Block *mb = lb->merge(rb,v);
+            if(useViolationHeap) {
+                queueBlockConstraints(mb==lb?rb:lb);
+            }
         } else {
             if(lb->isActiveDirectedPathBetween(v->right,v->left)) {
                 // cycle found, relax the violated, cyclic constraint
@@ -305,11 +315,24 @@ bool IncSolver::satisfy() {
                 inactive.push_back(v);
                 bs->insert(lb);
                 bs->insert(rb);
+                if(useViolationHeap) {
+                    queueBlockConstraints(
+                            lb->vars->size()<rb->vars->size()?lb:rb);
+                }
             } else {
-                bs->insert(lb->merge(rb,v));
+                Block *mb = lb->merge(rb,v);
+                bs->insert(mb);
+                if(useViolationHeap) {
+                    queueBlockConstraints(mb==lb?rb:lb);
+                }
             }
         }
-        bs->cleanup();
+        if(!useViolationHeap) {
+            // With the heap, the work for each merge is proportional to the
+            // size of the blocks involved rather than the number of blocks,
+            // so deleted blocks are swept up once below, not after each one.
+            bs->cleanup();
+        }
 #ifdef LIBVPSC_LOGGING
         f<<"...remaining blocks="<<bs->size()<<", cost="<<bs->cost()<<endl;
 #endif
@@ -317,6 +340,11 @@ bool IncSolver::satisfy() {
 #ifdef LIBVPSC_LOGGING
     f<<"  finished merges."<<endl;
 #endif
+    if(useViolationHeap) {
+        // the heap stands in for the inactive list, which is not needed
+        violationHeap.clear();
+        inactive.clear();
+    }
     bs->cleanup();
     bool activeConstraints=false;
     for(unsigned i=0;i<m;i++) {
@@ -400,6 +428,9 @@ void IncSolver::splitBlocks() {
  * constraint
  */
 Constraint* IncSolver::mostViolated(Constraints &l) {
+    if(useViolationHeap) {
+        return mostViolatedFromHeap();
+    }
     double minSlack = DBL_MAX;
     Constraint* v=NULL;
 #ifdef LIBVPSC_LOGGING
@@ -434,6 +465,94 @@ Constraint* IncSolver::mostViolated(Constraints &l) {
     return v;
 }
 
+static bool greaterSlack(pair<double,Constraint*> const &a,
+        pair<double,Constraint*> const &b) {
+    return a.first > b.first;
+}
+/**
+ * Fills the heap with an entry for every constraint that is neither active
+ * nor unsatisfiable, keyed by its current slack.  Equality constraints
+ * always come first.
+ * @return true if any of them are violated or equalities
+ */
+bool IncSolver::rebuildViolationHeap() {
+    violationHeap.clear();
+    bool violated=false;
+    for(unsigned i=0;i<m;i++) {
+        Constraint *c=cs[i];
+        if(!c->active && !c->unsatisfiable) {
+            double key=c->equality ? -DBL_MAX : c->slack();
+            violated = violated || key < ZERO_UPPERBOUND;
+            violationHeap.push_back(make_pair(key,c));
+        }
+    }
+    make_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+    maxViolationHeapSize=max(2*violationHeap.size(),(size_t)4*m);
+    return violated;
+}
+void IncSolver::queueViolation(Constraint *c) {
+    if(violationHeap.size()>=maxViolationHeapSize) {
+        // mostly entries for constraints that have since moved
+        rebuildViolationHeap();
+    }
+    violationHeap.push_back(
+            make_pair(c->equality ? -DBL_MAX : c->slack(), c));
+    push_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+}
+/**
+ * When two blocks are merged only the variables of the smaller one change
+ * position relative to the rest of the new block, and the constraints on
+ * them are the ones likely to have become violated.  So these are queued 
+ * again, with b the smaller block, while the constraints of the larger 
+ * block, which all moved by the same amount, are left to be refreshed 
+ * when they come to the top of the heap.  Likewise, after a split, b is
+ * the smaller of the two new blocks.
+ */
+void IncSolver::queueBlockConstraints(Block *b) {
+    for(vector<Variable*>::iterator i=b->vars->begin();i!=b->vars->end();++i) {
+        Variable *v=*i;
+        for(Constraints::iterator j=v->out.begin();j!=v->out.end();++j) {
+            if(!(*j)->active && !(*j)->unsatisfiable) {
+                queueViolation(*j);
+            }
+        }
+        for(Constraints::iterator j=v->in.begin();j!=v->in.end();++j) {
+            if(!(*j)->active && !(*j)->unsatisfiable) {
+                queueViolation(*j);
+            }
+        }
+    }
+}
+/**
+ * As mostViolated, but takes the constraint from the top of the heap.
+ * Entries whose slack has changed since they were queued are queued again
+ * with the new slack.  Since these may be anywhere in the heap, all of the
+ * constraints are checked again before reporting that none are violated.
+ */
+Constraint* IncSolver::mostViolatedFromHeap() {
+    do {
+        while(!violationHeap.empty()) {
+            Constraint *c=violationHeap.front().second;
+            const double key=violationHeap.front().first;
+            const bool stale=!c->active && !c->unsatisfiable &&
+                !c->equality && key != c->slack();
+            if(!c->active && !c->unsatisfiable && !stale && 
+                    !c->equality && key >= ZERO_UPPERBOUND) {
+                // the least slack of all is fine
+                break;
+            }
+            pop_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+            violationHeap.pop_back();
+            if(stale) {
+                queueViolation(c);
+            } else if(!c->active && !c->unsatisfiable) {
+                return c;
+            }
+        }
+    } while(rebuildViolationHeap());
+    return NULL;
+}
+
 
 using std::set;
 using std::vector;
@@ -445,6 +564,7 @@ using std::copy;
 
 Blocks::Blocks(vector<Variable*> const &vs) : vs(vs),nvs(vs.size()) {
     blockTimeCtr=0;
+    mergeCtr=0;
     for(int i=0;i<nvs;i++) {
         insert(new Block(this, vs[i]));
     }
@@ -758,6 +878,7 @@ void Block::merge(Block *b, Constraint *c, double dist) {
     posn=(ps.AD - ps.AB) / ps.A2;
     COLA_ASSERT(__NOTNAN(posn));
     b->deleted=true;
+    blocks->mergeCtr++;
 }
 
 void Block::mergeIn(Block *b) {
@@ -41,11 +41,13 @@
 #include <list>
 #include <set>
 #include <queue>
+#include <utility>
 
 namespace Avoid {
 
 class Variable;
 class Constraint;
+class Block;
 class Blocks;
 typedef std::vector<Variable*> Variables;
 typedef std::vector<Constraint*> Constraints;
@@ -203,6 +205,8 @@ public:
     double cost();
     
     long blockTimeCtr;
+    // The number of times one block has been merged into another.
+    long mergeCtr;
 private:
     void dfsVisit(Variable *v, std::list<Variable*> *order);
     void removeBlock(Block *doomed);
@@ -229,10 +233,16 @@ public:
     bool solve();
     void moveBlocks();
     void splitBlocks();
-    IncSolver(Variables const &vs, Constraints const &cs);
+    // If violationHeap is set, satisfy() finds the most violated 
+    // constraint with a heap of inactive constraints keyed by slack, 
+    // rather than scanning all of them each time round.  This is much
+    // faster when there are many constraints.
+    IncSolver(Variables const &vs, Constraints const &cs,
+            const bool violationHeap = false);
 
     ~IncSolver();
     Variables const & getVariables() { return vs; }
+    long blocksMerged() const { return bs->mergeCtr; }
 protected:
     Blocks *bs;
     unsigned m;
@@ -247,6 +257,16 @@ private:
     Constraints inactive;
     Constraints violated;
     Constraint* mostViolated(Constraints &l);
+    // Heap of (slack, constraint) entries for inactive constraints.  
+    // Entries are not updated in place when blocks move, see 
+    // queueBlockConstraints and mostViolatedFromHeap.
+    const bool useViolationHeap;
+    std::vector<std::pair<double,Constraint*> > violationHeap;
+    size_t maxViolationHeapSize;
+    bool rebuildViolationHeap();
+    void queueViolation(Constraint *c);
+    void queueBlockConstraints(Block *b);
+    Constraint* mostViolatedFromHeap();
 };
 
 struct delete_object
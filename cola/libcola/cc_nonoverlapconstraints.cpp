@@ -25,6 +25,8 @@
  *
 */
 
+#include <algorithm>
+
 #include "cola.h"
 #include "compound_constraints.h"
 #include "cc_nonoverlapconstraints.h"
@@ -47,7 +49,8 @@ class OverlapShapeOffsets : public SubConstraintInfo
             : SubConstraintInfo(ind),
               cluster(NULL),
               rectPadding(0),
-              group(group)
+              group(group),
+              version(0)
         {
             halfDim[0] = xOffset;
             halfDim[1] = yOffset;
@@ -56,7 +59,8 @@ class OverlapShapeOffsets : public SubConstraintInfo
             : SubConstraintInfo(ind),
               cluster(cluster),
               rectPadding(cluster->rectBuffer),
-              group(group)
+              group(group),
+              version(0)
         {
             halfDim[0] = 0;
             halfDim[1] = 0;
@@ -64,7 +68,8 @@ class OverlapShapeOffsets : public SubConstraintInfo
         OverlapShapeOffsets()
             : SubConstraintInfo(1000000),
               cluster(NULL),
-              rectPadding(0)
+              rectPadding(0),
+              version(0)
         {
         }
         bool usesClusterBounds(void) const
@@ -75,55 +80,134 @@ class OverlapShapeOffsets : public SubConstraintInfo
         double halfDim[2];   // Half width and height values.
         double rectPadding;  // Used for cluster padding.
         unsigned int group;
+        // Bounds at the last computeAndSortOverlap() call.
+        double left;
+        double right;
+        double bottom;
+        double top;
+        // Incremented whenever the bounds change.
+        unsigned version;
+        bool moved;
 };
 
 
 class ShapePairInfo 
 {
     public:
-        ShapePairInfo(unsigned ind1, unsigned ind2, unsigned ord = 1) 
-            : order(ord),
-              satisfied(false),
-              processed(false)
+        ShapePairInfo(OverlapShapeOffsets *s1, OverlapShapeOffsets *s2,
+                double overlapMax)
+            : overlapMax(overlapMax)
         {
-            COLA_ASSERT(ind1 != ind2);
-            // Assign the lesser value to varIndex1.
-            varIndex1 = (ind1 < ind2) ? ind1 : ind2;
-            // Assign the greater value to varIndex2.
-            varIndex2 = (ind1 > ind2) ? ind1 : ind2;
+            COLA_ASSERT(s1->varIndex != s2->varIndex);
+            // Assign the shape with the lesser index to shape1.
+            if (s1->varIndex > s2->varIndex)
+            {
+                std::swap(s1, s2);
+            }
+            shape1 = s1;
+            shape2 = s2;
+            version1 = s1->version;
+            version2 = s2->version;
         }
+        // Whether either shape has moved since the overlap was computed.
+        bool isStale(void) const
+        {
+            return (version1 != shape1->version) || 
+                    (version2 != shape2->version);
+        }
+        std::pair<unsigned, unsigned> key(void) const
+        {
+            return std::make_pair(shape1->varIndex, shape2->varIndex);
+        }
+        // Orders pairs for the priority queue, so pairs with the largest
+        // overlap come first.  Equal overlaps are ordered as the pairs were
+        // created by addShape().
         bool operator<(const ShapePairInfo& rhs) const
         {
-            // Make sure the processed ones are at the end after sorting.
-            int processedInt = processed ? 1 : 0;
-            int rhsProcessedInt = rhs.processed ? 1 : 0;
-            if (processedInt != rhsProcessedInt)
+            if (overlapMax != rhs.overlapMax)
             {
-                return processedInt < rhsProcessedInt;
+                return overlapMax < rhs.overlapMax;
             }
-            // Use cluster ordering for primary sorting.
-            if (order != rhs.order)
+            if (shape2->varIndex != rhs.shape2->varIndex)
             {
-                return order < rhs.order;
+                return shape2->varIndex > rhs.shape2->varIndex;
             }
-            return overlapMax > rhs.overlapMax;
+            return shape1->varIndex > rhs.shape1->varIndex;
         }
-        unsigned order;
-        unsigned varIndex1;
-        unsigned varIndex2;
-        bool satisfied;
-        bool processed;
-        double costL;
-        double costR;
-        double costB;
-        double costA;
-        double overlapMin;
+        OverlapShapeOffsets *shape1;
+        OverlapShapeOffsets *shape2;
+        unsigned version1;
+        unsigned version2;
         double overlapMax;
 };
 
 
+static vpsc::Rectangle *shapeRect(const OverlapShapeOffsets& shape,
+        std::vector<vpsc::Rectangle*>& boundingBoxes)
+{
+    return (shape.cluster) ? &(shape.cluster->bounds) :
+            boundingBoxes[shape.varIndex];
+}
+
+
+static bool isStalePair(const ShapePairInfo& info)
+{
+    return info.isStale();
+}
+
+
+static bool cmpShapeLeft(const OverlapShapeOffsets *lhs, 
+        const OverlapShapeOffsets *rhs)
+{
+    return lhs->left < rhs->left;
+}
+
+
+// Returns how badly two shapes whose bounds overlap in both dimensions
+// overlap, with shapes fully inside another treated as worst.
+static double overlapCost(const OverlapShapeOffsets& shape1,
+        const OverlapShapeOffsets& shape2)
+{
+    double overlapMax = std::max(shape1.right - shape2.left,
+            shape2.right - shape1.left);
+    overlapMax = std::max(overlapMax, shape2.top - shape1.bottom);
+    overlapMax = std::max(overlapMax, shape1.top - shape2.bottom);
+
+    // Increase the overlap value for overlap where one shape is fully
+    // within the other.  This result in these situations being
+    // resolved first and will sometimes prevent us from committing to
+    // bad non-overlap choices and getting stuck later.
+    // XXX Another alternative would be to look at previously added
+    //     non-overlap constraints that become unsatified and then 
+    //     allow them to be rechosen maybe just a single time.
+    double penalty = 100000;
+    if ( (shape1.left >= shape2.left) && (shape1.right <= shape2.right) &&
+         (shape1.bottom >= shape2.bottom) && (shape1.top <= shape2.top) )
+    {
+        // Shape 1 is inside shape 2.
+        double smallShapeArea = (shape1.right - shape1.left) * 
+                (shape1.top - shape1.bottom);
+        overlapMax = penalty + smallShapeArea;
+    }
+    else if ( (shape2.left >= shape1.left) && 
+              (shape2.right <= shape1.right) &&
+              (shape2.bottom >= shape1.bottom) && 
+              (shape2.top <= shape1.top) )
+    {
+        // Shape 2 is inside shape 1.
+        double smallShapeArea = (shape2.right - shape2.left) * 
+                (shape2.top - shape2.bottom);
+        overlapMax = penalty + smallShapeArea;
+    }
+    return overlapMax;
+}
+
+
 NonOverlapConstraints::NonOverlapConstraints(unsigned int priority)
-    : CompoundConstraint(vpsc::HORIZONTAL, priority)
+    : CompoundConstraint(vpsc::HORIZONTAL, priority),
+      pairCount(0),
+      maxQueueSize(0),
+      boundsValid(false)
 {
     // All work is done by repeated addShape() calls.
 }
@@ -131,38 +215,24 @@ NonOverlapConstraints::NonOverlapConstraints(unsigned int priority)
 void NonOverlapConstraints::addShape(unsigned id, double halfW, double halfH,
         unsigned int group)
 {
-    // Setup pairInfos for all other shapes. 
-    for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
-            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
-    {
-        unsigned otherId = curr->first;
-        if ((shapeOffsets[otherId].group == group) && (id != otherId))
-        {
-            // Apply non-overlap only to objects in the same group (cluster).
-            pairInfoList.push_back(ShapePairInfo(otherId, id));
-        }
-    }
+    COLA_ASSERT(shapeOffsets.count(id) == 0);
 
+    // Non-overlap applies only to objects in the same group (cluster).
+    pairCount += groupSizes[group]++;
     shapeOffsets[id] = OverlapShapeOffsets(id, halfW, halfH, group);
+    boundsValid = false;
 }
 
 
 void NonOverlapConstraints::addCluster(Cluster *cluster, unsigned int group)
 {
     unsigned id = cluster->clusterVarId;
-    // Setup pairInfos for all other shapes. 
-    for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
-            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
-    {
-        unsigned otherId = curr->first;
-        if (shapeOffsets[otherId].group == group)
-        {
-            // Apply non-overlap only to objects in the same group (cluster).
-            pairInfoList.push_back(ShapePairInfo(otherId, id));
-        }
-    }
+    COLA_ASSERT(shapeOffsets.count(id) == 0);
     
+    // Non-overlap applies only to objects in the same group (cluster).
+    pairCount += groupSizes[group]++;
     shapeOffsets[id] = OverlapShapeOffsets(id, cluster, group);
+    boundsValid = false;
 }
 
 
@@ -174,143 +244,144 @@ void NonOverlapConstraints::generateVariables(const vpsc::Dim dim,
 }
 
 
-void NonOverlapConstraints::computeAndSortOverlap(vpsc::Variables vs[])
+void NonOverlapConstraints::updateShapeBounds(vpsc::Variables vs[])
 {
-    for (std::list<ShapePairInfo>::iterator curr = pairInfoList.begin();
-            curr != pairInfoList.end(); ++curr)
+    if (!boundsValid)
     {
-        ShapePairInfo& info = static_cast<ShapePairInfo&> (*curr);
-
-        OverlapShapeOffsets& shape1 = shapeOffsets[info.varIndex1];
-        OverlapShapeOffsets& shape2 = shapeOffsets[info.varIndex2];
+        sweepOrder.clear();
+    }
+    for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
+            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
+    {
+        OverlapShapeOffsets& shape = curr->second;
+        unsigned id = curr->first;
 
-        double xPos1 = vs[0][info.varIndex1]->finalPosition;
-        double xPos2 = vs[0][info.varIndex2]->finalPosition;
-        double yPos1 = vs[1][info.varIndex1]->finalPosition;
-        double yPos2 = vs[1][info.varIndex2]->finalPosition;
+        double xPos = vs[0][id]->finalPosition;
+        double yPos = vs[1][id]->finalPosition;
 
-        double left1   = xPos1 - shape1.halfDim[0];
-        double right1  = xPos1 + shape1.halfDim[0];
-        double bottom1 = yPos1 - shape1.halfDim[1];
-        double top1    = yPos1 + shape1.halfDim[1];
+        double left   = xPos - shape.halfDim[0];
+        double right  = xPos + shape.halfDim[0];
+        double bottom = yPos - shape.halfDim[1];
+        double top    = yPos + shape.halfDim[1];
 
-        if (shape1.cluster)
+        if (shape.cluster)
         {
-            COLA_ASSERT(shape1.halfDim[0] == 0);
-            COLA_ASSERT(shape1.halfDim[1] == 0);
-            COLA_ASSERT(info.varIndex1 + 1 < vs[0].size());
-            right1 = vs[0][info.varIndex1 + 1]->finalPosition;
-            COLA_ASSERT(info.varIndex1 + 1 < vs[1].size());
-            top1    = vs[1][info.varIndex1 + 1]->finalPosition;
-            left1 -= shape1.rectPadding;
-            bottom1 -= shape1.rectPadding;
-            right1 += shape1.rectPadding;
-            top1 += shape1.rectPadding;
+            COLA_ASSERT(shape.halfDim[0] == 0);
+            COLA_ASSERT(shape.halfDim[1] == 0);
+            COLA_ASSERT(id + 1 < vs[0].size());
+            right = vs[0][id + 1]->finalPosition;
+            COLA_ASSERT(id + 1 < vs[1].size());
+            top   = vs[1][id + 1]->finalPosition;
+            left -= shape.rectPadding;
+            bottom -= shape.rectPadding;
+            right += shape.rectPadding;
+            top += shape.rectPadding;
         }
 
-        double left2   = xPos2 - shape2.halfDim[0];
-        double right2  = xPos2 + shape2.halfDim[0];
-        double bottom2 = yPos2 - shape2.halfDim[1];
-        double top2    = yPos2 + shape2.halfDim[1];
-
-        if (shape2.cluster)
+        shape.moved = !boundsValid || (left != shape.left) || 
+                (right != shape.right) || (bottom != shape.bottom) || 
+                (top != shape.top);
+        if (shape.moved)
         {
-            COLA_ASSERT(shape2.halfDim[0] == 0);
-            COLA_ASSERT(shape2.halfDim[1] == 0);
-            COLA_ASSERT(info.varIndex2 + 1 < vs[0].size());
-            right2 = vs[0][info.varIndex2 + 1]->finalPosition;
-            COLA_ASSERT(info.varIndex2 + 1 < vs[1].size());
-            top2   = vs[1][info.varIndex2 + 1]->finalPosition;
-            left2 -= shape2.rectPadding;
-            bottom2 -= shape2.rectPadding;
-            right2 += shape2.rectPadding;
-            top2 += shape2.rectPadding;
+            shape.left = left;
+            shape.right = right;
+            shape.bottom = bottom;
+            shape.top = top;
+            ++shape.version;
         }
-
-        // If lr < 0, then left edge of shape1 is on the left 
-        // of right edge of shape2.
-        double spaceR = left2 - right1;
-        double spaceL = left1 - right2;
-        // Below
-        double spaceA = bottom2 - top1;
-        // Above
-        double spaceB = bottom1 - top2;
-
-        info.costL = info.costR = info.costB = info.costA = 0;
-        info.overlapMax = 0;
-        info.overlapMin = DBL_MAX;
-        bool xOverlap = false;
-        bool yOverlap = false;
-        if ((spaceR < 0) && (spaceL < 0))
+        if (!boundsValid)
         {
-            info.costL = std::max(-spaceL, 0.0);
-            info.costR = std::max(-spaceR, 0.0);
-
-            info.overlapMax = std::max(info.costL, info.costR);
-
-            info.overlapMin = std::min(info.overlapMin, info.costL);
-            info.overlapMin = std::min(info.overlapMin, info.costR);
-
-            xOverlap = true;
+            sweepOrder.push_back(&shape);
         }
-        if ((spaceB < 0) && (spaceA < 0))
-        {
-            info.costB = std::max(-spaceB, 0.0);
-            info.costA = std::max(-spaceA, 0.0);
-
-            info.overlapMax = std::max(info.overlapMax, info.costB);
-            info.overlapMax = std::max(info.overlapMax, info.costA);
+    }
+    boundsValid = true;
+}
 
-            info.overlapMin = std::min(info.overlapMin, info.costB);
-            info.overlapMin = std::min(info.overlapMin, info.costA);
 
-            yOverlap = true;
-        }
+void NonOverlapConstraints::queueOverlappingPairs(void)
+{
+    // Sweep across the shapes from left to right, keeping a list of those
+    // whose horizontal extent contains the current sweep position.  Only
+    // these can overlap the next shape.  Shapes mostly move only a little
+    // between calls so the order is usually already close to sorted.
+    std::sort(sweepOrder.begin(), sweepOrder.end(), cmpShapeLeft);
+
+    std::vector<OverlapShapeOffsets *> active;
+    for (size_t i = 0; i < sweepOrder.size(); ++i)
+    {
+        OverlapShapeOffsets *shape = sweepOrder[i];
 
-        if (!xOverlap || !yOverlap)
-        {
-            // Overlap must occur in both dimensions.
-            info.overlapMax = 0;
-        }
-        else
+        size_t stillActive = 0;
+        for (size_t j = 0; j < active.size(); ++j)
         {
-            // Increase the overlap value for overlap where one shape is fully
-            // within the other.  This result in these situations being
-            // resolved first and will sometimes prevent us from committing to
-            // bad non-overlap choices and getting stuck later.
-            // XXX Another alternative would be to look at previously added
-            //     non-overlap constraints that become unsatified and then 
-            //     allow them to be rechosen maybe just a single time.
-            double penalty = 100000;
-            if ( (left1 >= left2) && (right1 <= right2) &&
-                 (bottom1 >= bottom2) && (top1 <= top2) )
+            OverlapShapeOffsets *other = active[j];
+            if (other->right <= shape->left)
             {
-                // Shape 1 is inside shape 2.
-                double smallShapeArea = (right1 - left1) * (top1 - bottom1);
-                info.overlapMax = penalty + smallShapeArea;
+                // Other is entirely to the left of this and later shapes.
+                continue;
             }
-            else if ( (left2 >= left1) && (right2 <= right1) &&
-                 (bottom2 >= bottom1) && (top2 <= top1) )
+            active[stillActive++] = other;
+
+            // Overlap must occur in both dimensions.  Pairs where neither
+            // shape has moved are already queued, if they overlap.
+            if ((other->group != shape->group) || 
+                    (!other->moved && !shape->moved) ||
+                    (other->left >= shape->right) ||
+                    (other->bottom >= shape->top) ||
+                    (shape->bottom >= other->top))
             {
-                // Shape 2 is inside shape 1.
-                double smallShapeArea = (right2 - left2) * (top2 - bottom2);
-                info.overlapMax = penalty + smallShapeArea;
+                continue;
+            }
+
+            ShapePairInfo info(other, shape, overlapCost(*other, *shape));
+            if (processedPairs.count(info.key()) == 0)
+            {
+                overlapQueue.push_back(info);
+                std::push_heap(overlapQueue.begin(), overlapQueue.end());
             }
-            // There is overlap.
-            //printf("[%02d][%02d] L %g, R %G, B %g, A %g\n", info.varIndex1, 
-            //        info.varIndex2, spaceL, spaceR, spaceB, spaceA);
         }
+        active.resize(stillActive);
+        active.push_back(shape);
+    }
+
+    if (overlapQueue.size() > maxQueueSize)
+    {
+        // Solving usually moves many shapes, so most entries quickly go 
+        // stale.  Drop them all at once rather than let the heap grow.
+        overlapQueue.erase(std::remove_if(overlapQueue.begin(), 
+                    overlapQueue.end(), isStalePair), overlapQueue.end());
+        std::make_heap(overlapQueue.begin(), overlapQueue.end());
+        maxQueueSize = std::max(2 * overlapQueue.size(), 
+                4 * shapeOffsets.size());
+    }
+}
+
+
+void NonOverlapConstraints::computeAndSortOverlap(vpsc::Variables vs[])
+{
+    updateShapeBounds(vs);
+    queueOverlappingPairs();
+
+    // Discard pairs whose overlap was computed before either shape moved.
+    while (!overlapQueue.empty() && overlapQueue.front().isStale())
+    {
+        std::pop_heap(overlapQueue.begin(), overlapQueue.end());
+        overlapQueue.pop_back();
     }
-    pairInfoList.sort();
 }
 
 
 void NonOverlapConstraints::markCurrSubConstraintAsActive(const bool satisfiable)
 {
-    ShapePairInfo& info = pairInfoList.front();
-    
-    info.processed = true;
-    info.satisfied = satisfiable;
+    COLA_UNUSED(satisfiable);
+
+    // The queue is empty if there was no overlap left to resolve.
+    if (!overlapQueue.empty())
+    {
+        processedPairs.insert(overlapQueue.front().key());
+        std::pop_heap(overlapQueue.begin(), overlapQueue.end());
+        overlapQueue.pop_back();
+    }
 
     _currSubConstraintIndex++;
 }
@@ -323,29 +394,30 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
     SubConstraintAlternatives alternatives;
     computeAndSortOverlap(vs);
 
-    ShapePairInfo& info = pairInfoList.front();
-
-    if (info.overlapMax == 0)
+    if (overlapQueue.empty())
     {
         //fprintf(stderr, "===== EMPTY ALTERNATIVES -======\n");
         // There is no overlap here.
         // Mark as finished at this point.
-        _currSubConstraintIndex = pairInfoList.size();
+        _currSubConstraintIndex = pairCount;
         return alternatives;
     }
-    OverlapShapeOffsets& shape1 = shapeOffsets[info.varIndex1];
-    OverlapShapeOffsets& shape2 = shapeOffsets[info.varIndex2];
+    const ShapePairInfo& info = overlapQueue.front();
+    OverlapShapeOffsets& shape1 = *info.shape1;
+    OverlapShapeOffsets& shape2 = *info.shape2;
+    unsigned varIndex1 = shape1.varIndex;
+    unsigned varIndex2 = shape2.varIndex;
 
     double xSep = shape1.halfDim[0] + shape2.halfDim[0];
     double ySep = shape1.halfDim[1] + shape2.halfDim[1];
 
-    unsigned varIndexL1 = info.varIndex1;
-    unsigned varIndexL2 = info.varIndex2;
+    unsigned varIndexL1 = varIndex1;
+    unsigned varIndexL2 = varIndex2;
     // Clusters have left and right variables, instead of centre variables.
     unsigned varIndexR1 = 
-            (shape1.cluster) ? (info.varIndex1 + 1) : info.varIndex1;
+            (shape1.cluster) ? (varIndex1 + 1) : varIndex1;
     unsigned varIndexR2 = 
-            (shape2.cluster) ? (info.varIndex2 + 1) : info.varIndex2;
+            (shape2.cluster) ? (varIndex2 + 1) : varIndex2;
 
     assertValidVariableIndex(vs[XDIM], varIndexL1);
     assertValidVariableIndex(vs[YDIM], varIndexL1);
@@ -360,20 +432,20 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
     double xSepCost = xSep;
     double ySepCost = ySep;
 
-    double desiredX1 = vs[XDIM][info.varIndex1]->desiredPosition;
-    double desiredY1 = vs[YDIM][info.varIndex1]->desiredPosition;
-    double desiredX2 = vs[XDIM][info.varIndex2]->desiredPosition;
-    double desiredY2 = vs[YDIM][info.varIndex2]->desiredPosition;
+    double desiredX1 = vs[XDIM][varIndex1]->desiredPosition;
+    double desiredY1 = vs[YDIM][varIndex1]->desiredPosition;
+    double desiredX2 = vs[XDIM][varIndex2]->desiredPosition;
+    double desiredY2 = vs[YDIM][varIndex2]->desiredPosition;
     
     // Clusters have two variables instead of a centre variabale -- one for
     // each boundary side, so we need to remap the desired positions and the
     // separations values for the purposes of cost sorting.
     if (shape1.cluster)
     {
-        double width = vs[XDIM][info.varIndex1 + 1]->finalPosition -
-                vs[XDIM][info.varIndex1]->finalPosition;
-        double height = vs[YDIM][info.varIndex1 + 1]->finalPosition -
-                vs[YDIM][info.varIndex1]->finalPosition;
+        double width = vs[XDIM][varIndex1 + 1]->finalPosition -
+                vs[XDIM][varIndex1]->finalPosition;
+        double height = vs[YDIM][varIndex1 + 1]->finalPosition -
+                vs[YDIM][varIndex1]->finalPosition;
         desiredX1 += width / 2;
         desiredY1 += height / 2;
         xSepCost += width / 2;
@@ -383,10 +455,10 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
     }
     if (shape2.cluster)
     {
-        double width = vs[XDIM][info.varIndex2 + 1]->finalPosition -
-                vs[XDIM][info.varIndex2]->finalPosition;
-        double height = vs[YDIM][info.varIndex2 + 1]->finalPosition -
-                vs[YDIM][info.varIndex2]->finalPosition;
+        double width = vs[XDIM][varIndex2 + 1]->finalPosition -
+                vs[XDIM][varIndex2]->finalPosition;
+        double height = vs[YDIM][varIndex2 + 1]->finalPosition -
+                vs[YDIM][varIndex2]->finalPosition;
         desiredX2 += width / 2;
         desiredY2 += height / 2;
         xSepCost += width / 2;
@@ -433,20 +505,17 @@ NonOverlapConstraints::getCurrSubConstraintAlternatives(vpsc::Variables vs[])
 
 bool NonOverlapConstraints::subConstraintsRemaining(void) const
 {
-    //printf(". %3d of %4d\n", _currSubConstraintIndex, pairInfoList.size());
-    return _currSubConstraintIndex < pairInfoList.size();
+    //printf(". %3d of %4d\n", _currSubConstraintIndex, pairCount);
+    return _currSubConstraintIndex < pairCount;
 }
 
 
 void NonOverlapConstraints::markAllSubConstraintsAsInactive(void)
 {
-    for (std::list<ShapePairInfo>::iterator curr = pairInfoList.begin();
-            curr != pairInfoList.end(); ++curr)
-    {
-        ShapePairInfo& info = (*curr);
-        info.satisfied = false;
-        info.processed = false;
-    }
+    processedPairs.clear();
+    overlapQueue.clear();
+    maxQueueSize = 4 * shapeOffsets.size();
+    boundsValid = false;
     _currSubConstraintIndex = 0;
 }
 
@@ -455,19 +524,63 @@ void NonOverlapConstraints::generateSeparationConstraints(
         const vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& cs,
         std::vector<vpsc::Rectangle*>& boundingBoxes) 
 {
-    for (std::list<ShapePairInfo>::iterator info = pairInfoList.begin();
-            info != pairInfoList.end(); ++info)
+    // Only pairs of shapes that overlap in the other dimension are
+    // constrained, so find them by sweeping along that dimension.
+    const unsigned otherDim = !dim;
+    std::vector<std::pair<double, unsigned> > sweepOrder;
+    sweepOrder.reserve(shapeOffsets.size());
+    for (std::map<unsigned, OverlapShapeOffsets>::iterator curr =
+            shapeOffsets.begin(); curr != shapeOffsets.end(); ++curr)
+    {
+        vpsc::Rectangle *rect = shapeRect(curr->second, boundingBoxes);
+        sweepOrder.push_back(
+                std::make_pair(rect->getMinD(otherDim), curr->first));
+    }
+    std::sort(sweepOrder.begin(), sweepOrder.end());
+
+    // Pairs are stored as (greater index, lesser index), so that sorting
+    // them gives the order in which addShape() created them.
+    std::vector<std::pair<unsigned, unsigned> > overlappingPairs;
+    std::vector<unsigned> active;
+    for (size_t i = 0; i < sweepOrder.size(); ++i)
+    {
+        unsigned id = sweepOrder[i].second;
+        OverlapShapeOffsets& shape = shapeOffsets[id];
+
+        size_t stillActive = 0;
+        for (size_t j = 0; j < active.size(); ++j)
+        {
+            OverlapShapeOffsets& other = shapeOffsets[active[j]];
+            vpsc::Rectangle *otherRect = shapeRect(other, boundingBoxes);
+            if (otherRect->getMaxD(otherDim) <= sweepOrder[i].first)
+            {
+                continue;
+            }
+            active[stillActive++] = active[j];
+
+            if (other.group == shape.group)
+            {
+                overlappingPairs.push_back(std::make_pair(
+                            std::max(id, active[j]), std::min(id, active[j])));
+            }
+        }
+        active.resize(stillActive);
+        active.push_back(id);
+    }
+    std::sort(overlappingPairs.begin(), overlappingPairs.end());
+
+    for (size_t i = 0; i < overlappingPairs.size(); ++i)
     {
-        assertValidVariableIndex(vs, info->varIndex1);
-        assertValidVariableIndex(vs, info->varIndex2);
+        unsigned varIndex1 = overlappingPairs[i].second;
+        unsigned varIndex2 = overlappingPairs[i].first;
+        assertValidVariableIndex(vs, varIndex1);
+        assertValidVariableIndex(vs, varIndex2);
         
-        OverlapShapeOffsets& shape1 = shapeOffsets[info->varIndex1];
-        OverlapShapeOffsets& shape2 = shapeOffsets[info->varIndex2];
+        OverlapShapeOffsets& shape1 = shapeOffsets[varIndex1];
+        OverlapShapeOffsets& shape2 = shapeOffsets[varIndex2];
         
-        vpsc::Rectangle& rect1 = (shape1.cluster) ?
-                shape1.cluster->bounds : *boundingBoxes[info->varIndex1];
-        vpsc::Rectangle& rect2 = (shape2.cluster) ?
-                shape2.cluster->bounds : *boundingBoxes[info->varIndex2];
+        vpsc::Rectangle& rect1 = *shapeRect(shape1, boundingBoxes);
+        vpsc::Rectangle& rect2 = *shapeRect(shape2, boundingBoxes);
 
         double pos1 = rect1.getCentreD(dim);
         double pos2 = rect2.getCentreD(dim);
@@ -489,7 +602,7 @@ void NonOverlapConstraints::generateSeparationConstraints(
         else
         {
             // Must constrain to rectangle centre postion variable.
-            varLeft1 = varRight1 = vs[info->varIndex1];
+            varLeft1 = varRight1 = vs[varIndex1];
         }
 
         if (shape2.cluster)
@@ -502,10 +615,10 @@ void NonOverlapConstraints::generateSeparationConstraints(
         else
         {
             // Must constrain to rectangle centre postion variable.
-            varLeft2 = varRight2 = vs[info->varIndex2];
+            varLeft2 = varRight2 = vs[varIndex2];
         }
 
-        if (rect1.overlapD(!dim, &rect2) > 0.0005)
+        if (rect1.overlapD(otherDim, &rect2) > 0.0005)
         {
             if (pos1 < pos2)
             {
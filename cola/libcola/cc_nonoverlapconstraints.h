@@ -26,6 +26,7 @@
 */
 
 #include <vector>
+#include <set>
 #include "compound_constraints.h"
 
 namespace vpsc {
@@ -64,8 +65,25 @@ class NonOverlapConstraints : public CompoundConstraint {
                 std::vector<vpsc::Rectangle*>& boundingBoxes);
 
     private:
-        std::list<ShapePairInfo> pairInfoList;
+        void updateShapeBounds(vpsc::Variables vs[]);
+        void queueOverlappingPairs(void);
+
         std::map<unsigned, OverlapShapeOffsets> shapeOffsets;
+        // The number of pairs of shapes in the same group.  Only those
+        // pairs whose bounds overlap are ever looked at, but each pair may
+        // be processed as a subconstraint.
+        size_t pairCount;
+        std::map<unsigned, size_t> groupSizes;
+        // Shapes, sorted by the left side of their bounds for the sweep.
+        std::vector<OverlapShapeOffsets *> sweepOrder;
+        // Overlapping pairs, kept as a heap with the most overlapping 
+        // first.  Entries for shapes that have since moved are stale and 
+        // skipped when they reach the top, or dropped once the heap grows 
+        // beyond maxQueueSize.
+        std::vector<ShapePairInfo> overlapQueue;
+        size_t maxQueueSize;
+        std::set<std::pair<unsigned, unsigned> > processedPairs;
+        bool boundsValid;
         
         // Cluster variables
         size_t clusterVarStartIndex;
@@ -55,6 +55,7 @@ namespace topology {
 namespace cola {
 
 class NonOverlapConstraints;
+class QuadTree;
 
 //! Edges are simply a pair of indices to entries in the Node vector
 typedef std::pair<unsigned, unsigned> Edge;
@@ -445,6 +446,55 @@ public:
     {
         clusterHierarchy = hierarchy;
     }
+    /**
+     * Use a sparse approximation of the stress function, for large graphs
+     * where the n*n matrix of shortest path lengths would be too big.
+     * Each node keeps exact terms for the nodes within a few hops of it,
+     * and the rest of the graph is represented by terms between every
+     * node and a set of pivot nodes spread across the graph.  Memory use
+     * and time per iteration are then O(n*(neighbourhood+pivots)).  Must
+     * be called before the layout is run.
+     * @param pivots number of pivot nodes giving far-field terms
+     * @param hops   nodes within this many edges of each other have 
+     *        exact terms
+     */
+    void setSparseStress(const unsigned pivots=50, const unsigned hops=2);
+    /**
+     * Approximate the forces between nodes that aren't near each other in
+     * the graph using a quadtree (Barnes-Hut), rather than visiting every
+     * pair of nodes each iteration.  Terms for nodes within a few hops of
+     * each other are still computed exactly.  The nodes in a quadtree 
+     * cell are treated as one node at their centroid when the cell's size
+     * is less than theta times its distance from the node being moved, so
+     * smaller values of theta are more accurate but slower.  The n*n 
+     * matrix of shortest path lengths isn't needed: the path lengths of
+     * other pairs are estimated from the path lengths to a set of pivot
+     * nodes spread across the graph.  This replaces the sparse stress 
+     * model, so it can't be used with setSparseStress(), and must be 
+     * called before the layout is run.
+     * @param theta  accuracy parameter, or 0 to compute all terms exactly
+     * @param pivots number of pivot nodes used to estimate path lengths
+     * @param hops   nodes within this many edges of each other have 
+     *        exact terms
+     */
+    void setBarnesHut(const double theta=0.5, const unsigned pivots=50,
+            const unsigned hops=2);
+    /**
+     * Find starting positions for large graphs with a multilevel scheme
+     * the first time run() is called.  The graph is coarsened by merging
+     * matched pairs of neighbouring nodes until it has few nodes left,
+     * the coarsest graph is laid out, and each level's layout is then
+     * used as the starting point for the level below it, which needs 
+     * only a few iterations to refine.  Nodes in different clusters, and
+     * nodes that are used in constraints, are never merged, so the
+     * constraints, the cluster hierarchy and desired positions are 
+     * applied at every level.
+     * @param minLevelSize coarsening stops once a level has no more than 
+     *        this many nodes, or 0 to disable the multilevel scheme
+     */
+    void setMultilevel(const unsigned minLevelSize=50) {
+        multilevelMinSize=minLevelSize;
+    }
     /**
      * These lists will have info about unsatisfiable constraints
      * after each iteration of constrained layout
@@ -487,10 +537,16 @@ private:
             const double oldStress, 
             double stepsize
             /*,topology::TopologyConstraints *s=NULL*/);
+    void computePathLengths(void);
     void computePathLengths(
             const std::vector<Edge>& es,
             const double idealLength,
             const std::valarray<double> * eLengths);
+    void computeSparsePathLengths(
+            const std::vector<Edge>& es,
+            const double idealLength,
+            const std::valarray<double> * eLengths);
+    void computeMultilevelPositions(const bool xAxis, const bool yAxis);
     void generateNonOverlapAndClusterCompoundConstraints(
             vpsc::Variables (&vs)[2]);
     void handleResizes(const Resizes&);
@@ -499,18 +555,53 @@ private:
     bool noForces(double, double, unsigned) const;
     void computeForces(const vpsc::Dim dim, SparseMap &H, 
             std::valarray<double> &g);
+    double computeFarFieldTerms(const unsigned u, const QuadTree& tree,
+            const vpsc::Dim dim, SparseMap *H, double& gu, 
+            double& Huu, std::vector<bool>& isTerm) const;
+    double estimatedPathLength(const unsigned u, const unsigned v) const;
     void recGenerateClusterVariablesAndConstraints(
             vpsc::Variables (&vars)[2], unsigned int& priority, 
             cola::NonOverlapConstraints *noc, Cluster *cluster, 
             cola::CompoundConstraints& idleConstraints);
 
-    std::vector<std::vector<unsigned> > neighbours;
-    std::vector<std::vector<double> > neighbourLengths;
     TestConvergence& done;
     PreIteration* preIteration;
     cola::CompoundConstraints ccs;
     double** D;
     unsigned short** G;
+    // The nodes of each connected component, each of which gets its own
+    // quadtree in the Barnes-Hut mode.
+    std::vector<std::vector<unsigned> > components;
+    // A pair of nodes contributing to stress in the sparse stress model,
+    // or computed exactly in the Barnes-Hut mode, with the required 
+    // distance d and the same meaning for p as G.
+    struct StressTerm {
+        unsigned v;
+        double d;
+        unsigned short p;
+    };
+    typedef std::vector<StressTerm> StressTerms;
+    std::vector<StressTerms> stressTerms;
+    // In the Barnes-Hut mode, each node's path lengths to the pivots in 
+    // its component, with the pivots numbered in v in the order they 
+    // were chosen.
+    std::vector<StressTerms> pivotDistances;
+    std::vector<Edge> edges;
+    double idealLength;
+    std::valarray<double> edgeLengths;
+    // Whether computePathLengths() has set up D, G, components, 
+    // stressTerms and pivotDistances, which is left until they are first
+    // needed so that the stress model can be chosen after construction.
+    bool pathLengthsComputed;
+    unsigned sparsePivots;
+    unsigned sparseHops;
+    double barnesHutTheta;
+    unsigned barnesHutPivots;
+    unsigned barnesHutHops;
+    unsigned multilevelMinSize;
+    // The Hessian for each dimension, kept so its sparsity pattern can be
+    // reused from one iteration to the next.
+    SparseMap hessian[2];
     std::vector<topology::Node*> topologyNodes;
     std::vector<topology::Edge*> topologyRoutes;
     std::vector<UnsatisfiableConstraintInfos*> unsatisfiable;
@@ -27,8 +27,14 @@
 */
 
 #include <vector>
+#include <map>
+#include <set>
+#include <list>
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <queue>
+#include <functional>
 
 #include "libvpsc/solve_VPSC.h"
 #include "libvpsc/variable.h"
@@ -44,6 +50,7 @@
 #include "cola_log.h"
 #include "cc_clustercontainmentconstraints.h"
 #include "cc_nonoverlapconstraints.h"
+#include "quadtree.h"
 
 #ifdef MAKEFEASIBLE_DEBUG
   #include "output_svg.h"
@@ -93,6 +100,17 @@ ConstrainedFDLayout::ConstrainedFDLayout(const vpsc::Rectangles& rs,
       Y(valarray<double>(n)),
       done(done),
       preIteration(preIteration),
+      D(NULL),
+      G(NULL),
+      edges(es),
+      idealLength(idealLength),
+      pathLengthsComputed(false),
+      sparsePivots(0),
+      sparseHops(0),
+      barnesHutTheta(0),
+      barnesHutPivots(0),
+      barnesHutHops(0),
+      multilevelMinSize(0),
       rungekutta(true),
       desiredPositions(NULL),
       clusterHierarchy(NULL),
@@ -111,19 +129,85 @@ ConstrainedFDLayout::ConstrainedFDLayout(const vpsc::Rectangles& rs,
         Y[i]=(*ri)->getCentreY();
         FILE_LOG(logDEBUG) << *ri;
     }
+    hessian[0].resize(n);
+    hessian[1].resize(n);
+    if(eLengths != NULL) {
+        edgeLengths.resize(es.size());
+        edgeLengths = valarray<double>(eLengths,es.size());
+    }
+    // Path lengths are computed on first use, so the stress model can
+    // still be chosen with setSparseStress().
+}
+
+void ConstrainedFDLayout::setSparseStress(const unsigned pivots,
+        const unsigned hops)
+{
+    COLA_ASSERT(!pathLengthsComputed);
+    COLA_ASSERT(pivots>0 && hops>0);
+    // the Barnes-Hut mode has its own sparse terms
+    COLA_ASSERT(barnesHutTheta==0);
+    sparsePivots=pivots;
+    sparseHops=hops;
+}
+
+void ConstrainedFDLayout::setBarnesHut(const double theta,
+        const unsigned pivots, const unsigned hops)
+{
+    COLA_ASSERT(!pathLengthsComputed);
+    COLA_ASSERT(theta>=0);
+    // it would have no effect with the sparse stress model
+    COLA_ASSERT(theta==0 || sparsePivots==0);
+    COLA_ASSERT(pivots>0 && hops>0);
+    barnesHutTheta=theta;
+    barnesHutPivots=pivots;
+    barnesHutHops=hops;
+}
+
+/**
+ * Computes the path lengths for the chosen stress model, if this hasn't
+ * been done already.
+ */
+void ConstrainedFDLayout::computePathLengths(void)
+{
+    if(pathLengthsComputed) return;
+    pathLengthsComputed=true;
+    const valarray<double>* eLengths = 
+        (edgeLengths.size()>0) ? &edgeLengths : NULL;
+    // group the nodes by connected component, so that Barnes-Hut cells
+    // only ever hold nodes with terms between them
+    vector<vector<unsigned> > adjacent(n);
+    for(vector<Edge>::const_iterator e=edges.begin();e!=edges.end();++e) {
+        if(e->first==e->second) continue;
+        adjacent[e->first].push_back(e->second);
+        adjacent[e->second].push_back(e->first);
+    }
+    components.clear();
+    vector<bool> placed(n,false);
+    for(unsigned i=0;i<n;i++) {
+        if(placed[i]) continue;
+        placed[i]=true;
+        components.push_back(vector<unsigned>(1,i));
+        vector<unsigned>& nodes=components.back();
+        for(unsigned j=0;j<nodes.size();j++) {
+            const vector<unsigned>& next=adjacent[nodes[j]];
+            for(unsigned k=0;k<next.size();k++) {
+                if(placed[next[k]]) continue;
+                placed[next[k]]=true;
+                nodes.push_back(next[k]);
+            }
+        }
+    }
+    if(sparsePivots>0 || barnesHutTheta>0) {
+        computeSparsePathLengths(edges,idealLength,eLengths);
+        return;
+    }
     D=new double*[n];
     G=new unsigned short*[n];
     for(unsigned i=0;i<n;i++) {
         D[i]=new double[n];
         G[i]=new unsigned short[n];
     }
-
-    if(eLengths == NULL) {
-        computePathLengths(es,idealLength,NULL);
-    } else {
-        valarray<double> eLengthsArray(eLengths,es.size());
-        computePathLengths(es,idealLength,&eLengthsArray);
-    }    
+    computePathLengths(edges,idealLength,eLengths);
 }
 
 void dijkstra(const unsigned s, const unsigned n, double* d, 
@@ -151,7 +235,7 @@ void dijkstra(const unsigned s, const unsigned n, double* d,
 void ConstrainedFDLayout::computePathLengths(
         const vector<Edge>& es,
         const double idealLength,
-        const std::valarray<double>* eLengths) 
+        const std::valarray<double>* eLengths)
 {
     shortest_paths::johnsons(n,D,es,eLengths);
     //dumpSquareMatrix<double>(n,D);
@@ -177,7 +261,7 @@ void ConstrainedFDLayout::computePathLengths(
     // by an edge if there is a topologyRoute between them (since the
     // p-stress force will be used instead)
     if(!topologyRoutes.empty()) {
-        for(vector<topology::Edge*>::iterator i=topologyRoutes.begin();
+        for(vector<topology::Edge*>::const_iterator i=topologyRoutes.begin();
                 i!=topologyRoutes.end();++i) {
             topology::Edge* e=*i;
             if(!e->cycle()) {
@@ -190,6 +274,198 @@ void ConstrainedFDLayout::computePathLengths(
     //dumpSquareMatrix<short>(n,G);
 }
 
+/**
+ * Finds the shortest path lengths from s to the nodes within maxHops edges
+ * of it, by a Dijkstra search over adjacent that stops at that many hops.
+ * dist and hops must hold DBL_MAX and 0 for every node.  The nodes reached
+ * are appended to reached, and the caller must reset their dist and hops.
+ */
+static void boundedDijkstra(const unsigned s, 
+        const vector<vector<pair<unsigned,double> > >& adjacent,
+        const unsigned maxHops, vector<double>& dist, vector<unsigned>& hops,
+        vector<unsigned>& reached)
+{
+    typedef pair<double,unsigned> DistNode;
+    priority_queue<DistNode,vector<DistNode>,greater<DistNode> > q;
+    dist[s]=0;
+    reached.push_back(s);
+    q.push(make_pair(0.0,s));
+    while(!q.empty()) {
+        DistNode top=q.top();
+        q.pop();
+        unsigned w=top.second;
+        if(top.first>dist[w] || hops[w]==maxHops) continue;
+        for(unsigned i=0;i<adjacent[w].size();i++) {
+            unsigned x=adjacent[w][i].first;
+            double d=top.first+adjacent[w][i].second;
+            if(d<dist[x]) {
+                if(dist[x]==DBL_MAX) reached.push_back(x);
+                dist[x]=d;
+                hops[x]=hops[w]+1;
+                q.push(make_pair(d,x));
+            }
+        }
+    }
+}
+
+/**
+ * Sets up the stressTerms for the sparse stress model and the Barnes-Hut
+ * mode.  Each node gets a term for every node within the chosen number of
+ * hops of it, with p=1 for nodes joined by an edge (with no topology 
+ * route between them) and p=2 otherwise.  Then pivot nodes are chosen, 
+ * each as far as possible from those before it.  In the sparse stress 
+ * model every node gets a term for each pivot in its component that 
+ * isn't already a neighbour.  In the Barnes-Hut mode the path lengths to
+ * the pivots are kept in pivotDistances instead, and every component of 
+ * more than one node gets a pivot, even past the number asked for.
+ * Terms are symmetric, so each appears in the lists of both its nodes.
+ */
+void ConstrainedFDLayout::computeSparsePathLengths(
+        const vector<Edge>& es,
+        const double idealLength,
+        const std::valarray<double>* eLengths)
+{
+    const bool barnesHut=barnesHutTheta>0;
+    vector<vector<pair<unsigned,double> > > adjacent(n);
+    for(unsigned i=0;i<es.size();i++) {
+        unsigned u=es[i].first, v=es[i].second;
+        if(u==v) continue;
+        double l=eLengths?(*eLengths)[i]:1;
+        adjacent[u].push_back(make_pair(v,l));
+        adjacent[v].push_back(make_pair(u,l));
+    }
+    const double scale=eLengths?1:idealLength;
+
+    stressTerms.assign(n,StressTerms());
+    vector<double> dist(n,DBL_MAX);
+    vector<unsigned> hops(n,0);
+    vector<unsigned> reached;
+    const unsigned maxHops=barnesHut?barnesHutHops:sparseHops;
+    for(unsigned u=0;u<n;u++) {
+        boundedDijkstra(u,adjacent,maxHops,dist,hops,reached);
+        for(unsigned i=0;i<reached.size();i++) {
+            unsigned v=reached[i];
+            if(v>u) {
+                StressTerm t={v,dist[v]*scale,2};
+                stressTerms[u].push_back(t);
+                t.v=u;
+                stressTerms[v].push_back(t);
+            }
+            dist[v]=DBL_MAX;
+            hops[v]=0;
+        }
+        reached.clear();
+    }
+    for(vector<Edge>::const_iterator e=es.begin();e!=es.end();++e) {
+        unsigned u=e->first, v=e->second; 
+        for(unsigned i=0;i<stressTerms[u].size();i++) {
+            if(stressTerms[u][i].v==v) stressTerms[u][i].p=1;
+        }
+        for(unsigned i=0;i<stressTerms[v].size();i++) {
+            if(stressTerms[v][i].v==u) stressTerms[v][i].p=1;
+        }
+    }
+    // as for G, a topology route replaces the attractive force
+    for(vector<topology::Edge*>::const_iterator i=topologyRoutes.begin();
+            i!=topologyRoutes.end();++i) {
+        topology::Edge* e=*i;
+        if(e->cycle()) continue;
+        unsigned u=e->firstSegment->start->node->id,
+                 v=e->lastSegment->end->node->id;
+        for(unsigned i=0;i<stressTerms[u].size();i++) {
+            if(stressTerms[u][i].v==v) stressTerms[u][i].p=2;
+        }
+        for(unsigned i=0;i<stressTerms[v].size();i++) {
+            if(stressTerms[v][i].v==u) stressTerms[v][i].p=2;
+        }
+    }
+
+    vector<double> minPivotDist(n,DBL_MAX);
+    for(unsigned v=0;v<n;v++) {
+        // there is nothing for a pivot at an isolated node to do
+        if(adjacent[v].empty()) minPivotDist[v]=0;
+    }
+    vector<bool> isTerm(n,false);
+    pivotDistances.assign(barnesHut?n:0,StressTerms());
+    const unsigned pivots=min(barnesHut?barnesHutPivots:sparsePivots,n);
+    unsigned c=0;
+    for(unsigned k=0;;k++) {
+        unsigned pivot=n;
+        if(k<pivots) {
+            // The next pivot is the node furthest from all earlier 
+            // pivots, or a node in a component with no pivot yet.
+            unsigned furthest=0;
+            for(unsigned v=1;v<n;v++) {
+                if(minPivotDist[v]>minPivotDist[furthest]) furthest=v;
+            }
+            if(minPivotDist[furthest]>0) pivot=furthest;
+        } else if(barnesHut) {
+            // Path lengths can only be estimated in components with a 
+            // pivot, so find any left without one.
+            for(;c<components.size() && pivot==n;c++) {
+                const vector<unsigned>& nodes=components[c];
+                if(nodes.size()>1 && minPivotDist[nodes[0]]==DBL_MAX) {
+                    pivot=nodes[0];
+                }
+            }
+        }
+        if(pivot==n) break;
+        boundedDijkstra(pivot,adjacent,numeric_limits<unsigned>::max(),
+                dist,hops,reached);
+        StressTerms& pivotTerms=stressTerms[pivot];
+        for(unsigned i=0;i<pivotTerms.size();i++) {
+            isTerm[pivotTerms[i].v]=true;
+        }
+        for(unsigned i=0;i<reached.size();i++) {
+            unsigned v=reached[i];
+            minPivotDist[v]=min(minPivotDist[v],dist[v]);
+            if(barnesHut) {
+                StressTerm t={k,dist[v]*scale,2};
+                pivotDistances[v].push_back(t);
+            } else if(v!=pivot && !isTerm[v]) {
+                StressTerm t={v,dist[v]*scale,2};
+                pivotTerms.push_back(t);
+                t.v=pivot;
+                stressTerms[v].push_back(t);
+            }
+            dist[v]=DBL_MAX;
+            hops[v]=0;
+        }
+        reached.clear();
+        for(unsigned i=0;i<pivotTerms.size();i++) {
+            isTerm[pivotTerms[i].v]=false;
+        }
+    }
+}
+
+/**
+ * Estimates the path length between u and v, in the Barnes-Hut mode, from
+ * their path lengths to their component's pivots.  By the triangle 
+ * inequality the path length is at most the shortest path through a 
+ * pivot, and at least the largest difference between their path lengths
+ * to a pivot, and the estimate is halfway between the two.
+ */
+double ConstrainedFDLayout::estimatedPathLength(
+        const unsigned u, const unsigned v) const
+{
+    const StressTerms& a=pivotDistances[u];
+    const StressTerms& b=pivotDistances[v];
+    double upper=DBL_MAX, lower=0;
+    for(unsigned i=0,j=0;i<a.size() && j<b.size();) {
+        if(a[i].v<b[j].v) {
+            i++;
+        } else if(a[i].v>b[j].v) {
+            j++;
+        } else {
+            upper=min(upper,a[i].d+b[j].d);
+            lower=max(lower,fabs(a[i].d-b[j].d));
+            i++;
+            j++;
+        }
+    }
+    return (upper+lower)/2;
+}
+
 typedef valarray<double> Position;
 void getPosition(Position& X, Position& Y, Position& pos) {
     unsigned n=X.size();
@@ -237,6 +513,11 @@ void ConstrainedFDLayout::computeDescentVectorOnBothAxes(
  */
 void ConstrainedFDLayout::run(const bool xAxis, const bool yAxis) 
 {
+    if(multilevelMinSize>0) {
+        computeMultilevelPositions(xAxis,yAxis);
+        multilevelMinSize=0;
+    }
+    computePathLengths();
     if (extraConstraints.empty())
     {
         // This generates constraints for non-overlap inside and outside
@@ -295,6 +576,7 @@ void ConstrainedFDLayout::run(const bool xAxis, const bool yAxis)
  */
 void ConstrainedFDLayout::runOnce(const bool xAxis, const bool yAxis) {
     if(n==0) return;
+    computePathLengths();
     double stress=DBL_MAX;
     unsigned N=2*n;
     Position x0(N),x1(N);
@@ -314,6 +596,266 @@ void ConstrainedFDLayout::runOnce(const bool xAxis, const bool yAxis) {
     }
 }
 
+// Records, for each node, the innermost cluster containing it.
+static void recFindNodeClusters(Cluster *cluster, vector<Cluster*>& clusterOf,
+        vector<bool>& fixed)
+{
+    for(unsigned i=0;i<cluster->nodes.size();i++) {
+        if(cluster->nodes[i]<clusterOf.size()) {
+            clusterOf[cluster->nodes[i]]=cluster;
+        }
+    }
+    RectangularCluster *rc=dynamic_cast<RectangularCluster*>(cluster);
+    if(rc && rc->clusterIsFromFixedRectangle()) {
+        fixed[rc->rectangleIndex()]=true;
+    }
+    for(unsigned i=0;i<cluster->clusters.size();i++) {
+        recFindNodeClusters(cluster->clusters[i],clusterOf,fixed);
+    }
+}
+
+/**
+ * Returns a copy of the cluster and those within it for the coarse graph 
+ * of a multilevel layout, where the node i is replaced by coarse[i].
+ */
+static Cluster* coarsenCluster(const Cluster *cluster, 
+        const vector<unsigned>& coarse)
+{
+    Cluster *copy=NULL;
+    const RectangularCluster *rc=
+        dynamic_cast<const RectangularCluster*>(cluster);
+    if(dynamic_cast<const RootCluster*>(cluster)) {
+        copy=new RootCluster();
+    } else if(rc && rc->clusterIsFromFixedRectangle()) {
+        copy=new RectangularCluster(coarse[rc->rectangleIndex()]);
+    } else if(rc) {
+        copy=new RectangularCluster();
+    } else {
+        copy=new ConvexCluster();
+    }
+    copy->rectBuffer=cluster->rectBuffer;
+    copy->varWeight=cluster->varWeight;
+    copy->internalEdgeWeightFactor=cluster->internalEdgeWeightFactor;
+    set<unsigned> nodes;
+    for(unsigned i=0;i<cluster->nodes.size();i++) {
+        if(cluster->nodes[i]<coarse.size() && 
+                nodes.insert(coarse[cluster->nodes[i]]).second) {
+            copy->addChildNode(coarse[cluster->nodes[i]]);
+        }
+    }
+    for(unsigned i=0;i<cluster->clusters.size();i++) {
+        copy->addChildCluster(coarsenCluster(cluster->clusters[i],coarse));
+    }
+    return copy;
+}
+
+/**
+ * Sets the starting positions for run() using a multilevel scheme.
+ * The graph is coarsened once, by merging pairs of nodes matched along
+ * edges, and the coarse graph is laid out by another ConstrainedFDLayout
+ * (which coarsens it again, and so on, until it is small enough).  Each
+ * pair of merged nodes is then placed either side of the position found 
+ * for their coarse node, half the length of the edge between them apart.
+ * Nodes in constraints or fixed-rectangle clusters are never merged, so 
+ * the constraints and the clusters are mapped onto the coarse graph.
+ */
+void ConstrainedFDLayout::computeMultilevelPositions(
+        const bool xAxis, const bool yAxis)
+{
+    if(n<=multilevelMinSize || !topologyNodes.empty()) return;
+
+    // Nodes in different clusters, or used in constraints, aren't merged.
+    vector<Cluster*> clusterOf(n,(Cluster*)NULL);
+    vector<bool> fixed(n,false);
+    if(clusterHierarchy) {
+        recFindNodeClusters(clusterHierarchy,clusterOf,fixed);
+    }
+    for(unsigned i=0;i<ccs.size();i++) {
+        list<unsigned> ids=ccs[i]->shapeIndexes();
+        for(list<unsigned>::iterator j=ids.begin();j!=ids.end();++j) {
+            if(*j<n) fixed[*j]=true;
+        }
+    }
+
+    // Edge lengths are kept in layout units throughout, as computed by 
+    // computePathLengths(): edgeLengths if they were given, otherwise 
+    // idealLength.  They are passed to the coarse layout explicitly, so it
+    // lays out the coarse graph at the same scale.
+    vector<double> lengths(edges.size(),idealLength);
+    for(unsigned i=0;i<edges.size()&&edgeLengths.size()>0;i++) {
+        lengths[i]=edgeLengths[i];
+    }
+
+    // Match each node with its unmatched neighbour of lowest degree,
+    // visiting nodes in order of increasing degree.
+    vector<vector<pair<unsigned,double> > > adj(n);
+    for(unsigned i=0;i<edges.size();i++) {
+        unsigned u=edges[i].first, v=edges[i].second;
+        if(u==v) continue;
+        double l=lengths[i];
+        adj[u].push_back(make_pair(v,l));
+        adj[v].push_back(make_pair(u,l));
+    }
+    vector<pair<size_t,unsigned> > order(n);
+    for(unsigned i=0;i<n;i++) {
+        order[i]=make_pair(adj[i].size(),i);
+    }
+    sort(order.begin(),order.end());
+    vector<unsigned> coarse(n,n), partner(n,n);
+    vector<double> mergedLength;
+    unsigned nc=0;
+    for(unsigned k=0;k<n;k++) {
+        unsigned u=order[k].second;
+        if(coarse[u]!=n) continue;
+        coarse[u]=nc;
+        mergedLength.push_back(0);
+        unsigned best=n;
+        for(unsigned j=0;j<adj[u].size()&&!fixed[u];j++) {
+            unsigned v=adj[u][j].first;
+            if(coarse[v]!=n || fixed[v] || clusterOf[u]!=clusterOf[v]) {
+                continue;
+            }
+            if(best==n || adj[v].size()<adj[best].size()) {
+                best=v;
+                mergedLength[nc]=adj[u][j].second;
+            }
+        }
+        if(best!=n) {
+            coarse[best]=nc;
+            partner[u]=best;
+            partner[best]=u;
+        }
+        nc++;
+    }
+    if(nc>0.9*n) {
+        // Too few nodes could be merged for another level to be worthwhile.
+        return;
+    }
+
+    // Coarse nodes start at the centroid of the nodes they replace.
+    // Their size is only used for drawing, since coarse levels don't 
+    // prevent overlaps.
+    vpsc::Rectangles coarseRs(nc,(vpsc::Rectangle*)NULL);
+    vector<unsigned> members(nc,0);
+    valarray<double> cx(0.0,nc), cy(0.0,nc);
+    for(unsigned i=0;i<n;i++) {
+        unsigned c=coarse[i];
+        cx[c]+=X[i];
+        cy[c]+=Y[i];
+        members[c]++;
+    }
+    for(unsigned c=0;c<nc;c++) {
+        cx[c]/=members[c];
+        cy[c]/=members[c];
+    }
+    for(unsigned i=0;i<n;i++) {
+        unsigned c=coarse[i];
+        if(coarseRs[c]) continue;
+        double w=boundingBoxes[i]->width()/2, h=boundingBoxes[i]->height()/2;
+        coarseRs[c]=new vpsc::Rectangle(cx[c]-w,cx[c]+w,cy[c]-h,cy[c]+h);
+    }
+
+    // Parallel edges are combined, with the average of their lengths 
+    // plus half the lengths of the edges merged into their ends.
+    map<Edge,pair<double,unsigned> > combined;
+    for(unsigned i=0;i<edges.size();i++) {
+        unsigned u=coarse[edges[i].first], v=coarse[edges[i].second];
+        if(u==v) continue;
+        if(u>v) swap(u,v);
+        pair<double,unsigned>& e=combined[make_pair(u,v)];
+        e.first+=lengths[i];
+        e.second++;
+    }
+    vector<Edge> coarseEs;
+    vector<double> coarseLengths;
+    for(map<Edge,pair<double,unsigned> >::iterator i=combined.begin();
+            i!=combined.end();++i) {
+        unsigned u=i->first.first, v=i->first.second;
+        coarseEs.push_back(i->first);
+        coarseLengths.push_back(i->second.first/i->second.second
+                +0.5*(mergedLength[u]+mergedLength[v]));
+    }
+
+    // The constraints are applied to the coarse graph while it is laid 
+    // out, and then changed back.  Their nodes weren't merged, so each 
+    // is the only node in its coarse node.
+    vector<unsigned> fine(nc,n);
+    for(unsigned i=0;i<n;i++) {
+        if(fixed[i]) fine[coarse[i]]=i;
+    }
+    for(unsigned i=0;i<ccs.size();i++) {
+        ccs[i]->remapShapeIndexes(coarse);
+    }
+    RootCluster *coarseClusters=NULL;
+    if(clusterHierarchy && !clusterHierarchy->flat()) {
+        coarseClusters=
+            static_cast<RootCluster*>(coarsenCluster(clusterHierarchy,coarse));
+    }
+    DesiredPositions coarseDesired;
+    if(desiredPositions) {
+        map<unsigned,DesiredPosition> byNode;
+        for(unsigned i=0;i<desiredPositions->size();i++) {
+            const DesiredPosition& p=(*desiredPositions)[i];
+            DesiredPosition& q=byNode[coarse[p.id]];
+            q.id=coarse[p.id];
+            q.x+=p.weight*p.x;
+            q.y+=p.weight*p.y;
+            q.weight+=p.weight;
+        }
+        for(map<unsigned,DesiredPosition>::iterator i=byNode.begin();
+                i!=byNode.end();++i) {
+            DesiredPosition p=i->second;
+            if(p.weight>0) {
+                p.x/=p.weight;
+                p.y/=p.weight;
+            }
+            coarseDesired.push_back(p);
+        }
+    }
+
+    {
+        TestConvergence coarseDone;
+        ConstrainedFDLayout coarseLayout(coarseRs,coarseEs,idealLength,false,
+                coarseLengths.empty()?NULL:&coarseLengths[0],coarseDone);
+        if(sparsePivots>0) {
+            coarseLayout.setSparseStress(sparsePivots,sparseHops);
+        }
+        if(barnesHutTheta>0) {
+            coarseLayout.setBarnesHut(barnesHutTheta,barnesHutPivots,
+                    barnesHutHops);
+        }
+        coarseLayout.setMultilevel(multilevelMinSize);
+        coarseLayout.setConstraints(ccs);
+        coarseLayout.setClusterHierarchy(coarseClusters);
+        if(desiredPositions) {
+            coarseLayout.setDesiredPositions(&coarseDesired);
+        }
+        coarseLayout.run(xAxis,yAxis);
+    }
+    for(unsigned i=0;i<ccs.size();i++) {
+        ccs[i]->remapShapeIndexes(fine);
+    }
+    delete coarseClusters;
+
+    // Spread each merged pair along a direction that varies from one 
+    // coarse node to the next, so that neighbouring pairs don't all 
+    // start out parallel.
+    const double goldenAngle=2.39996322972865332;
+    for(unsigned i=0;i<n;i++) {
+        unsigned c=coarse[i];
+        double x=coarseRs[c]->getCentreX(), y=coarseRs[c]->getCentreY();
+        if(partner[i]!=n) {
+            double r=0.5*mergedLength[c]*(i<partner[i]?-1:1);
+            x+=r*cos(goldenAngle*c);
+            y+=r*sin(goldenAngle*c);
+        }
+        if(xAxis) X[i]=x;
+        if(yAxis) Y[i]=y;
+    }
+    moveBoundingBoxes();
+    for_each(coarseRs.begin(),coarseRs.end(),delete_object());
+}
+
 
 // Used for sorting the CompoundConstraints from lowest priority to highest. 
 static bool cmpCompoundConstraintPriority(const cola::CompoundConstraint *lhs, 
@@ -484,8 +1026,6 @@ void ConstrainedFDLayout::makeFeasible(void)
         }
     }
 
-    vector<double> priorPos(boundingBoxes.size());
-
     // Clear extra constraints for cluster containment and non-overlap.
     // We keep a separate list of these since we keep them around for 
     // later solving.
@@ -509,6 +1049,15 @@ void ConstrainedFDLayout::makeFeasible(void)
         generateVariables(idleConstraints, (vpsc::Dim) dim, vs[dim]);
     }
 
+    // Constraints are added to a single solver for each dimension as they
+    // are accepted, so each solve starts from the block structure found by
+    // the last one, rather than from scratch.
+    vpsc::IncSolver *solvers[2];
+    for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+        solvers[dim] = new vpsc::IncSolver(vs[dim], valid[dim]);
+    }
+
 #ifdef MAKEFEASIBLE_DEBUG
     char filename[200];
     int iteration = 0;
@@ -565,12 +1114,12 @@ void ConstrainedFDLayout::makeFeasible(void)
                 vpsc::Dim& dim = alternatives.front().dim;
                 vpsc::Constraint& constraint = alternatives.front().constraint;
                 valid[dim].push_back(new vpsc::Constraint(constraint));
+                solvers[dim]->addConstraint(valid[dim].back());
                 cc->markCurrSubConstraintAsActive(subConstraintSatisfiable);
             }
             for (size_t dim = 0; dim < 2; ++dim)
             {
-                vpsc::IncSolver vpscInstance(vs[dim], valid[dim]);
-                vpscInstance.satisfy();
+                solvers[dim]->satisfy();
             }
             continue;
         }
@@ -589,11 +1138,9 @@ void ConstrainedFDLayout::makeFeasible(void)
                 vpsc::Dim& dim = alternatives.front().dim;
                 vpsc::Constraint& constraint = alternatives.front().constraint;
             
-                // Store current values for variables.
-                for (unsigned int i = 0; i < priorPos.size(); ++i)
-                {
-                    priorPos[i] = vs[dim][i]->finalPosition;
-                }
+                // Remember the current solution, so it can be restored
+                // if this alternative is unsatisfiable.
+                solvers[dim]->checkpoint();
 
                 // Some solving...
                 try 
@@ -601,11 +1148,11 @@ void ConstrainedFDLayout::makeFeasible(void)
                     // Add the constraint from this alternative to the 
                     // valid constraint set.
                     valid[dim].push_back(new vpsc::Constraint(constraint));
+                    solvers[dim]->addConstraint(valid[dim].back());
 
                     //fprintf(stderr, ".%d %3d - ", dim, valid[dim].size());
                     // Solve with this constraint set.
-                    vpsc::IncSolver vpscInstance(vs[dim], valid[dim]);
-                    vpscInstance.satisfy();
+                    solvers[dim]->satisfy();
                 }
                 catch (char *str) 
                 {
@@ -637,11 +1184,9 @@ void ConstrainedFDLayout::makeFeasible(void)
                 {
                     //fprintf(stderr, "*");
 
-                    // Restore previous values for variables.
-                    for (unsigned int i = 0; i < priorPos.size(); ++i)
-                    {
-                        vs[dim][i]->finalPosition = priorPos[i];
-                    }
+                    // Restore the previous solution and remove the newly 
+                    // added (and unsatisfiable) constraint from the solver.
+                    solvers[dim]->rollback();
                     
                     // Delete the newly added (and unsatisfiable) 
                     // constraint from the valid constraint set.
@@ -703,6 +1248,7 @@ void ConstrainedFDLayout::makeFeasible(void)
     // Cleanup.
     for (unsigned int dim = 0; dim < 2; ++dim)
     {
+        delete solvers[dim];
         for_each(valid[dim].begin(), valid[dim].end(), delete_object());
         for_each(vs[dim].begin(), vs[dim].end(), delete_object());
     }
@@ -766,13 +1312,17 @@ void ConstrainedFDLayout::makeFeasible(void)
 
 ConstrainedFDLayout::~ConstrainedFDLayout()
 {
-    for (unsigned i = 0; i < n; ++i)
+    if (D)
     {
-        delete [] G[i];
-        delete [] D[i];
+        for (unsigned i = 0; i < n; ++i)
+        {
+            delete [] G[i];
+            delete [] D[i];
+        }
+        delete [] G;
+        delete [] D;
     }
-    delete [] G;
-    delete [] D;
+    for_each(extraConstraints.begin(), extraConstraints.end(), delete_object());
 }
 
 void ConstrainedFDLayout::freeAssociatedObjects(void)
@@ -804,6 +1354,8 @@ void ConstrainedFDLayout::freeAssociatedObjects(void)
 void ConstrainedFDLayout::setTopology(std::vector<topology::Node*> *tnodes, 
         std::vector<topology::Edge*> *routes)
 {
+    // Path lengths don't take the topology routes into account.
+    computePathLengths();
     topologyNodes = *tnodes;
     topologyRoutes = *routes;
 }
@@ -1031,10 +1583,12 @@ double ConstrainedFDLayout::applyForcesAndConstraints(const vpsc::Dim dim, const
                 clusterHierarchy, vs, cs);
         bool interrupted;
         int loopBreaker=100;
-        SparseMap HMap(n);
+        SparseMap& HMap=hessian[dim];
+        HMap.clearValues();
         computeForces(dim,HMap,g);
         valarray<double> oldCoords=coords;
         t.computeForces(g,HMap);
+        HMap.assemble();
         cola::SparseMatrix H(HMap);
         applyDescentVector(g,oldCoords,coords,oldStress,
                 computeStepSize(H,g,g));
@@ -1061,8 +1615,10 @@ double ConstrainedFDLayout::applyForcesAndConstraints(const vpsc::Dim dim, const
         // Add non-overlap constraints, but not variables again.
         setupExtraConstraints(extraConstraints, dim, vs, cs, boundingBoxes);
         // Projection.
-        SparseMap HMap(n);
+        SparseMap& HMap=hessian[dim];
+        HMap.clearValues();
         computeForces(dim,HMap,g);
+        HMap.assemble();
         SparseMatrix H(HMap);
         valarray<double> oldCoords=coords;
         applyDescentVector(g,oldCoords,coords,oldStress,computeStepSize(H,g,g));
@@ -1132,18 +1688,35 @@ void ConstrainedFDLayout::computeForces(
         valarray<double> &g) {
     if(n==1) return;
     g=0;
+    if(barnesHutTheta>0) {
+        vector<bool> isTerm(n,false);
+        for(unsigned c=0;c<components.size();c++) {
+            const vector<unsigned>& nodes=components[c];
+            // no forces between disconnected parts of the graph
+            if(nodes.size()<2) continue;
+            QuadTree tree(X,Y,nodes);
+            for(unsigned i=0;i<nodes.size();i++) {
+                const unsigned u=nodes[i];
+                double Huu=0;
+                computeFarFieldTerms(u,tree,dim,&H,g[u],Huu,isTerm);
+                H(u,u)=Huu;
+            }
+        }
+    } else
     // for each node:
     for(unsigned u=0;u<n;u++) {
         // Stress model
         double Huu=0;
-        for(unsigned v=0;v<n;v++) {
+        const unsigned terms=D?n:stressTerms[u].size();
+        for(unsigned i=0;i<terms;i++) {
+            const unsigned v=D?i:stressTerms[u][i].v;
             if(u==v) continue;
-            unsigned short p = G[u][v];
+            unsigned short p = D?G[u][v]:stressTerms[u][i].p;
             // no forces between disconnected parts of the graph
             if(p==0) continue;
             double rx=X[u]-X[v], ry=Y[u]-Y[v];
             double l=sqrt(rx*rx+ry*ry);
-            double d=D[u][v];
+            double d=D?D[u][v]:stressTerms[u][i].d;
             if(l>d && p>1) continue; // attractive forces not required
             double d2=d*d;
             /* force apart zero distances */
@@ -1169,6 +1742,104 @@ void ConstrainedFDLayout::computeForces(
         }
     }
 }
+/**
+ * Computes the stress terms between u and all other nodes, for the 
+ * Barnes-Hut mode of computeForces() and computeStress().  The terms in
+ * stressTerms[u] are exact.  The path lengths to other nodes are 
+ * estimated from the pivots, and those in a distant quadtree cell are
+ * treated as all being at its centroid with u's estimated path length to
+ * the cell's representative node, contributing only to the diagonal of 
+ * the Hessian.  The tree must hold only the nodes of u's component.  Adds
+ * to the gradient gu and the Hessian diagonal Huu, sets the off-diagonal
+ * Hessian entries in H if it isn't NULL, and returns the stress of these
+ * terms.  isTerm is scratch space, which must be all false for n nodes.
+ */
+double ConstrainedFDLayout::computeFarFieldTerms(
+        const unsigned u,
+        const QuadTree& tree,
+        const vpsc::Dim dim,
+        SparseMap *H,
+        double& gu,
+        double& Huu,
+        vector<bool>& isTerm) const {
+    double stress=0;
+    const StressTerms& terms=stressTerms[u];
+    for(unsigned i=0;i<terms.size();i++) {
+        unsigned v=terms[i].v;
+        isTerm[v]=true;
+        double rx=X[u]-X[v], ry=Y[u]-Y[v];
+        double l=sqrt(rx*rx+ry*ry);
+        double d=terms[i].d;
+        if(l>d && terms[i].p>1) continue; // attractive forces not required
+        double d2=d*d;
+        stress+=(d-l)*(d-l)/d2;
+        if (l < 1e-30) {
+            l=0.1;
+        }
+        double dx=dim==vpsc::HORIZONTAL?rx:ry;
+        double dy=dim==vpsc::HORIZONTAL?ry:rx;
+        gu+=dx*(l-d)/(d2*l);
+        double h=(d*dy*dy/(l*l*l)-1)/d2;
+        if(H) (*H)(u,v)=h;
+        Huu-=h;
+    }
+    vector<unsigned> cellStack(1,0);
+    while(!cellStack.empty()) {
+        const QuadTree::Cell& cell=tree.cells[cellStack.back()];
+        cellStack.pop_back();
+        if(cell.count==0) continue;
+        double rx=X[u]-cell.cx, ry=Y[u]-cell.cy;
+        double l=sqrt(rx*rx+ry*ry);
+        if(!cell.contains(X[u],Y[u]) && cell.size()<barnesHutTheta*l) {
+            unsigned v=cell.representative;
+            double d=estimatedPathLength(u,v), d2=d*d;
+            if(l>d) continue; // attractive forces not required
+            // the cell's mass is its nodes less those with exact terms
+            unsigned exact=0;
+            for(unsigned i=0;i<terms.size();i++) {
+                unsigned w=terms[i].v;
+                if(cell.containsNode(X[w],Y[w])) exact++;
+            }
+            if(cell.containsNode(X[u],Y[u])) exact++;
+            if(exact>=cell.count) continue;
+            double m=cell.count-exact;
+            stress+=m*(d-l)*(d-l)/d2;
+            double dx=dim==vpsc::HORIZONTAL?rx:ry;
+            double dy=dim==vpsc::HORIZONTAL?ry:rx;
+            gu+=m*dx*(l-d)/(d2*l);
+            Huu-=m*(d*dy*dy/(l*l*l)-1)/d2;
+        } else if(cell.isLeaf()) {
+            for(unsigned i=0;i<cell.nodes.size();i++) {
+                unsigned v=cell.nodes[i];
+                // exact terms were done above
+                if(u==v || isTerm[v]) continue;
+                double rx=X[u]-X[v], ry=Y[u]-Y[v];
+                double l=sqrt(rx*rx+ry*ry);
+                double d=estimatedPathLength(u,v);
+                if(l>d) continue; // attractive forces not required
+                double d2=d*d;
+                stress+=(d-l)*(d-l)/d2;
+                if (l < 1e-30) {
+                    l=0.1;
+                }
+                double dx=dim==vpsc::HORIZONTAL?rx:ry;
+                double dy=dim==vpsc::HORIZONTAL?ry:rx;
+                gu+=dx*(l-d)/(d2*l);
+                double h=(d*dy*dy/(l*l*l)-1)/d2;
+                if(H) (*H)(u,v)=h;
+                Huu-=h;
+            }
+        } else {
+            for(unsigned q=0;q<4;q++) {
+                cellStack.push_back(cell.children[q]);
+            }
+        }
+    }
+    for(unsigned i=0;i<terms.size();i++) {
+        isTerm[terms[i].v]=false;
+    }
+    return stress;
+}
 /**
  * Returns the optimal step-size in the direction d, given gradient g and 
  * hessian H.
@@ -1197,15 +1868,37 @@ double ConstrainedFDLayout::computeStepSize(
  */
 double ConstrainedFDLayout::computeStress() const {
     FILE_LOG(logDEBUG)<<"ConstrainedFDLayout::computeStress()";
+    // The path lengths are a cache of the graph, so building them here
+    // doesn't change the layout's observable state.
+    const_cast<ConstrainedFDLayout*>(this)->computePathLengths();
     double stress=0;
+    if(barnesHutTheta>0) {
+        // only the stress is needed, the gradient terms are thrown away
+        double gu=0, Huu=0;
+        vector<bool> isTerm(n,false);
+        for(unsigned c=0;c<components.size();c++) {
+            const vector<unsigned>& nodes=components[c];
+            if(nodes.size()<2) continue;
+            QuadTree tree(X,Y,nodes);
+            for(unsigned i=0;i<nodes.size();i++) {
+                // each pair is seen from both ends
+                stress+=0.5*computeFarFieldTerms(nodes[i],tree,
+                        vpsc::HORIZONTAL,NULL,gu,Huu,isTerm);
+            }
+        }
+    } else
     for(unsigned u=0;(u + 1)<n;u++) {
-        for(unsigned v=u+1;v<n;v++) {
-            unsigned short p=G[u][v];
+        const unsigned terms=D?n:stressTerms[u].size();
+        for(unsigned i=D?u+1:0;i<terms;i++) {
+            const unsigned v=D?i:stressTerms[u][i].v;
+            // each sparse term appears for both its nodes, count it once
+            if(v<=u) continue;
+            unsigned short p=D?G[u][v]:stressTerms[u][i].p;
             // no forces between disconnected parts of the graph
             if(p==0) continue;
             double rx=X[u]-X[v], ry=Y[u]-Y[v];
             double l=sqrt(rx*rx+ry*ry);
-            double d=D[u][v];
+            double d=D?D[u][v]:stressTerms[u][i].d;
             if(l>d && p>1) continue; // no attractive forces required
             double d2=d*d;
             double rl=d-l;
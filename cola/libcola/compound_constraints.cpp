@@ -464,6 +464,15 @@ unsigned SeparationConstraint::right(void) const
 }
 
 
+bool SeparationConstraint::separatesAlignments(void) const
+{
+    VarIndexPair *info =
+            static_cast<VarIndexPair *> (_subConstraintInfo.front());
+
+    return info->lConstraint != NULL;
+}
+
+
 void SeparationConstraint::setSeparation(double gap) 
 {
     this->gap = gap;
@@ -474,6 +483,31 @@ void SeparationConstraint::setSeparation(double gap)
 }
 
 
+std::list<unsigned> SeparationConstraint::shapeIndexes(void) const
+{
+    std::list<unsigned> idList;
+    if (!separatesAlignments())
+    {
+        idList.push_back(left());
+        idList.push_back(right());
+    }
+    return idList;
+}
+
+
+void SeparationConstraint::remapShapeIndexes(const std::vector<unsigned>& map)
+{
+    VarIndexPair *info =
+            static_cast<VarIndexPair *> (_subConstraintInfo.front());
+
+    if (!separatesAlignments())
+    {
+        info->varIndex = map[info->varIndex];
+        info->varIndex2 = map[info->varIndex2];
+    }
+}
+
+
 //-----------------------------------------------------------------------------
 // OrthogonalEdgeConstraint code
 //-----------------------------------------------------------------------------
@@ -498,6 +532,23 @@ void OrthogonalEdgeConstraint::generateVariables(const vpsc::Dim dim,
 }
 
 
+std::list<unsigned> OrthogonalEdgeConstraint::shapeIndexes(void) const
+{
+    std::list<unsigned> idList;
+    idList.push_back(left);
+    idList.push_back(right);
+    return idList;
+}
+
+
+void OrthogonalEdgeConstraint::remapShapeIndexes(
+        const std::vector<unsigned>& map)
+{
+    left = map[left];
+    right = map[right];
+}
+
+
 void OrthogonalEdgeConstraint::printCreationCode(FILE *fp) const
 {
     fprintf(fp, "    /* OrthogonalEdgeConstraint *orthogonal%llu = NULL; */\n\n",
@@ -693,6 +744,21 @@ void MultiSeparationConstraint::setSeparation(double sep)
 }
 
 
+// The alignment constraints separated are listed separately, with the 
+// shapes they align.
+std::list<unsigned> MultiSeparationConstraint::shapeIndexes(void) const
+{
+    return std::list<unsigned>();
+}
+
+
+void MultiSeparationConstraint::remapShapeIndexes(
+        const std::vector<unsigned>& map)
+{
+    COLA_UNUSED(map);
+}
+
+
 void MultiSeparationConstraint::generateSeparationConstraints(
         const vpsc::Dim dim, vpsc::Variables& vs, vpsc::Constraints& gcs,
         std::vector<vpsc::Rectangle*>& bbs) 
@@ -754,6 +820,21 @@ void DistributionConstraint::setSeparation(double sep)
 }
 
 
+// The alignment constraints distributed are listed separately, with the 
+// shapes they align.
+std::list<unsigned> DistributionConstraint::shapeIndexes(void) const
+{
+    return std::list<unsigned>();
+}
+
+
+void DistributionConstraint::remapShapeIndexes(
+        const std::vector<unsigned>& map)
+{
+    COLA_UNUSED(map);
+}
+
+
 void DistributionConstraint::printCreationCode(FILE *fp) const
 {
     fprintf(fp, "    DistributionConstraint *distribution%llu = "
@@ -918,6 +999,32 @@ void FixedRelativeConstraint::generateVariables(const vpsc::Dim dim,
 }
 
 
+std::list<unsigned> FixedRelativeConstraint::shapeIndexes(void) const
+{
+    return std::list<unsigned>(m_shape_vars.begin(), m_shape_vars.end());
+}
+
+
+void FixedRelativeConstraint::remapShapeIndexes(
+        const std::vector<unsigned>& map)
+{
+    std::set<unsigned> shapeVars;
+    for (std::set<unsigned>::iterator it = m_shape_vars.begin();
+            it != m_shape_vars.end(); ++it)
+    {
+        shapeVars.insert(map[*it]);
+    }
+    m_shape_vars.swap(shapeVars);
+    for (size_t i = 0; i < _subConstraintInfo.size(); ++i)
+    {
+        RelativeOffset *info = 
+                static_cast<RelativeOffset *> (_subConstraintInfo[i]);
+        info->varIndex = map[info->varIndex];
+        info->varIndex2 = map[info->varIndex2];
+    }
+}
+
+
 void FixedRelativeConstraint::printCreationCode(FILE *fp) const
 {
     fprintf(fp, "    std::set<unsigned> fixedRelativeSet%llu;\n",
@@ -1244,6 +1351,21 @@ std::list<unsigned> CompoundConstraint::subConstraintObjIndexes(void) const
 }
 
 
+std::list<unsigned> CompoundConstraint::shapeIndexes(void) const
+{
+    return subConstraintObjIndexes();
+}
+
+
+void CompoundConstraint::remapShapeIndexes(const std::vector<unsigned>& map)
+{
+    for (size_t i = 0; i < _subConstraintInfo.size(); ++i)
+    {
+        _subConstraintInfo[i]->varIndex = map[_subConstraintInfo[i]->varIndex];
+    }
+}
+
+
 bool CompoundConstraint::subConstraintsRemaining(void) const
 {
     return _currSubConstraintIndex < _subConstraintInfo.size();
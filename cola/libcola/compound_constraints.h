@@ -144,6 +144,16 @@ public:
     virtual SubConstraintAlternatives getCurrSubConstraintAlternatives(
             vpsc::Variables vs[]) = 0;
     std::list<unsigned> subConstraintObjIndexes(void) const;
+    /**
+     * Returns the indexes of the shapes whose positions this constraint
+     * applies to.
+     */
+    virtual std::list<unsigned> shapeIndexes(void) const;
+    /**
+     * Replaces each shape index i used by this constraint with map[i], 
+     * such as to apply it to a coarser graph for a multilevel layout.
+     */
+    virtual void remapShapeIndexes(const std::vector<unsigned>& map);
     virtual void printCreationCode(FILE *fp) const;
     bool shouldCombineSubConstraints(void) const;
 
@@ -277,8 +287,13 @@ class SeparationConstraint : public CompoundConstraint
                 vpsc::Variables& vs, vpsc::Constraints& cs,
                 std::vector<vpsc::Rectangle*>& bbs);
         void setSeparation(double gap);
+        std::list<unsigned> shapeIndexes(void) const;
+        void remapShapeIndexes(const std::vector<unsigned>& map);
         unsigned left(void) const;
         unsigned right(void) const;
+        // Whether this separates two alignment constraints, rather than
+        // the two nodes given by left() and right().
+        bool separatesAlignments(void) const;
         void printCreationCode(FILE *fp) const;
 
         double gap;
@@ -307,6 +322,8 @@ class OrthogonalEdgeConstraint : public CompoundConstraint
                 std::vector<vpsc::Rectangle*> const& rs, 
                 std::vector<vpsc::Variable*> const& vars, 
                 std::vector<vpsc::Constraint*>& cs);
+        std::list<unsigned> shapeIndexes(void) const;
+        void remapShapeIndexes(const std::vector<unsigned>& map);
         void printCreationCode(FILE *fp) const;
 
         unsigned left;
@@ -335,6 +352,8 @@ class MultiSeparationConstraint : public CompoundConstraint
                 vpsc::Variables& vs, vpsc::Constraints& gcs,
                 std::vector<vpsc::Rectangle*>& bbs);
         void setSeparation(double sep);
+        std::list<unsigned> shapeIndexes(void) const;
+        void remapShapeIndexes(const std::vector<unsigned>& map);
         void printCreationCode(FILE *fp) const;
 
         vpsc::Constraints cs;
@@ -361,6 +380,8 @@ class DistributionConstraint : public CompoundConstraint {
                 vpsc::Variables& vars, vpsc::Constraints& gcs,
                 std::vector<vpsc::Rectangle*>& bbs);
         void setSeparation(double sep);
+        std::list<unsigned> shapeIndexes(void) const;
+        void remapShapeIndexes(const std::vector<unsigned>& map);
         void printCreationCode(FILE *fp) const;
 
         vpsc::Constraints cs;
@@ -384,6 +405,8 @@ class FixedRelativeConstraint : public CompoundConstraint {
         void generateSeparationConstraints(const vpsc::Dim dim, 
                 vpsc::Variables& vars, vpsc::Constraints& gcs,
                 std::vector<vpsc::Rectangle*>& bbs);
+        std::list<unsigned> shapeIndexes(void) const;
+        void remapShapeIndexes(const std::vector<unsigned>& map);
         void printCreationCode(FILE *fp) const;
 
         bool m_fixed_position;
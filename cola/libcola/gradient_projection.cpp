@@ -73,6 +73,7 @@ GradientProjection::GradientProjection(
           tolerance(tol), 
           max_iterations(max_iterations),
           sparseQ(NULL),
+          solver(NULL),
           solveWithMosek(solveWithMosek),
           scaling(scaling)
 {
@@ -134,18 +135,47 @@ static inline double dotProd(valarray<double> const & a, valarray<double> const
     }
     return p;
 }
+// Rows of denseQ below this size are not worth sharing between threads.
+static const int minParallelDenseSize = 512;
+// Computes r = denseQ v, with zeros for any dummy variables beyond the 
+// dense part.  This is where nearly all of the time in solve() goes, so 
+// each row is summed into four independent accumulators, letting the 
+// compiler keep several multiply-adds in flight (and vectorise them) 
+// rather than waiting on a single running sum.  Each row only reads its 
+// own row of denseQ and all of v, which stays in cache, so large matrices
+// are split up by rows between threads.
+void GradientProjection::denseMultiply(
+        valarray<double> const &v, valarray<double> &r) const {
+    COLA_ASSERT(v.size()==r.size() && v.size()>=denseSize);
+    const int n = static_cast<int>(denseSize);
+    const unsigned blockEnd = denseSize - denseSize % 4;
+#pragma omp parallel for if (n >= minParallelDenseSize)
+    for (int i=0; i<n; i++) {
+        const double *q = &(*denseQ)[i*denseSize];
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        unsigned j=0;
+        for (; j<blockEnd; j+=4) {
+            s0 += q[j]*v[j];
+            s1 += q[j+1]*v[j+1];
+            s2 += q[j+2]*v[j+2];
+            s3 += q[j+3]*v[j+3];
+        }
+        for (; j<denseSize; j++) {
+            s0 += q[j]*v[j];
+        }
+        r[i] = (s0+s1)+(s2+s3);
+    }
+    for (unsigned i=denseSize; i<r.size(); i++) {
+        r[i] = 0;
+    }
+}
 double GradientProjection::computeCost(
         valarray<double> const &b,
         valarray<double> const &x) const {
     // computes cost = 2 b x - x A x
     double cost = 2. * dotProd(b,x);
     valarray<double> Ax(x.size());
-    for (unsigned i=0; i<denseSize; i++) {
-        Ax[i] = 0;
-        for (unsigned j=0; j<denseSize; j++) {
-            Ax[i] += (*denseQ)[i*denseSize+j]*x[j];
-        }
-    }
+    denseMultiply(x,Ax);
     if(sparseQ) {
         valarray<double> r(x.size());
         sparseQ->rightMultiply(x,r);
@@ -157,6 +187,7 @@ double GradientProjection::computeCost(
 double GradientProjection::computeSteepestDescentVector(
         valarray<double> const &b,
         valarray<double> const &x,
+        valarray<double> const &Qx,
         valarray<double> &g) const {
     // find steepest descent direction
     //  g = 2 ( b - A x )
@@ -166,39 +197,32 @@ double GradientProjection::computeSteepestDescentVector(
     //  except the 2s don't matter because we compute 
     //  the optimal stepsize anyway
     COLA_ASSERT(x.size()==b.size() && b.size()==g.size());
-    g = b;
-    for (unsigned i=0; i<denseSize; i++) {
-        for (unsigned j=0; j<denseSize; j++) {
-            g[i] -= (*denseQ)[i*denseSize+j]*x[j];
-        }
-    }
+    COLA_ASSERT(Qx.size()==x.size());
+    g = b - Qx;
     // sparse part:
     if(sparseQ) {
         valarray<double> r(x.size());
         sparseQ->rightMultiply(x,r);
         g-=r;
     }
-    return computeStepSize(g,g);
+    valarray<double> Qg(g.size());
+    return computeStepSize(g,g,Qg);
 }
 // compute optimal step size along descent vector d relative to
 // a gradient related vector g 
 //    stepsize = ( g' d ) / ( d' A d )
+// The dense part of A d is left in Qd for the caller.
 double GradientProjection::computeStepSize(
-        valarray<double> const & g, valarray<double> const & d) const {
-    COLA_ASSERT(g.size()==d.size());
-    valarray<double> Ad;
+        valarray<double> const & g, valarray<double> const & d,
+        valarray<double> & Qd) const {
+    COLA_ASSERT(g.size()==d.size() && d.size()==Qd.size());
+    denseMultiply(d,Qd);
+    double const numerator = dotProd(g, d);
+    double denominator = dotProd(Qd, d);
     if(sparseQ) {
-        Ad.resize(g.size());
+        valarray<double> Ad(g.size());
         sparseQ->rightMultiply(d,Ad);
-    }
-    double const numerator = dotProd(g, d);
-    double denominator = 0;
-    for (unsigned i=0; i<g.size(); i++) {
-        double r = sparseQ ? Ad[i] : 0;
-        if(i<denseSize) { for (unsigned j=0; j<denseSize; j++) {
-            r += (*denseQ)[i*denseSize+j] * d[j];
-        } }
-        denominator += r * d[i];
+        denominator += dotProd(Ad, d);
     }
     if(denominator==0) {
         return 0;
@@ -296,6 +320,9 @@ unsigned GradientProjection::solve(
     valarray<double> g(n); /* gradient */
     valarray<double> previous(n); /* stored positions */
     valarray<double> d(n); /* actual descent vector */
+    valarray<double> Qx(n); /* denseQ result */
+    valarray<double> Qd(n); /* denseQ d */
+    bool QxCurrent=false;
 
 #ifdef CHECK_CONVERGENCE_BY_COST
     double previousCost = DBL_MAX;
@@ -305,7 +332,10 @@ unsigned GradientProjection::solve(
     for (; counter<max_iterations&&!converged; counter++) {
         previous=result;
         stepSize=0;
-        double alpha=computeSteepestDescentVector(b,result,g);
+        if(!QxCurrent) {
+            denseMultiply(result,Qx);
+        }
+        double alpha=computeSteepestDescentVector(b,result,Qx,g);
 
         //printf("Iteration[%d]\n",counter);
         // move to new unconstrained position
@@ -329,13 +359,14 @@ unsigned GradientProjection::solve(
             double step = previous[i]-result[i];
             stepSize+=step*step;
         }
+        QxCurrent=false;
         //constrainedOptimum=false;
         // beta seems, more often than not, to be >1!
         if(constrainedOptimum) {
             // The following step limits the step-size in the feasible
             // direction
             d = result - previous;
-            const double beta = 0.5*computeStepSize(g, d);
+            const double beta = 0.5*computeStepSize(g, d, Qd);
             // beta > 1.0 takes us back outside the feasible region
             // beta < 0 clearly not useful and may happen due to numerical imp.
             //printf("beta=%f\n",beta);
@@ -346,7 +377,13 @@ unsigned GradientProjection::solve(
                     result[i]=previous[i]+step;
                     stepSize+=step*step;
                 }
+                Qd*=beta;
             }
+            // Qx held denseQ previous, so moving along d also gives us
+            // denseQ result for the next iteration without another pass
+            // over denseQ.
+            Qx+=Qd;
+            QxCurrent=true;
         }
 #ifdef CHECK_CONVERGENCE_BY_COST
         /* This would be the slow way to detect convergence */
@@ -379,7 +416,13 @@ unsigned GradientProjection::solve(
 // --- that are only relevant to one iteration, and merge these with the
 // global constraint list (including alignment constraints,
 // dir-edge constraints, containment constraints, etc).
+// If there are no such transient constraints the solver from the previous
+// call is returned, with the blocks it finished with, so that only desired
+// positions change and satisfy() starts from the last active set.
 IncSolver* GradientProjection::setupVPSC() {
+    if(solver && !transientConstraints()) {
+        return solver;
+    }
     if(nonOverlapConstraints!=None) {
         if(clusterHierarchy) {
             //printf("Setup up cluster constraints, dim=%d--------------\n",k);
@@ -430,7 +473,14 @@ IncSolver* GradientProjection::setupVPSC() {
     }
     return new IncSolver(vars,cs);
 }
+// True if the constraints change from one call to solve() to the next, 
+// so that the solver has to be rebuilt each time.
+bool GradientProjection::transientConstraints() const {
+    return (nonOverlapConstraints!=None && !clusterHierarchy) || sparseQ ||
+        solveWithMosek!=Off;
+}
 void GradientProjection::destroyVPSC(IncSolver *vpsc) {
+    const bool keepSolver = !transientConstraints();
     if(ccs) {
         for(CompoundConstraints::const_iterator c=ccs->begin(); 
                 c!=ccs->end();++c) {
@@ -462,7 +512,12 @@ void GradientProjection::destroyVPSC(IncSolver *vpsc) {
         delete *i;
     }
     lcs.clear();
-    delete vpsc;
+    if(keepSolver) {
+        solver=vpsc;
+    } else {
+        delete vpsc;
+        solver=NULL;
+    }
 #ifdef MOSEK_AVAILABLE
     if(solveWithMosek!=Off) mosek_delete(menv);
 #endif
@@ -474,6 +529,9 @@ void GradientProjection::straighten(
 {
     COLA_ASSERT(Q->rowSize()==snodes.size());
     COLA_ASSERT(vars.size()==numStaticVars);
+    // the dummy vars and their constraints need a new solver
+    delete solver;
+    solver=NULL;
     sparseQ = Q;
     for(unsigned i=numStaticVars;i<snodes.size();i++) {
         Variable* v=new vpsc::Variable(i,snodes[i]->pos[k],1);
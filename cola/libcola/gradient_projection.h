@@ -91,7 +91,7 @@ public:
         return numStaticVars;
     }
     ~GradientProjection() {
-        //destroyVPSC(solver);
+        delete solver;
         for(vpsc::Constraints::iterator i(gcs.begin()); i!=gcs.end(); i++) {
             delete *i;
         }
@@ -126,15 +126,20 @@ private:
     vpsc::IncSolver* setupVPSC();
     double computeCost(std::valarray<double> const &b,
         std::valarray<double> const &x) const;
+    void denseMultiply(std::valarray<double> const &v,
+        std::valarray<double> &r) const;
     double computeSteepestDescentVector(
         std::valarray<double> const &b, std::valarray<double> const &place,
+        std::valarray<double> const &Qplace,
         std::valarray<double> &g) const;
     double computeScaledSteepestDescentVector(
         std::valarray<double> const &b, std::valarray<double> const &place,
         std::valarray<double> &g) const;
     double computeStepSize(
-        std::valarray<double> const & g, std::valarray<double> const & d) const;
+        std::valarray<double> const & g, std::valarray<double> const & d,
+        std::valarray<double> & Qd) const;
     bool runSolver(std::valarray<double> & result);
+    bool transientConstraints() const;
     void destroyVPSC(vpsc::IncSolver *vpsc);
     vpsc::Dim k;
     unsigned numStaticVars; // number of variables that persist
@@ -160,7 +165,8 @@ private:
 #ifdef MOSEK_AVAILABLE
     MosekEnv* menv;
 #endif
-    vpsc::IncSolver* solver;
+    vpsc::IncSolver* solver; // kept between calls to solve() unless 
+                             // transientConstraints()
     SolveWithMosek solveWithMosek;
     const bool scaling;
     std::vector<OrthogonalEdgeConstraint*> orthogonalEdges;
@@ -0,0 +1,119 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+#include <algorithm>
+#include <cfloat>
+
+#include "libvpsc/assertions.h"
+#include "quadtree.h"
+
+namespace cola {
+
+// Cells with this many nodes or fewer aren't split.
+static const unsigned maxLeafSize = 8;
+// Stops unbounded splitting when many nodes share a position.
+static const unsigned maxDepth = 32;
+
+QuadTree::QuadTree(const std::valarray<double>& X,
+        const std::valarray<double>& Y, const std::vector<unsigned>& ns)
+    : X(X), Y(Y)
+{
+    COLA_ASSERT(X.size()==Y.size());
+    cells.push_back(Cell());
+    Cell& root=cells[0];
+    root.minX=root.minY=DBL_MAX;
+    root.maxX=root.maxY=-DBL_MAX;
+    std::vector<unsigned> nodes(ns);
+    for(unsigned i=0;i<nodes.size();i++) {
+        const unsigned v=nodes[i];
+        COLA_ASSERT(v<X.size());
+        root.minX=std::min(root.minX,X[v]);
+        root.maxX=std::max(root.maxX,X[v]);
+        root.minY=std::min(root.minY,Y[v]);
+        root.maxY=std::max(root.maxY,Y[v]);
+    }
+    if(nodes.empty()) {
+        root.minX=root.minY=root.maxX=root.maxY=0;
+    }
+    // Make the root square so that cells don't become long and thin.
+    double size=root.size();
+    root.maxX=root.minX+size;
+    root.maxY=root.minY+size;
+    build(0,nodes,0);
+}
+
+void QuadTree::build(const unsigned c, std::vector<unsigned>& nodes,
+        const unsigned depth)
+{
+    Cell& cell=cells[c];
+    std::fill(cell.children,cell.children+4,0);
+    cell.count=nodes.size();
+    cell.cx=cell.cy=0;
+    for(unsigned i=0;i<nodes.size();i++) {
+        cell.cx+=X[nodes[i]];
+        cell.cy+=Y[nodes[i]];
+    }
+    cell.representative=nodes.empty()?0:nodes[0];
+    if(nodes.empty()) {
+        return;
+    }
+    cell.cx/=cell.count;
+    cell.cy/=cell.count;
+    double best=DBL_MAX;
+    for(unsigned i=0;i<nodes.size();i++) {
+        double dx=X[nodes[i]]-cell.cx, dy=Y[nodes[i]]-cell.cy;
+        if(dx*dx+dy*dy<best) {
+            best=dx*dx+dy*dy;
+            cell.representative=nodes[i];
+        }
+    }
+    if(nodes.size()<=maxLeafSize || depth==maxDepth || cell.size()==0) {
+        cell.nodes.swap(nodes);
+        return;
+    }
+
+    const double midX=(cell.minX+cell.maxX)/2, midY=(cell.minY+cell.maxY)/2;
+    std::vector<unsigned> quadrants[4];
+    for(unsigned i=0;i<nodes.size();i++) {
+        unsigned q=(X[nodes[i]]>midX?1:0)+(Y[nodes[i]]>midY?2:0);
+        quadrants[q].push_back(nodes[i]);
+    }
+    nodes.clear();
+    for(unsigned q=0;q<4;q++) {
+        Cell child;
+        child.minX=(q&1)?midX:cells[c].minX;
+        child.maxX=(q&1)?cells[c].maxX:midX;
+        child.minY=(q&2)?midY:cells[c].minY;
+        child.maxY=(q&2)?cells[c].maxY:midY;
+        child.openMinX=(q&1)?true:cells[c].openMinX;
+        child.openMinY=(q&2)?true:cells[c].openMinY;
+        // cells may be reallocated, so don't hold references over this
+        cells.push_back(child);
+        cells[c].children[q]=cells.size()-1;
+        build(cells.size()-1,quadrants[q],depth+1);
+    }
+}
+
+} // namespace cola
@@ -0,0 +1,94 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+#ifndef COLA_QUADTREE_H
+#define COLA_QUADTREE_H
+
+#include <vector>
+#include <valarray>
+#include <algorithm>
+
+namespace cola {
+
+/**
+ * A quadtree over a set of node positions, used to approximate the
+ * forces on a node from groups of distant nodes (Barnes-Hut).  Each cell
+ * records the number of nodes it contains, their centroid and a 
+ * representative node near the centroid.  A node on the boundary between
+ * two cells belongs to the lower one, so each cell's lower bounds are 
+ * open unless they are also the lower bounds of the root.
+ */
+class QuadTree {
+public:
+    struct Cell {
+        double minX, minY, maxX, maxY;
+        double cx, cy;
+        unsigned count;
+        unsigned representative;
+        // indexes of the child cells in cells, or 0 if this is a leaf
+        unsigned children[4];
+        // whether nodes at minX (minY) belong to the neighbouring cell
+        bool openMinX, openMinY;
+        // the nodes in a leaf cell
+        std::vector<unsigned> nodes;
+        Cell()
+            : minX(0), minY(0), maxX(0), maxY(0), cx(0), cy(0), count(0),
+              representative(0), openMinX(false), openMinY(false)
+        {
+            std::fill(children,children+4,0);
+        }
+        bool isLeaf() const {
+            return children[0]==0;
+        }
+        double size() const {
+            return std::max(maxX-minX,maxY-minY);
+        }
+        bool contains(const double x, const double y) const {
+            return x>=minX && x<=maxX && y>=minY && y<=maxY;
+        }
+        //! whether a node at (x,y) is one of this cell's nodes
+        bool containsNode(const double x, const double y) const {
+            return (openMinX?x>minX:x>=minX) && x<=maxX
+                && (openMinY?y>minY:y>=minY) && y<=maxY;
+        }
+    };
+    /**
+     * @param X,Y   node positions
+     * @param nodes the nodes to put in the tree
+     */
+    QuadTree(const std::valarray<double>& X, const std::valarray<double>& Y,
+            const std::vector<unsigned>& nodes);
+    //! the root cell is cells[0]
+    std::vector<Cell> cells;
+private:
+    void build(const unsigned c, std::vector<unsigned>& nodes,
+            const unsigned depth);
+    const std::valarray<double>& X;
+    const std::valarray<double>& Y;
+};
+
+} // namespace cola
+
+#endif // COLA_QUADTREE_H
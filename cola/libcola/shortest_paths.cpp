@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <functional>
 
 #include "commondefs.h"
 #include <libvpsc/pairing_heap.h>
@@ -151,6 +152,82 @@ void dijkstra(
     dijkstra(s,vs,d);
 }
 
+// Adjacency lists of all nodes stored in three flat arrays (compressed
+// sparse row form): the neighbours of u are targets[offsets[u]] to 
+// targets[offsets[u+1]-1], with the edge lengths in the same positions of
+// weights.
+template <typename T>
+struct CSRGraph {
+    CSRGraph(unsigned const n, vector<Edge> const & es, 
+            valarray<T> const * eweights)
+        : offsets(n+1,0),
+          targets(2*es.size()),
+          weights(2*es.size())
+    {
+        COLA_ASSERT(!eweights||eweights->size()==es.size());
+        for(unsigned i=0;i<es.size();i++) {
+            COLA_ASSERT(es[i].first<n);
+            COLA_ASSERT(es[i].second<n);
+            offsets[es[i].first+1]++;
+            offsets[es[i].second+1]++;
+        }
+        for(unsigned i=0;i<n;i++) {
+            offsets[i+1]+=offsets[i];
+        }
+        vector<unsigned> next(offsets.begin(),offsets.end()-1);
+        for(unsigned i=0;i<es.size();i++) {
+            unsigned u=es[i].first, v=es[i].second;
+            T w=eweights?(*eweights)[i]:1;
+            targets[next[u]]=v;
+            weights[next[u]++]=w;
+            targets[next[v]]=u;
+            weights[next[v]++]=w;
+        }
+    }
+    vector<unsigned> offsets;
+    vector<unsigned> targets;
+    vector<T> weights;
+};
+// Dijkstra's algorithm over a CSRGraph, using a binary heap with lazy 
+// deletion held in Q, which is only passed in so that its storage can be
+// reused from one call to the next.
+template <typename T>
+void dijkstra(
+        unsigned const s,
+        unsigned const n,
+        CSRGraph<T> const & g,
+        T* d,
+        vector<pair<T,unsigned> > & Q)
+{
+    COLA_ASSERT(s<n);
+    greater<pair<T,unsigned> > cmp;
+    for(unsigned i=0;i<n;i++) {
+        d[i]=numeric_limits<T>::max();
+    }
+    d[s]=0;
+    Q.clear();
+    Q.push_back(make_pair(d[s],s));
+    while(!Q.empty()) {
+        pop_heap(Q.begin(),Q.end(),cmp);
+        T du=Q.back().first;
+        unsigned u=Q.back().second;
+        Q.pop_back();
+        if(du>d[u]) continue; // stale entry, u was already settled
+        for(unsigned i=g.offsets[u];i<g.offsets[u+1];i++) {
+            unsigned v=g.targets[i];
+            T dv=du+g.weights[i];
+            if(dv<d[v]) {
+                d[v]=dv;
+                Q.push_back(make_pair(dv,v));
+                push_heap(Q.begin(),Q.end(),cmp);
+            }
+        }
+    }
+}
+
+// Runs Dijkstra's algorithm from every node.  The sources are shared out 
+// between threads (if OpenMP is enabled), each with its own heap, and 
+// each writes only to its own rows of D.
 template <typename T>
 void johnsons(
         unsigned const n,
@@ -158,10 +235,15 @@ void johnsons(
         vector<Edge> const & es,
         valarray<T> const * eweights) 
 {
-    vector<Node<T> > vs(n);
-    dijkstra_init(vs,es,eweights);
-    for(unsigned k=0;k<n;k++) {
-        dijkstra(k,vs,D[k]);
+    const CSRGraph<T> g(n,es,eweights);
+    const int N=n;
+#pragma omp parallel
+    {
+        vector<pair<T,unsigned> > Q;
+#pragma omp for schedule(dynamic,16)
+        for(int k=0;k<N;k++) {
+            dijkstra(k,n,g,D[k],Q);
+        }
     }
 }
 }
@@ -41,28 +41,57 @@
 #define _SPARSE_MATRIX_H
 
 #include <valarray>
+#include <vector>
 #include <map>
+#include <algorithm>
 #include <cstdio>
 
 #include "libvpsc/assertions.h"
 
 namespace cola {
+/**
+ * Assembles a sparse n×n matrix, such as the Hessian built by 
+ * ConstrainedFDLayout::computeForces() at every iteration.  The entries
+ * are held in lookup, and assemble() records where each is found in a
+ * compressed row sparsity pattern, so that refilling a matrix with the
+ * same (or a similar) structure each iteration finds existing entries 
+ * without searching the whole map or allocating new ones.
+ *
+ * A reference returned by operator() stays valid until the entry is 
+ * dropped, which happens if it is zero when assemble() is next called,
+ * or until clear().
+ */
 struct SparseMap {
-    SparseMap(unsigned n = 0) : n(n) {};
+    SparseMap(unsigned n = 0) : n(n), IA(n+1,0) {};
     unsigned n;
     typedef std::pair<unsigned, unsigned> SparseIndex;
     typedef std::map<SparseIndex,double> SparseLookup;
     typedef SparseLookup::const_iterator ConstIt;
+    /**
+     * Every entry of the matrix.  Deprecated: set entries with operator()
+     * instead.  Entries may be added here directly, but must not be 
+     * erased other than by clear().
+     */
     SparseLookup lookup;
     double& operator[](const SparseIndex& k) {
-        return lookup[k];
+        return (*this)(k.first,k.second);
     }
     double& operator()(const unsigned i, const unsigned j) {
+        COLA_ASSERT(i<n);
+        COLA_ASSERT(j<n);
+        int k=find(i,j);
+        if(k>=0) {
+            return *values[k];
+        }
         return lookup[std::make_pair(i,j)]; 
     }
     double getIJ(const unsigned i, const unsigned j) const {
         COLA_ASSERT(i<n);
         COLA_ASSERT(j<n);
+        int k=find(i,j);
+        if(k>=0) {
+            return *values[k];
+        }
         ConstIt v=lookup.find(std::make_pair(i,j));
         if(v!=lookup.end()) {
             return v->second;
@@ -74,10 +103,79 @@ struct SparseMap {
     }
     void resize(unsigned n) {
         this->n = n;
+        clearPattern();
     }
     void clear() {
         lookup.clear();
+        clearPattern();
     }
+    /**
+     * Sets every entry to zero.  Entries that are still zero at the next
+     * assemble() are then dropped, and the rest keep their place in the
+     * sparsity pattern.
+     */
+    void clearValues() {
+        assemble();
+        for(unsigned k=0;k<values.size();k++) {
+            *values[k]=0;
+        }
+    }
+    /**
+     * Drops zero entries, and brings the sparsity pattern up to date with
+     * any entries added or dropped since the last call.
+     */
+    void assemble() {
+        if(values.size()==lookup.size()) {
+            unsigned k=0;
+            while(k<values.size() && *values[k]!=0) {
+                k++;
+            }
+            if(k==values.size()) return;
+        }
+        for(SparseLookup::iterator e=lookup.begin();e!=lookup.end();) {
+            if(e->second==0) {
+                lookup.erase(e++);
+            } else {
+                ++e;
+            }
+        }
+        // The lookup is ordered by row and then column, as is the pattern.
+        clearPattern();
+        JA.reserve(lookup.size());
+        values.reserve(lookup.size());
+        for(SparseLookup::iterator e=lookup.begin();e!=lookup.end();++e) {
+            IA[e->first.first+1]++;
+            JA.push_back(e->first.second);
+            values.push_back(&e->second);
+        }
+        for(unsigned i=0;i<n;i++) {
+            IA[i+1]+=IA[i];
+        }
+    }
+    unsigned rowSize() const {
+        return n;
+    }
+private:
+    // Returns the position in the pattern of entry (i,j), or -1 if it 
+    // isn't there.
+    int find(const unsigned i, const unsigned j) const {
+        std::vector<unsigned>::const_iterator begin=JA.begin()+IA[i],
+            end=JA.begin()+IA[i+1];
+        std::vector<unsigned>::const_iterator k=std::lower_bound(begin,end,j);
+        if(k!=end && *k==j) {
+            return k-JA.begin();
+        }
+        return -1;
+    }
+    void clearPattern() {
+        IA.assign(n+1,0);
+        JA.clear();
+        values.clear();
+    }
+    // The columns of the entries in row i are JA[IA[i]]..JA[IA[i+1]-1],
+    // in increasing order, and values points to each of them in lookup.
+    std::vector<unsigned> IA, JA;
+    std::vector<double*> values;
 };
 /**
  * Yale Sparse Matrix implementation (from Wikipedia definition).
@@ -92,7 +190,7 @@ struct SparseMap {
 class SparseMatrix {
 public:
     SparseMatrix(SparseMap const & m)
-            : n(m.n), NZ(m.nonZeroCount()), sparseMap(m), 
+            : n(m.n), NZ(m.nonZeroCount()), 
               A(std::valarray<double>(NZ)), IA(std::valarray<unsigned>(n+1)), JA(std::valarray<unsigned>(NZ)) {
         unsigned cnt=0;
         int lastrow=-1;
@@ -125,7 +223,14 @@ public:
         }
     }
     double getIJ(const unsigned i, const unsigned j) const {
-        return sparseMap.getIJ(i,j);
+        COLA_ASSERT(i<n);
+        COLA_ASSERT(j<n);
+        for(unsigned k=IA[i];k<IA[i+1];k++) {
+            if(JA[k]==j) {
+                return A[k];
+            }
+        }
+        return 0;
     }
     void print() const {
         for(unsigned i=0;i<n;i++) {
@@ -140,7 +245,6 @@ public:
     }
 private:
     const unsigned n,NZ;
-    SparseMap const & sparseMap;
     std::valarray<double> A;
     std::valarray<unsigned> IA, JA;
 };
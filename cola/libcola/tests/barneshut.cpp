@@ -0,0 +1,101 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file barneshut.cpp
+ *
+ * Lays out a grid graph with ConstrainedFDLayout, once computing all
+ * forces exactly and once with the Barnes-Hut approximation, from the same
+ * starting positions, and checks that the approximate layout is about as
+ * good as the exact one.  A few small components are added to the grid,
+ * more than there are pivots, so that some only get a pivot of their own
+ * because the approximation needs one in every component.
+ */
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include <libcola/cola.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 15;
+static const double idealLength = 40;
+static const unsigned pivots = 10;
+static const unsigned smallComponents = 12;
+
+static double layout(const vector<Edge>& es, 
+        const vector<pair<double,double> >& startPos, const double theta,
+        vector<vpsc::Rectangle*>& rs) {
+    for (unsigned i = 0; i < startPos.size(); ++i) {
+        double x = startPos[i].first, y = startPos[i].second;
+        rs.push_back(new vpsc::Rectangle(x, x + 5, y, y + 5));
+    }
+    clock_t start = clock();
+    ConstrainedFDLayout alg(rs, es, idealLength, false);
+    alg.setBarnesHut(theta, pivots);
+    alg.run();
+    printf("theta=%g: %.3fs\n", theta, 
+            (double) (clock() - start) / CLOCKS_PER_SEC);
+
+    // Measure the exact stress of the result.
+    ConstrainedFDLayout exact(rs, es, idealLength, false);
+    return exact.computeStress();
+}
+
+int main() {
+    srand(2);
+    const unsigned V = gridSize * gridSize + 2 * smallComponents;
+    vector<Edge> es;
+    for (unsigned i = 0; i < gridSize; ++i) {
+        for (unsigned j = 0; j < gridSize; ++j) {
+            unsigned u = i * gridSize + j;
+            if (j + 1 < gridSize) es.push_back(make_pair(u, u + 1));
+            if (i + 1 < gridSize) es.push_back(make_pair(u, u + gridSize));
+        }
+    }
+    for (unsigned i = gridSize * gridSize; i < V; i += 2) {
+        es.push_back(make_pair(i, i + 1));
+    }
+    vector<pair<double,double> > startPos;
+    for (unsigned i = 0; i < V; ++i) {
+        startPos.push_back(make_pair(600.0 * rand() / RAND_MAX, 
+                    600.0 * rand() / RAND_MAX));
+    }
+
+    vector<vpsc::Rectangle*> exactRs, approxRs;
+    double exactStress = layout(es, startPos, 0, exactRs);
+    double approxStress = layout(es, startPos, 0.5, approxRs);
+    printf("exact stress=%g, Barnes-Hut stress=%g\n", exactStress, 
+            approxStress);
+
+    for (unsigned i = 0; i < V; ++i) {
+        delete exactRs[i];
+        delete approxRs[i];
+    }
+    return (approxStress < 1.5 * exactStress + 1) ? 0 : 1;
+}
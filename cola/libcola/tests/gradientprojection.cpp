@@ -0,0 +1,147 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file gradientprojection.cpp
+ *
+ * Solves a constrained quadratic problem repeatedly with one
+ * GradientProjection, which keeps its VPSC solver from one solve() to the
+ * next, fixing and unfixing the positions of different variables between
+ * solves.  After each solve the result is checked against that of a
+ * GradientProjection built afresh with the same variables fixed.
+ */
+#include <vector>
+#include <valarray>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <libcola/cola.h>
+#include <libcola/gradient_projection.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned n = 30;
+
+// The variables fixed for a solve, and the positions they are fixed at.
+typedef vector<pair<unsigned, double> > FixedPositions;
+
+static double getRand(const double range) {
+    return range * rand() / RAND_MAX;
+}
+
+static unsigned solveOnce(GradientProjection& gp,
+        const FixedPositions& fixed, valarray<double> const & b,
+        valarray<double>& x) {
+    for (unsigned i = 0; i < fixed.size(); ++i) {
+        gp.fixPos(fixed[i].first, fixed[i].second);
+    }
+    return gp.solve(b, x);
+}
+
+int main() {
+    srand(5);
+    // The Laplacian of a chain of the variables, with a small diagonal
+    // term to make the problem strictly convex.
+    valarray<double> Q(0.0, n * n);
+    for (unsigned i = 0; i < n; ++i) {
+        Q[i * n + i] += 0.1;
+        if (i > 0) {
+            Q[i * n + i] += 1;
+            Q[(i - 1) * n + (i - 1)] += 1;
+            Q[i * n + (i - 1)] -= 1;
+            Q[(i - 1) * n + i] -= 1;
+        }
+    }
+    valarray<double> b(n);
+    for (unsigned i = 0; i < n; ++i) {
+        b[i] = getRand(20) - 10;
+    }
+
+    // Separation constraints between random pairs of variables, always
+    // from the lower to the higher index so that they are satisfiable.
+    CompoundConstraints ccs;
+    for (unsigned c = 0; c < 2 * n; ++c) {
+        unsigned l = rand() % n, r = rand() % n;
+        if (l >= r) continue;
+        ccs.push_back(new SeparationConstraint(vpsc::XDIM, l, r,
+                    getRand(10)));
+    }
+    vpsc::Rectangles rs;
+    for (unsigned i = 0; i < n; ++i) {
+        rs.push_back(new vpsc::Rectangle(0, 1, 0, 1));
+    }
+
+    // Both projections are run to a tight tolerance, so that they reach
+    // the same solution however their iterations differ.
+    GradientProjection reused(vpsc::HORIZONTAL, &Q, 1e-7, 1000, &ccs,
+            NULL, None, NULL, &rs);
+    valarray<double> x(n);
+    for (unsigned i = 0; i < n; ++i) {
+        x[i] = getRand(100);
+    }
+
+    int failures = 0;
+    FixedPositions fixed;
+    for (unsigned round = 0; round < 10; ++round) {
+        // Unfix some of the variables fixed last round, and fix others.
+        FixedPositions stillFixed;
+        for (unsigned i = 0; i < fixed.size(); ++i) {
+            if (rand() % 2) {
+                reused.unfixPos(fixed[i].first);
+            } else {
+                stillFixed.push_back(fixed[i]);
+            }
+        }
+        fixed = stillFixed;
+        for (unsigned f = 0; f < 3; ++f) {
+            fixed.push_back(make_pair(rand() % n, getRand(100)));
+        }
+
+        valarray<double> start = x;
+        solveOnce(reused, fixed, b, x);
+
+        GradientProjection fresh(vpsc::HORIZONTAL, &Q, 1e-7, 1000, &ccs,
+                NULL, None, NULL, &rs);
+        valarray<double> expected = start;
+        solveOnce(fresh, fixed, b, expected);
+
+        for (unsigned i = 0; i < n; ++i) {
+            if (fabs(x[i] - expected[i]) > 0.001) {
+                printf("Round %u: x[%u] is %g with the reused solver, "
+                        "%g with a new one\n", round, i, x[i], expected[i]);
+                ++failures;
+            }
+        }
+    }
+
+    for (unsigned c = 0; c < ccs.size(); ++c) {
+        delete ccs[c];
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        delete rs[i];
+    }
+    return (failures == 0) ? 0 : 1;
+}
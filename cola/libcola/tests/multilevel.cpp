@@ -0,0 +1,194 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file multilevel.cpp
+ *
+ * Lays out a grid graph with ConstrainedFDLayout from random starting
+ * positions, once directly and once using the multilevel scheme to find
+ * starting positions, and checks that the multilevel layout is at least as
+ * good and takes fewer iterations at the finest level.  Also checks that
+ * the coarse levels are laid out at the scale of the ideal edge length,
+ * and that constraints and clusters survive being mapped to coarse levels.
+ */
+#include <vector>
+#include <list>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include <libcola/cola.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 20;
+static const double idealLength = 40;
+
+static double layout(const vector<Edge>& es, 
+        const vector<pair<double,double> >& startPos, const bool multilevel,
+        unsigned& iterations) {
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < startPos.size(); ++i) {
+        double x = startPos[i].first, y = startPos[i].second;
+        rs.push_back(new vpsc::Rectangle(x, x + 5, y, y + 5));
+    }
+    // Keep the two ends of the grid's first row apart.
+    CompoundConstraints ccs;
+    ccs.push_back(new SeparationConstraint(vpsc::HORIZONTAL, 0, 
+                gridSize - 1, 200));
+
+    clock_t start = clock();
+    TestConvergence done(1e-4, 200);
+    ConstrainedFDLayout alg(rs, es, idealLength, false, NULL, done);
+    alg.setConstraints(ccs);
+    if (multilevel) {
+        alg.setMultilevel(20);
+    }
+    alg.run();
+    iterations = done.iterations;
+    printf("multilevel=%d: %u iterations at finest level, %.3fs\n", 
+            multilevel, iterations, (double) (clock() - start) / CLOCKS_PER_SEC);
+
+    // Measure the stress of the result, without the constraint.
+    ConstrainedFDLayout exact(rs, es, idealLength, false);
+    double stress = exact.computeStress();
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        delete rs[i];
+    }
+    delete ccs[0];
+    return stress;
+}
+
+// Returns the mean edge length when the finest level is stopped after a 
+// single iteration, so the positions are still those found for the coarse
+// levels.  Coarse edges also span half of each merged pair at their ends,
+// so this is somewhat more than the ideal length.
+static double startingEdgeLength(const vector<Edge>& es, 
+        const vector<pair<double,double> >& startPos) {
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < startPos.size(); ++i) {
+        double x = startPos[i].first, y = startPos[i].second;
+        rs.push_back(new vpsc::Rectangle(x, x + 5, y, y + 5));
+    }
+    TestConvergence done(1e-4, 1);
+    ConstrainedFDLayout alg(rs, es, idealLength, false, NULL, done);
+    alg.setMultilevel(20);
+    alg.run();
+    double total = 0;
+    for (unsigned i = 0; i < es.size(); ++i) {
+        vpsc::Rectangle *u = rs[es[i].first], *v = rs[es[i].second];
+        double dx = u->getCentreX() - v->getCentreX();
+        double dy = u->getCentreY() - v->getCentreY();
+        total += sqrt(dx * dx + dy * dy);
+    }
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        delete rs[i];
+    }
+    return total / es.size();
+}
+
+// Lays out the grid with the multilevel scheme, an alignment of nodes on
+// the grid's diagonal and a cluster around a corner of the grid, and 
+// returns whether the alignment holds and still refers to the same nodes.
+static bool alignedLayout(const vector<Edge>& es, 
+        const vector<pair<double,double> >& startPos) {
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < startPos.size(); ++i) {
+        double x = startPos[i].first, y = startPos[i].second;
+        rs.push_back(new vpsc::Rectangle(x, x + 5, y, y + 5));
+    }
+    AlignmentConstraint *align = new AlignmentConstraint(vpsc::XDIM);
+    for (unsigned i = 0; i < 4; ++i) {
+        align->addShape(i * (gridSize + 1), 0);
+    }
+    CompoundConstraints ccs;
+    ccs.push_back(align);
+    RootCluster *root = new RootCluster();
+    RectangularCluster *corner = new RectangularCluster();
+    for (unsigned i = 0; i < 3; ++i) {
+        for (unsigned j = 0; j < 3; ++j) {
+            corner->addChildNode(i * gridSize + j);
+        }
+    }
+    root->addChildCluster(corner);
+
+    TestConvergence done(1e-4, 200);
+    ConstrainedFDLayout alg(rs, es, idealLength, false, NULL, done);
+    alg.setConstraints(ccs);
+    alg.setClusterHierarchy(root);
+    alg.setMultilevel(20);
+    alg.run();
+
+    bool ok = true;
+    list<unsigned> ids = align->subConstraintObjIndexes();
+    unsigned k = 0;
+    for (list<unsigned>::iterator i = ids.begin(); i != ids.end(); ++i, ++k) {
+        if (*i != k * (gridSize + 1) || 
+                fabs(rs[*i]->getCentreX() - rs[0]->getCentreX()) > 0.01) {
+            printf("alignment broken at node %u\n", *i);
+            ok = false;
+        }
+    }
+    for (unsigned i = 0; i < rs.size(); ++i) {
+        delete rs[i];
+    }
+    delete align;
+    delete root;
+    return ok;
+}
+
+int main() {
+    srand(3);
+    const unsigned V = gridSize * gridSize;
+    vector<Edge> es;
+    for (unsigned i = 0; i < gridSize; ++i) {
+        for (unsigned j = 0; j < gridSize; ++j) {
+            unsigned u = i * gridSize + j;
+            if (j + 1 < gridSize) es.push_back(make_pair(u, u + 1));
+            if (i + 1 < gridSize) es.push_back(make_pair(u, u + gridSize));
+        }
+    }
+    vector<pair<double,double> > startPos;
+    for (unsigned i = 0; i < V; ++i) {
+        startPos.push_back(make_pair(800.0 * rand() / RAND_MAX, 
+                    800.0 * rand() / RAND_MAX));
+    }
+
+    unsigned directIterations, multilevelIterations;
+    double directStress = layout(es, startPos, false, directIterations);
+    double multilevelStress = layout(es, startPos, true, 
+            multilevelIterations);
+    printf("direct stress=%g, multilevel stress=%g\n", directStress, 
+            multilevelStress);
+    double startLength = startingEdgeLength(es, startPos);
+    printf("mean edge length from coarse levels=%g\n", startLength);
+    bool aligned = alignedLayout(es, startPos);
+
+    return (multilevelStress < 1.1 * directStress + 1 && 
+            multilevelIterations < directIterations &&
+            startLength > 0.5 * idealLength && 
+            startLength < 2 * idealLength && aligned) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file nonoverlap.cpp
+ *
+ * Removes overlap between many randomly placed, heavily overlapping
+ * rectangles with ConstrainedFDLayout::makeFeasible(), with and without
+ * a cluster, and checks that no two rectangles at the top level of the
+ * hierarchy still overlap.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <libcola/cola.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned V = 300;
+
+static int removeOverlaps(bool withCluster) {
+    srand(3);
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < V; ++i) {
+        double x = 400.0 * rand() / RAND_MAX, y = 400.0 * rand() / RAND_MAX;
+        double w = 5 + 35.0 * rand() / RAND_MAX;
+        double h = 5 + 35.0 * rand() / RAND_MAX;
+        rs.push_back(new vpsc::Rectangle(x, x + w, y, y + h));
+    }
+    vector<Edge> es;
+    for (unsigned i = 1; i < V; ++i) {
+        es.push_back(make_pair(i - 1, i));
+    }
+
+    // The first few rectangles are placed in a cluster, so only the
+    // remaining ones are made not to overlap with each other.
+    unsigned firstTopLevel = 0;
+    ConstrainedFDLayout alg(rs, es, 30, true);
+    if (withCluster) {
+        RootCluster *root = new RootCluster();
+        RectangularCluster *cluster = new RectangularCluster();
+        firstTopLevel = 10;
+        for (unsigned i = 0; i < firstTopLevel; ++i) {
+            cluster->addChildNode(i);
+        }
+        root->addChildCluster(cluster);
+        for (unsigned i = firstTopLevel; i < V; ++i) {
+            root->addChildNode(i);
+        }
+        alg.setClusterHierarchy(root);
+    }
+    alg.makeFeasible();
+
+    int overlaps = 0;
+    for (unsigned i = firstTopLevel; i < V; ++i) {
+        for (unsigned j = i + 1; j < V; ++j) {
+            if ((rs[i]->overlapX(rs[j]) > 0.0001) &&
+                    (rs[i]->overlapY(rs[j]) > 0.0001)) {
+                printf("Rectangles %u and %u overlap.\n", i, j);
+                ++overlaps;
+            }
+        }
+    }
+    alg.freeAssociatedObjects();
+    return overlaps;
+}
+
+int main() {
+    int failures = removeOverlaps(false) + removeOverlaps(true);
+    return (failures == 0) ? 0 : 1;
+}
@@ -63,18 +63,17 @@ static double getRunTime() {
     clock_t time = clock()-lastTime;
     return (double)time/(double)CLOCKS_PER_SEC;
 }
-#ifdef __DONT_COMPILE
 int
 main()
 {
     bool dump=false;
-    srand(time(0));
+    srand(1);
 #ifdef TEST_AGAINST_BOOST
     typedef adjacency_list<vecS, vecS, undirectedS, no_property,
       property< edge_weight_t, double, property< edge_weight2_t, double > > > Graph;
     Graph g;
 #endif
-    unsigned V = 100;
+    unsigned V = 300;
     vector<shortest_paths::Edge> es = random_graph(V);
     unsigned E=es.size();
     cout << "  Test graph |V|="<<V<<",|E|="<<E<<endl;
@@ -111,12 +110,15 @@ main()
     resetClock();
     shortest_paths::floyd_warshall(V,D2,es,&weights);
     cout<<"  ...done, time="<<getRunTime()<<endl;
+    double* d3=new double[V];
 
-    for (int i = 0; i < V; ++i) {
+    for (unsigned i = 0; i < V; ++i) {
+        shortest_paths::dijkstra(i,V,d3,es,&weights);
         if(dump) cout << i << " -> ";
-        for (int j = 0; j < V; ++j) {
+        for (unsigned j = 0; j < V; ++j) {
 	        if(dump) cout << setw(5) << D1[i][j];
 	        assert(D1[i][j]==D2[i][j]);
+	        assert(D1[i][j]==d3[j]);
 #ifdef TEST_AGAINST_BOOST
 	        assert(D[i][j]==D2[i][j]);
 #endif
@@ -138,4 +140,3 @@ main()
 #endif
     return 0;
 }
-#endif // __DONT_COMPILE
@@ -0,0 +1,124 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file sparsemap.cpp
+ *
+ * Fills a SparseMap several times with random entries, clearing its values
+ * in between, and checks entries and matrix-vector products against a 
+ * dense matrix, that entries left at zero are dropped, and that a 
+ * SparseMatrix doesn't change when its SparseMap is refilled.
+ */
+#include <vector>
+#include <valarray>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <libcola/sparse_matrix.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned n = 40;
+
+static int checkAgainstDense(const SparseMap& m, 
+        const vector<vector<double> >& dense) {
+    int failures = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            if (m.getIJ(i, j) != dense[i][j]) {
+                printf("Entry (%u,%u) is %g, expected %g\n", i, j, 
+                        m.getIJ(i, j), dense[i][j]);
+                ++failures;
+            }
+        }
+    }
+    valarray<double> v(n), r(n);
+    for (unsigned i = 0; i < n; ++i) {
+        v[i] = (double) rand() / RAND_MAX;
+    }
+    SparseMatrix H(m);
+    H.rightMultiply(v, r);
+    for (unsigned i = 0; i < n; ++i) {
+        double expected = 0;
+        for (unsigned j = 0; j < n; ++j) {
+            expected += dense[i][j] * v[j];
+        }
+        if (fabs(r[i] - expected) > 1e-9) {
+            printf("Row %u of product is %g, expected %g\n", i, r[i], 
+                    expected);
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    srand(1);
+    SparseMap m(n);
+    int failures = 0;
+    for (unsigned round = 0; round < 6; ++round) {
+        vector<vector<double> > dense(n, vector<double>(n, 0));
+        m.clearValues();
+        // Later rounds mostly reuse entries from earlier ones.
+        unsigned entries = (round == 0) ? 200 : 60;
+        for (unsigned e = 0; e < entries; ++e) {
+            unsigned i = rand() % n, j = (round == 0) ? rand() % n : 
+                    (i + rand() % 5) % n;
+            double value = (double) rand() / RAND_MAX - 0.5;
+            m(i, j) += value;
+            dense[i][j] += value;
+            if (e % 7 == 0) {
+                m(i, i) = value;
+                dense[i][i] = value;
+            }
+        }
+        failures += checkAgainstDense(m, dense);
+        m.assemble();
+        failures += checkAgainstDense(m, dense);
+        unsigned nonZeros = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            for (unsigned j = 0; j < n; ++j) {
+                nonZeros += (dense[i][j] != 0);
+            }
+        }
+        if (m.nonZeroCount() != nonZeros) {
+            printf("Map holds %u entries, expected %u\n", 
+                    m.nonZeroCount(), nonZeros);
+            ++failures;
+        }
+    }
+
+    // A SparseMatrix keeps its own copy of the entries.
+    SparseMatrix H(m);
+    const double before = H.getIJ(1, 2);
+    m(1, 2) += 1;
+    m.clearValues();
+    if (H.getIJ(1, 2) != before) {
+        printf("SparseMatrix changed with its SparseMap\n");
+        ++failures;
+    }
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libcola - A library providing force-directed network layout using the 
+ *           stress-majorization method subject to separation constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not, 
+ * write to the Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+/** \file sparsestress.cpp
+ *
+ * Lays out a grid graph with ConstrainedFDLayout using the sparse stress 
+ * model, together with a cluster and a separation constraint, and checks
+ * that the constraint holds and edges end up near their ideal length.
+ */
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <libcola/cola.h>
+
+using namespace std;
+using namespace cola;
+
+static const unsigned gridSize = 12;
+static const double idealLength = 40;
+
+int main() {
+    srand(1);
+    const unsigned V = gridSize * gridSize;
+    vector<Edge> es;
+    for (unsigned i = 0; i < gridSize; ++i) {
+        for (unsigned j = 0; j < gridSize; ++j) {
+            unsigned u = i * gridSize + j;
+            if (j + 1 < gridSize) es.push_back(make_pair(u, u + 1));
+            if (i + 1 < gridSize) es.push_back(make_pair(u, u + gridSize));
+        }
+    }
+    vector<vpsc::Rectangle*> rs;
+    for (unsigned i = 0; i < V; ++i) {
+        double x = 500.0 * rand() / RAND_MAX, y = 500.0 * rand() / RAND_MAX;
+        rs.push_back(new vpsc::Rectangle(x, x + 5, y, y + 5));
+    }
+
+    // The end nodes of the first row are kept well apart, and the nodes 
+    // in the top-left corner of the grid are placed in a cluster.
+    CompoundConstraints ccs;
+    ccs.push_back(new SeparationConstraint(vpsc::XDIM, 0, gridSize - 1, 
+                300));
+    RootCluster *root = new RootCluster();
+    RectangularCluster *cluster = new RectangularCluster();
+    for (unsigned i = 0; i < 3; ++i) {
+        for (unsigned j = 0; j < 3; ++j) {
+            cluster->addChildNode(i * gridSize + j);
+        }
+    }
+    root->addChildCluster(cluster);
+
+    ConstrainedFDLayout alg(rs, es, idealLength, true);
+    alg.setSparseStress(10, 2);
+    alg.setConstraints(ccs);
+    alg.setClusterHierarchy(root);
+    alg.run();
+    double stress = alg.computeStress();
+
+    int failures = 0;
+    double separation = rs[gridSize - 1]->getCentreX() - rs[0]->getCentreX();
+    if (separation < 300 - 0.001) {
+        printf("Separation constraint not satisfied: %g\n", separation);
+        ++failures;
+    }
+    double totalLength = 0;
+    for (unsigned i = 0; i < es.size(); ++i) {
+        double dx = rs[es[i].first]->getCentreX() - 
+                rs[es[i].second]->getCentreX();
+        double dy = rs[es[i].first]->getCentreY() - 
+                rs[es[i].second]->getCentreY();
+        totalLength += sqrt(dx * dx + dy * dy);
+    }
+    double meanLength = totalLength / es.size();
+    printf("stress=%g, mean edge length=%g\n", stress, meanLength);
+    if (!(meanLength > 0.5 * idealLength && meanLength < 2 * idealLength)) {
+        printf("Mean edge length too far from ideal.\n");
+        ++failures;
+    }
+
+    alg.freeAssociatedObjects();
+    return (failures == 0) ? 0 : 1;
+}
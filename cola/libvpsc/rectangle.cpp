@@ -209,7 +209,6 @@ struct Event {
     double pos;
     Event(EventType t, Node *v, double p) : type(t),v(v),pos(p) {};
 };
-Event **events;
 int compare_events(const void *a, const void *b) {
     Event *ea=*(Event**)a;
     Event *eb=*(Event**)b;
@@ -239,7 +238,7 @@ int compare_events(const void *a, const void *b) {
 void generateXConstraints(vector<Rectangle*> const & rs, vector<Variable*> const &vars, vector<Constraint*> &cs, const bool useNeighbourLists) {
     const unsigned n = rs.size();
     COLA_ASSERT(vars.size()>=n);
-    events=new Event*[2*n];
+    Event **events=new Event*[2*n];
     unsigned i,ctr=0;
     for(i=0;i<n;i++) {
         vars[i]->desiredPosition=rs[i]->getCentreX();
@@ -326,7 +325,7 @@ void generateXConstraints(vector<Rectangle*> const & rs, vector<Variable*> const
 void generateYConstraints(const Rectangles& rs, const Variables& vars, Constraints& cs) {
     const unsigned n = rs.size();
     COLA_ASSERT(vars.size()>=n);
-    events=new Event*[2*n];
+    Event **events=new Event*[2*n];
     unsigned ctr=0;
     Rectangles::const_iterator ri=rs.begin(), re=rs.end();
     Variables::const_iterator vi=vars.begin(), ve=vars.end();
@@ -35,6 +35,7 @@
 #include <sstream>
 #include <map>
 #include <cfloat>
+#include <algorithm>
 
 #include "constraint.h"
 #include "block.h"
@@ -55,8 +56,11 @@ namespace vpsc {
 static const double ZERO_UPPERBOUND=-1e-10;
 static const double LAGRANGIAN_TOLERANCE=-1e-4;
 
-IncSolver::IncSolver(vector<Variable*> const &vs, vector<Constraint *> const &cs) 
-    : Solver(vs,cs) {
+IncSolver::IncSolver(vector<Variable*> const &vs, vector<Constraint *> const &cs,
+        const bool violationHeap) 
+    : Solver(vs,cs),
+      useViolationHeap(violationHeap),
+      maxViolationHeapSize(0) {
     inactive=cs;
     for(Constraints::iterator i=inactive.begin();i!=inactive.end();++i) {
         (*i)->active=false;
@@ -231,6 +235,9 @@ bool IncSolver::satisfy() {
     f<<"satisfy_inc()..."<<endl;
 #endif
     splitBlocks();
+    if(useViolationHeap) {
+        rebuildViolationHeap();
+    }
     //long splitCtr = 0;
     Constraint* v = NULL;
     //CBuffer buffer(inactive);
@@ -240,7 +247,10 @@ bool IncSolver::satisfy() {
         COLA_ASSERT(!v->active);
         Block *lb = v->left->block, *rb = v->right->block;
         if(lb != rb) {
-            lb->merge(rb,v);
+            Block *mb = lb->merge(rb,v);
+            if(useViolationHeap) {
+                queueBlockConstraints(mb==lb?rb:lb);
+            }
         } else {
             if(lb->isActiveDirectedPathBetween(v->right,v->left)) {
                 // cycle found, relax the violated, cyclic constraint
@@ -284,11 +294,24 @@ bool IncSolver::satisfy() {
                 inactive.push_back(v);
                 bs->insert(lb);
                 bs->insert(rb);
+                if(useViolationHeap) {
+                    queueBlockConstraints(
+                            lb->vars->size()<rb->vars->size()?lb:rb);
+                }
             } else {
-                bs->insert(lb->merge(rb,v));
+                Block *mb = lb->merge(rb,v);
+                bs->insert(mb);
+                if(useViolationHeap) {
+                    queueBlockConstraints(mb==lb?rb:lb);
+                }
             }
         }
-        bs->cleanup();
+        if(!useViolationHeap) {
+            // With the heap, the work for each merge is proportional to the
+            // size of the blocks involved rather than the number of blocks,
+            // so deleted blocks are swept up once below, not after each one.
+            bs->cleanup();
+        }
 #ifdef LIBVPSC_LOGGING
         f<<"...remaining blocks="<<bs->size()<<", cost="<<bs->cost()<<endl;
 #endif
@@ -296,6 +319,11 @@ bool IncSolver::satisfy() {
 #ifdef LIBVPSC_LOGGING
     f<<"  finished merges."<<endl;
 #endif
+    if(useViolationHeap) {
+        // the heap stands in for the inactive list, which is not needed
+        violationHeap.clear();
+        inactive.clear();
+    }
     bs->cleanup();
     bool activeConstraints=false;
     for(unsigned i=0;i<m;i++) {
@@ -318,6 +346,102 @@ bool IncSolver::satisfy() {
     copyResult();
     return activeConstraints;
 }
+/**
+ * Adds a constraint between two of the solver's variables.  It is initially
+ * inactive and will be satisfied by the next call to satisfy() or solve().
+ */
+void IncSolver::addConstraint(Constraint *c) {
+    c->active=false;
+    c->left->out.push_back(c);
+    c->right->in.push_back(c);
+    cs.push_back(c);
+    m=cs.size();
+    inactive.push_back(c);
+}
+static void removeFromConstraints(Constraints &l, Constraint *c) {
+    Constraints::iterator i=find(l.begin(),l.end(),c);
+    if(i!=l.end()) {
+        *i=l.back();
+        l.pop_back();
+    }
+}
+/**
+ * Removes a constraint from the solver.  If it was active, the block 
+ * containing it is split across it.  Constraints that are not in the
+ * solver are ignored.
+ */
+void IncSolver::removeConstraint(Constraint *c) {
+    Constraints::iterator i=find(cs.begin(),cs.end(),c);
+    COLA_ASSERT(i!=cs.end());
+    if(i==cs.end()) {
+        return;
+    }
+    if(c->active) {
+        Block *b=c->left->block, *l=NULL, *r=NULL;
+        COLA_ASSERT(b==c->right->block);
+        b->split(l,r,c);
+        bs->insert(l);
+        bs->insert(r);
+        b->deleted=true;
+        bs->cleanup();
+    } else {
+        removeFromConstraints(inactive,c);
+    }
+    removeFromConstraints(c->left->out,c);
+    removeFromConstraints(c->right->in,c);
+    cs.erase(i);
+    m=cs.size();
+}
+/**
+ * Records the current constraints and the active constraints that define
+ * the block structure, so that a later call to rollback() can restore them.
+ */
+void IncSolver::checkpoint() {
+    checkpointConstraints=cs;
+    checkpointActive.clear();
+    for(unsigned i=0;i<m;i++) {
+        if(cs[i]->active) {
+            checkpointActive.push_back(cs[i]);
+        }
+    }
+}
+/**
+ * Restores the constraints and block structure recorded by the last call to
+ * checkpoint().  The blocks are rebuilt by merging across the constraints
+ * that were active at that point, which also returns each block, and so
+ * each variable, to the position it had.
+ */
+void IncSolver::rollback() {
+    cs=checkpointConstraints;
+    m=cs.size();
+    for(unsigned i=0;i<n;++i) {
+        vs[i]->in.clear();
+        vs[i]->out.clear();
+    }
+    for(unsigned i=0;i<m;++i) {
+        Constraint *c=cs[i];
+        c->active=false;
+        c->left->out.push_back(c);
+        c->right->in.push_back(c);
+    }
+    delete bs;
+    bs=new Blocks(vs);
+    for(Constraints::iterator i=checkpointActive.begin();
+            i!=checkpointActive.end();++i) {
+        Constraint *c=*i;
+        Block *lb=c->left->block, *rb=c->right->block;
+        COLA_ASSERT(lb!=rb);
+        lb->merge(rb,c);
+    }
+    bs->cleanup();
+    inactive.clear();
+    for(unsigned i=0;i<m;++i) {
+        if(!cs[i]->active) {
+            inactive.push_back(cs[i]);
+        }
+    }
+    copyResult();
+}
 void IncSolver::moveBlocks() {
 #ifdef LIBVPSC_LOGGING
     ofstream f(LOGFILE,ios::app);
@@ -379,6 +503,9 @@ void IncSolver::splitBlocks() {
  * constraint
  */
 Constraint* IncSolver::mostViolated(Constraints &l) {
+    if(useViolationHeap) {
+        return mostViolatedFromHeap();
+    }
     double minSlack = DBL_MAX;
     Constraint* v=NULL;
 #ifdef LIBVPSC_LOGGING
@@ -413,6 +540,94 @@ Constraint* IncSolver::mostViolated(Constraints &l) {
     return v;
 }
 
+static bool greaterSlack(pair<double,Constraint*> const &a,
+        pair<double,Constraint*> const &b) {
+    return a.first > b.first;
+}
+/**
+ * Fills the heap with an entry for every constraint that is neither active
+ * nor unsatisfiable, keyed by its current slack.  Equality constraints
+ * always come first.
+ * @return true if any of them are violated or equalities
+ */
+bool IncSolver::rebuildViolationHeap() {
+    violationHeap.clear();
+    bool violated=false;
+    for(unsigned i=0;i<m;i++) {
+        Constraint *c=cs[i];
+        if(!c->active && !c->unsatisfiable) {
+            double key=c->equality ? -DBL_MAX : c->slack();
+            violated = violated || key < ZERO_UPPERBOUND;
+            violationHeap.push_back(make_pair(key,c));
+        }
+    }
+    make_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+    maxViolationHeapSize=max(2*violationHeap.size(),(size_t)4*m);
+    return violated;
+}
+void IncSolver::queueViolation(Constraint *c) {
+    if(violationHeap.size()>=maxViolationHeapSize) {
+        // mostly entries for constraints that have since moved
+        rebuildViolationHeap();
+    }
+    violationHeap.push_back(
+            make_pair(c->equality ? -DBL_MAX : c->slack(), c));
+    push_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+}
+/**
+ * When two blocks are merged only the variables of the smaller one change
+ * position relative to the rest of the new block, and the constraints on
+ * them are the ones likely to have become violated.  So these are queued 
+ * again, with b the smaller block, while the constraints of the larger 
+ * block, which all moved by the same amount, are left to be refreshed 
+ * when they come to the top of the heap.  Likewise, after a split, b is
+ * the smaller of the two new blocks.
+ */
+void IncSolver::queueBlockConstraints(Block *b) {
+    for(vector<Variable*>::iterator i=b->vars->begin();i!=b->vars->end();++i) {
+        Variable *v=*i;
+        for(Constraints::iterator j=v->out.begin();j!=v->out.end();++j) {
+            if(!(*j)->active && !(*j)->unsatisfiable) {
+                queueViolation(*j);
+            }
+        }
+        for(Constraints::iterator j=v->in.begin();j!=v->in.end();++j) {
+            if(!(*j)->active && !(*j)->unsatisfiable) {
+                queueViolation(*j);
+            }
+        }
+    }
+}
+/**
+ * As mostViolated, but takes the constraint from the top of the heap.
+ * Entries whose slack has changed since they were queued are queued again
+ * with the new slack.  Since these may be anywhere in the heap, all of the
+ * constraints are checked again before reporting that none are violated.
+ */
+Constraint* IncSolver::mostViolatedFromHeap() {
+    do {
+        while(!violationHeap.empty()) {
+            Constraint *c=violationHeap.front().second;
+            const double key=violationHeap.front().first;
+            const bool stale=!c->active && !c->unsatisfiable &&
+                !c->equality && key != c->slack();
+            if(!c->active && !c->unsatisfiable && !stale && 
+                    !c->equality && key >= ZERO_UPPERBOUND) {
+                // the least slack of all is fine
+                break;
+            }
+            pop_heap(violationHeap.begin(),violationHeap.end(),greaterSlack);
+            violationHeap.pop_back();
+            if(stale) {
+                queueViolation(c);
+            } else if(!c->active && !c->unsatisfiable) {
+                return c;
+            }
+        }
+    } while(rebuildViolationHeap());
+    return NULL;
+}
+
 struct node {
     set<node*> in;
     set<node*> out;
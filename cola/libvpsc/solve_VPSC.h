@@ -43,6 +43,7 @@
 #define SEEN_LIBVPSC_SOLVE_VPSC_H
 
 #include <vector>
+#include <utility>
 #include "exceptions.h"
 
 /**
@@ -52,6 +53,7 @@
 namespace vpsc {
 class Variable;
 class Constraint;
+class Block;
 class Blocks;
 typedef std::vector<Constraint*> Constraints;
 
@@ -75,7 +77,7 @@ public:
 protected:
 	Blocks *bs;
 	unsigned m;
-	std::vector<Constraint*> const &cs;
+	Constraints cs;
 	unsigned n;
 	std::vector<Variable*> const &vs;
 	void printBlocks();
@@ -93,11 +95,39 @@ public:
 	bool solve();
 	void moveBlocks();
 	void splitBlocks();
-	IncSolver(std::vector<Variable*> const &vs, std::vector<Constraint*> const &cs);
+	// If violationHeap is set, satisfy() finds the most violated 
+	// constraint with a heap of inactive constraints keyed by slack, 
+	// rather than scanning all of them each time round.  This is much
+	// faster when there are many constraints.
+	IncSolver(std::vector<Variable*> const &vs, std::vector<Constraint*> const &cs,
+			const bool violationHeap=false);
+	// The following methods allow constraints to be added and removed
+	// between calls to satisfy() or solve(), keeping the block structure
+	// found so far rather than constructing a new solver.  The caller 
+	// remains responsible for deleting the constraints.
+	void addConstraint(Constraint *c);
+	void removeConstraint(Constraint *c);
+	// checkpoint records the current constraints and block structure, 
+	// and rollback returns the solver and variable positions to them, 
+	// e.g., after adding a constraint that turned out to be unsatisfiable.
+	void checkpoint();
+	void rollback();
 private:
 	Constraints inactive;
 	Constraints violated;
 	Constraint* mostViolated(Constraints &l);
+	// Heap of (slack, constraint) entries for inactive constraints.  
+	// Entries are not updated in place when blocks move, see 
+	// queueBlockConstraints and mostViolatedFromHeap.
+	const bool useViolationHeap;
+	std::vector<std::pair<double,Constraint*> > violationHeap;
+	size_t maxViolationHeapSize;
+	bool rebuildViolationHeap();
+	void queueViolation(Constraint *c);
+	void queueBlockConstraints(Block *b);
+	Constraint* mostViolatedFromHeap();
+	Constraints checkpointConstraints;
+	Constraints checkpointActive;
 };
 }
 #endif // SEEN_LIBVPSC_SOLVE_VPSC_H
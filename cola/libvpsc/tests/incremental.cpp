@@ -0,0 +1,115 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libvpsc - A solver for the problem of Variable Placement with
+ *           Separation Constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+// Adds random constraints to a single IncSolver one at a time, rolling
+// some of them back and later removing others, and checks that the
+// constraints held by the solver are always satisfied, that rollback
+// restores the previous positions, and that the final solution is as good
+// as that found by a new solver with the same constraints.
+
+#include <libvpsc/variable.h>
+#include <libvpsc/constraint.h>
+#include <libvpsc/solve_VPSC.h>
+#include "testutils.h"
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+using namespace vpsc;
+
+int main() {
+	srand(1);
+	const unsigned n=100;
+	Variables vs;
+	for(unsigned i=0;i<n;i++) {
+		vs.push_back(new Variable(i,getRand(100),1));
+	}
+	Constraints all;
+	for(unsigned c=0;c<3*n;c++) {
+		unsigned l=(unsigned)getRand(n-1);
+		unsigned r=l+1+(unsigned)getRand(n-1-l);
+		all.push_back(new Constraint(vs[l],vs[r],getRand(5)));
+	}
+
+	Constraints held;
+	IncSolver s(vs,held);
+	for(unsigned c=0;c<all.size();c++) {
+		vector<double> prior(n);
+		for(unsigned i=0;i<n;i++) {
+			prior[i]=vs[i]->finalPosition;
+		}
+		s.checkpoint();
+		s.addConstraint(all[c]);
+		s.satisfy();
+		if(c%7==3) {
+			s.rollback();
+			for(unsigned i=0;i<n;i++) {
+				if(fabs(vs[i]->finalPosition-prior[i])>1e-6) {
+					printf("Rollback moved variable %u from %g to %g\n",
+							i,prior[i],vs[i]->finalPosition);
+					return 1;
+				}
+			}
+			continue;
+		}
+		held.push_back(all[c]);
+		if(!allSatisfied(held)) {
+			return 1;
+		}
+	}
+
+	// Remove every fifth constraint, active or not.
+	Constraints kept;
+	for(unsigned c=0;c<held.size();c++) {
+		if(c%5==0) {
+			s.removeConstraint(held[c]);
+		} else {
+			kept.push_back(held[c]);
+		}
+	}
+	s.solve();
+	if(!allSatisfied(kept)) {
+		return 1;
+	}
+	double incCost=cost(vs);
+
+	IncSolver fresh(vs,kept);
+	fresh.solve();
+	double freshCost=cost(vs);
+	printf("cost incremental=%g, fresh=%g\n",incCost,freshCost);
+	if(incCost>freshCost*1.001+0.0001) {
+		return 1;
+	}
+
+	for(unsigned i=0;i<all.size();i++) {
+		delete all[i];
+	}
+	for(unsigned i=0;i<n;i++) {
+		delete vs[i];
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libvpsc - A solver for the problem of Variable Placement with
+ *           Separation Constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+// Times IncSolver::solve() on random problems of increasing size, finding
+// the most violated constraint both by scanning the inactive constraints
+// and with the violation heap, and checks that both satisfy all of the
+// constraints at about the same cost.  Pass a number of constraints to
+// time a single problem of that size, e.g., 100000.
+
+#include <libvpsc/variable.h>
+#include <libvpsc/constraint.h>
+#include <libvpsc/solve_VPSC.h>
+#include "testutils.h"
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cmath>
+
+using namespace std;
+using namespace vpsc;
+
+// Solves a problem with m constraints between m/4 variables, each
+// between nearby variables.  The variables are roughly in order with
+// some overlap, as when removing overlap between shapes, so blocks stay 
+// of a similar size as the problem grows.  Returns the cost of the
+// solution or -1 if a constraint was left unsatisfied.
+static double solveRandom(const unsigned m, const bool violationHeap) {
+	srand(m);
+	const unsigned n=m/4;
+	Variables vs;
+	for(unsigned i=0;i<n;i++) {
+		vs.push_back(new Variable(i,2*i+getRand(20),1));
+	}
+	Constraints cs;
+	for(unsigned i=0;i<m;i++) {
+		unsigned l=(unsigned)getRand(n-1);
+		unsigned r=l+1+(unsigned)getRand(min(n-1-l,10u));
+		cs.push_back(new Constraint(vs[l],vs[r],getRand(3)));
+	}
+	clock_t start=clock();
+	IncSolver s(vs,cs,violationHeap);
+	s.solve();
+	double t=double(clock()-start)/CLOCKS_PER_SEC;
+	double c=allSatisfied(cs)?cost(vs):-1;
+	printf("  %u constraints, %s: %.2fs, cost %g\n",m,
+			violationHeap?"heap":"scan",t,c);
+	for(unsigned i=0;i<m;i++) {
+		delete cs[i];
+	}
+	for(unsigned i=0;i<n;i++) {
+		delete vs[i];
+	}
+	return c;
+}
+static bool compare(const unsigned m) {
+	double scanCost=solveRandom(m,false);
+	double heapCost=solveRandom(m,true);
+	if(scanCost<0 || heapCost<0) {
+		return false;
+	}
+	if(fabs(scanCost-heapCost)>0.001*scanCost+0.0001) {
+		printf("  costs differ\n");
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	if(argc>1) {
+		return compare(atoi(argv[1]))?0:1;
+	}
+	for(unsigned m=1000;m<=10000;m*=10) {
+		if(!compare(m)) {
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libvpsc - A solver for the problem of Variable Placement with
+ *           Separation Constraints.
+ *
+ * Copyright (C) 2026  Monash University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library in the file LICENSE; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307  USA
+ *
+*/
+
+// Helpers shared by the libvpsc solver tests.
+
+#ifndef SEEN_LIBVPSC_TESTS_TESTUTILS_H
+#define SEEN_LIBVPSC_TESTS_TESTUTILS_H
+
+#include <libvpsc/variable.h>
+#include <libvpsc/constraint.h>
+#include <cstdio>
+#include <cstdlib>
+
+// Returns a value in [0,range) from rand().
+static inline double getRand(const int range) {
+	return (double)range*rand()/(RAND_MAX+1.0);
+}
+// Returns whether every constraint is satisfied, printing the first that
+// is not.
+static inline bool allSatisfied(const vpsc::Constraints& cs) {
+	for(unsigned i=0;i<cs.size();i++) {
+		if(cs[i]->slack()<-0.0001) {
+			printf("Constraint %u has slack %g\n",i,cs[i]->slack());
+			return false;
+		}
+	}
+	return true;
+}
+// Returns the weighted squared distance of the variables from their
+// desired positions.
+static inline double cost(const vpsc::Variables& vs) {
+	double c=0;
+	for(unsigned i=0;i<vs.size();i++) {
+		double d=vs[i]->finalPosition-vs[i]->desiredPosition;
+		c+=vs[i]->weight*d*d;
+	}
+	return c;
+}
+
+#endif // SEEN_LIBVPSC_TESTS_TESTUTILS_H